@@ -0,0 +1,122 @@
+#include "BindlessTable.hpp"
+#include <algorithm>
+
+namespace Solarium
+{
+	BindlessTable::BindlessTable(SwapChain* swapChain_, Device* device_, uint32_t maxTextures_, uint32_t maxBuffers_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		maxTextures = maxTextures_;
+		maxBuffers = maxBuffers_;
+	}
+
+	BindlessTable::~BindlessTable()
+	{
+		cleanup();
+	}
+
+	void BindlessTable::createChain()
+	{
+		auto properties = device->physicalDevice().getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingProperties>();
+		const vk::PhysicalDeviceDescriptorIndexingProperties& limits = properties.get<vk::PhysicalDeviceDescriptorIndexingProperties>();
+		textureSlots.reset();
+		bufferSlots.reset();
+		// A combined image sampler counts against both the sampler and the sampled image limits
+		textureSlots.capacity = std::min({ maxTextures, limits.maxDescriptorSetUpdateAfterBindSampledImages, limits.maxDescriptorSetUpdateAfterBindSamplers,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages, limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+		bufferSlots.capacity = std::min({ maxBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers });
+
+		std::array<vk::DescriptorSetLayoutBinding, 2> bindings{
+			vk::DescriptorSetLayoutBinding{ TEXTURE_BINDING, vk::DescriptorType::eCombinedImageSampler, textureSlots.capacity, vk::ShaderStageFlagBits::eAll },
+			vk::DescriptorSetLayoutBinding{ BUFFER_BINDING, vk::DescriptorType::eStorageBuffer, bufferSlots.capacity, vk::ShaderStageFlagBits::eAll } };
+		vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+		std::array<vk::DescriptorBindingFlags, 2> flags{ bindingFlags, bindingFlags };
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{ flags };
+
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{ vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool, bindings };
+		layoutInfo.pNext = &bindingFlagsInfo;
+		descriptorSetLayout = device->device().createDescriptorSetLayout(layoutInfo);
+
+		std::array<vk::DescriptorPoolSize, 2> poolSizes{ vk::DescriptorPoolSize{ vk::DescriptorType::eCombinedImageSampler, textureSlots.capacity }, vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, bufferSlots.capacity } };
+		vk::DescriptorPoolCreateInfo poolInfo{ vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind, 1, poolSizes };
+		descriptorPool = device->device().createDescriptorPool(poolInfo);
+		if (!descriptorPool)
+		{
+			throw std::runtime_error("Failed to create bindless descriptor pool");
+		}
+
+		descriptorSet = device->device().allocateDescriptorSets(vk::DescriptorSetAllocateInfo{ descriptorPool, descriptorSetLayout })[0];
+		if (!descriptorSet)
+		{
+			throw std::runtime_error("Failed to allocate bindless descriptor set");
+		}
+	}
+
+	void BindlessTable::cleanup()
+	{
+		device->device().destroyDescriptorPool(descriptorPool);
+		device->device().destroyDescriptorSetLayout(descriptorSetLayout);
+		descriptorPool = nullptr;
+		descriptorSetLayout = nullptr;
+		descriptorSet = nullptr;
+		textureSlots.reset();
+		bufferSlots.reset();
+	}
+
+	uint32_t BindlessTable::addTexture(vk::ImageView imageView, vk::Sampler sampler)
+	{
+		uint32_t index = textureSlots.allocate();
+		vk::DescriptorImageInfo imageInfo{ sampler, imageView, vk::ImageLayout::eShaderReadOnlyOptimal };
+		device->device().updateDescriptorSets(vk::WriteDescriptorSet{ descriptorSet, TEXTURE_BINDING, index, vk::DescriptorType::eCombinedImageSampler, imageInfo }, nullptr);
+		return index;
+	}
+
+	uint32_t BindlessTable::addBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::DeviceSize range)
+	{
+		uint32_t index = bufferSlots.allocate();
+		vk::DescriptorBufferInfo bufferInfo{ buffer, offset, range };
+		device->device().updateDescriptorSets(vk::WriteDescriptorSet{ descriptorSet, BUFFER_BINDING, index, vk::DescriptorType::eStorageBuffer, nullptr, bufferInfo }, nullptr);
+		return index;
+	}
+
+	void BindlessTable::nextFrame()
+	{
+		frameCount++;
+		uint64_t latency = swapChain->imageCount() + SwapChain::MAX_FRAMES_IN_FLIGHT;
+		textureSlots.recycle(frameCount, latency);
+		bufferSlots.recycle(frameCount, latency);
+	}
+
+	uint32_t BindlessTable::SlotAllocator::allocate()
+	{
+		if (!freeSlots.empty())
+		{
+			uint32_t index = freeSlots.back();
+			freeSlots.pop_back();
+			return index;
+		}
+		if (next == capacity)
+		{
+			throw std::runtime_error("Bindless table is full");
+		}
+		return next++;
+	}
+
+	void BindlessTable::SlotAllocator::recycle(uint64_t frame, uint64_t latency)
+	{
+		auto expired = std::stable_partition(retiredSlots.begin(), retiredSlots.end(), [frame, latency](const RetiredSlot& slot) { return frame - slot.frame < latency; });
+		for (auto it = expired; it != retiredSlots.end(); it++)
+		{
+			freeSlots.push_back(it->index);
+		}
+		retiredSlots.erase(expired, retiredSlots.end());
+	}
+
+	void BindlessTable::SlotAllocator::reset()
+	{
+		next = 0;
+		freeSlots.clear();
+		retiredSlots.clear();
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+
+#include <vector>
+
+namespace Solarium
+{
+
+	// One global descriptor set holding every sampled texture and storage buffer in large, partially bound
+	// arrays. Shaders index the arrays directly, so draws with different materials share a single binding.
+	// Slots are written with update-after-bind and can change while earlier frames are still in flight.
+	class BindlessTable
+	{
+	public:
+		static constexpr uint32_t TEXTURE_BINDING = 0;
+		static constexpr uint32_t BUFFER_BINDING = 1;
+		static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+		// Capacities are clamped to the device's update-after-bind limits
+		BindlessTable(SwapChain* swapChain_, Device* device_, uint32_t maxTextures_ = 16384, uint32_t maxBuffers_ = 4096);
+		~BindlessTable();
+		BindlessTable(const BindlessTable&) = delete;
+		BindlessTable& operator=(const BindlessTable&) = delete;
+
+		// Creates an empty table; slots handed out before a cleanup are gone
+		void createChain();
+		void cleanup();
+		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
+
+		uint32_t addTexture(vk::ImageView imageView, vk::Sampler sampler);
+		uint32_t addBuffer(vk::Buffer buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+		// Removed slots are only reused once no frame in flight can still read them
+		void removeTexture(uint32_t index) { textureSlots.release(index, frameCount); }
+		void removeBuffer(uint32_t index) { bufferSlots.release(index, frameCount); }
+
+		// Advances the frame counter that decides when removed slots become free again
+		void nextFrame();
+
+		vk::DescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
+		vk::DescriptorSet getDescriptorSet() { return descriptorSet; }
+		uint32_t getTextureCapacity() { return textureSlots.capacity; }
+		uint32_t getBufferCapacity() { return bufferSlots.capacity; }
+
+	private:
+		struct SlotAllocator
+		{
+			struct RetiredSlot
+			{
+				uint32_t index;
+				uint64_t frame;
+			};
+
+			uint32_t capacity = 0;
+			uint32_t next = 0;
+			std::vector<uint32_t> freeSlots;
+			std::vector<RetiredSlot> retiredSlots;
+
+			uint32_t allocate();
+			void release(uint32_t index, uint64_t frame) { retiredSlots.push_back(RetiredSlot{ index, frame }); }
+			void recycle(uint64_t frame, uint64_t latency);
+			void reset();
+		};
+
+		Device* device;
+		SwapChain* swapChain;
+		uint32_t maxTextures;
+		uint32_t maxBuffers;
+		SlotAllocator textureSlots;
+		SlotAllocator bufferSlots;
+		uint64_t frameCount = 0;
+
+		vk::DescriptorSetLayout descriptorSetLayout;
+		vk::DescriptorPool descriptorPool;
+		vk::DescriptorSet descriptorSet;
+	};
+}
@@ -0,0 +1,272 @@
+#include "BlockCompression.hpp"
+
+#include <vulkan/vulkan_core.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace Solarium
+{
+
+	static uint16_t packRgb565(const float color[3])
+	{
+		int r = static_cast<int>(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		int g = static_cast<int>(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+		int b = static_cast<int>(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void unpackRgb565(uint16_t packed, int out[3])
+	{
+		int r = (packed >> 11) & 31;
+		int g = (packed >> 5) & 63;
+		int b = packed & 31;
+		out[0] = (r << 3) | (r >> 2);
+		out[1] = (g << 2) | (g >> 4);
+		out[2] = (b << 3) | (b >> 2);
+	}
+
+	size_t BlockCompression::compressedSize(BlockFormat format, uint32_t width, uint32_t height)
+	{
+		return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize(format);
+	}
+
+	uint32_t BlockCompression::vkFormat(BlockFormat format, bool srgb)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+		case BlockFormat::BC3:
+			return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+		case BlockFormat::BC5:
+			return VK_FORMAT_BC5_UNORM_BLOCK;
+		}
+		throw std::runtime_error("Unknown block format");
+	}
+
+	std::vector<uint32_t> BlockCompression::dataFormatDescriptor(BlockFormat format, bool srgb)
+	{
+		// Khronos Data Format values for the block compressed color models
+		const uint32_t MODEL_BC1A = 128, MODEL_BC3 = 130, MODEL_BC5 = 132;
+		const uint32_t PRIMARIES_BT709 = 1;
+		const uint32_t TRANSFER_LINEAR = 1, TRANSFER_SRGB = 2;
+		const uint32_t CHANNEL_COLOR = 0, CHANNEL_GREEN = 1, CHANNEL_ALPHA = 15;
+
+		struct Sample { uint32_t channel; uint32_t bitOffset; };
+		uint32_t model;
+		std::vector<Sample> samples;
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			model = MODEL_BC1A;
+			samples = { { CHANNEL_COLOR, 0 } };
+			break;
+		case BlockFormat::BC3:
+			model = MODEL_BC3;
+			samples = { { CHANNEL_ALPHA, 0 }, { CHANNEL_COLOR, 64 } };
+			break;
+		default:
+			model = MODEL_BC5;
+			samples = { { CHANNEL_COLOR, 0 }, { CHANNEL_GREEN, 64 } };
+			srgb = false;
+			break;
+		}
+
+		uint32_t blockBytes = static_cast<uint32_t>(24 + 16 * samples.size());
+		std::vector<uint32_t> dfd;
+		dfd.push_back(4 + blockBytes);                          // dfdTotalSize
+		dfd.push_back(0);                                       // vendorId and descriptorType: Khronos basic
+		dfd.push_back(2 | (blockBytes << 16));                  // versionNumber and descriptorBlockSize
+		dfd.push_back(model | (PRIMARIES_BT709 << 8) | ((srgb ? TRANSFER_SRGB : TRANSFER_LINEAR) << 16));
+		dfd.push_back(3 | (3 << 8));                            // 4x4x1x1 texel block, stored minus one
+		dfd.push_back(static_cast<uint32_t>(blockSize(format)));
+		dfd.push_back(0);
+		for (const Sample& sample : samples)
+		{
+			dfd.push_back(sample.bitOffset | (63 << 16) | (sample.channel << 24));
+			dfd.push_back(0);                                   // Sample position
+			dfd.push_back(0);                                   // sampleLower
+			dfd.push_back(UINT32_MAX);                          // sampleUpper
+		}
+		return dfd;
+	}
+
+	std::vector<uint8_t> BlockCompression::compress(const uint8_t* pixels, uint32_t width, uint32_t height, BlockFormat format)
+	{
+		std::vector<uint8_t> out(compressedSize(format, width, height));
+		uint8_t* block = out.data();
+		uint8_t texels[16][4];
+
+		for (uint32_t by = 0; by < height; by += 4)
+		{
+			for (uint32_t bx = 0; bx < width; bx += 4)
+			{
+				for (uint32_t i = 0; i < 16; i++)
+				{
+					uint32_t x = std::min(bx + i % 4, width - 1);
+					uint32_t y = std::min(by + i / 4, height - 1);
+					const uint8_t* texel = pixels + (static_cast<size_t>(y) * width + x) * 4;
+					std::copy(texel, texel + 4, texels[i]);
+				}
+
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					encodeColorBlock(texels, block);
+					break;
+				case BlockFormat::BC3:
+					encodeChannelBlock(texels, 3, block);
+					encodeColorBlock(texels, block + 8);
+					break;
+				case BlockFormat::BC5:
+					encodeChannelBlock(texels, 0, block);
+					encodeChannelBlock(texels, 1, block + 8);
+					break;
+				}
+				block += blockSize(format);
+			}
+		}
+		return out;
+	}
+
+	void BlockCompression::encodeColorBlock(const uint8_t texels[16][4], uint8_t* out)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				mean[c] += texels[i][c] / 16.0f;
+			}
+		}
+
+		// The principal axis of the block's colors is found with a few power iterations on the covariance
+		float covariance[6] = {};
+		for (int i = 0; i < 16; i++)
+		{
+			float r = texels[i][0] - mean[0], g = texels[i][1] - mean[1], b = texels[i][2] - mean[2];
+			covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+			covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+		}
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float x = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+			float y = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+			float z = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+			float length = std::max({ std::fabs(x), std::fabs(y), std::fabs(z) });
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+		}
+
+		float minProjection = 0.0f, maxProjection = 0.0f;
+		for (int i = 0; i < 16; i++)
+		{
+			float projection = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+		float axisLengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float high[3], low[3];
+		for (int c = 0; c < 3; c++)
+		{
+			high[c] = mean[c] + axis[c] * maxProjection / axisLengthSq;
+			low[c] = mean[c] + axis[c] * minProjection / axisLengthSq;
+		}
+
+		uint16_t color0 = packRgb565(high);
+		uint16_t color1 = packRgb565(low);
+		// Four color mode needs color0 > color1; equal endpoints simply select index 0 everywhere
+		if (color0 < color1)
+		{
+			std::swap(color0, color1);
+		}
+
+		int palette[4][3];
+		unpackRgb565(color0, palette[0]);
+		unpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int dr = texels[i][0] - palette[p][0], dg = texels[i][1] - palette[p][1], db = texels[i][2] - palette[p][2];
+					int error = dr * dr + dg * dg + db * db;
+					if (error < bestError)
+					{
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= static_cast<uint32_t>(best) << (i * 2);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(color0 & 0xFF);
+		out[1] = static_cast<uint8_t>(color0 >> 8);
+		out[2] = static_cast<uint8_t>(color1 & 0xFF);
+		out[3] = static_cast<uint8_t>(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+		{
+			out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+
+	void BlockCompression::encodeChannelBlock(const uint8_t texels[16][4], int channel, uint8_t* out)
+	{
+		int high = 0, low = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			high = std::max(high, static_cast<int>(texels[i][channel]));
+			low = std::min(low, static_cast<int>(texels[i][channel]));
+		}
+
+		// With endpoint0 > endpoint1 the block uses the eight value ramp
+		int palette[8] = { high, low };
+		for (int p = 2; p < 8; p++)
+		{
+			palette[p] = ((8 - p) * high + (p - 1) * low + 3) / 7;
+		}
+
+		uint64_t indices = 0;
+		if (high != low)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestError = INT32_MAX;
+				for (int p = 0; p < 8; p++)
+				{
+					int error = std::abs(texels[i][channel] - palette[p]);
+					if (error < bestError)
+					{
+						bestError = error;
+						best = p;
+					}
+				}
+				indices |= static_cast<uint64_t>(best) << (i * 3);
+			}
+		}
+
+		out[0] = static_cast<uint8_t>(high);
+		out[1] = static_cast<uint8_t>(low);
+		for (int i = 0; i < 6; i++)
+		{
+			out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+}
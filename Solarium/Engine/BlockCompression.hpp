@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Solarium
+{
+	enum class BlockFormat
+	{
+		BC1, // Opaque RGB, 8 bytes per block
+		BC3, // RGBA with interpolated alpha, 16 bytes per block
+		BC5  // Two independent channels (RG), 16 bytes per block, for normal maps
+	};
+
+	class BlockCompression
+	{
+	public:
+		static size_t blockSize(BlockFormat format) { return format == BlockFormat::BC1 ? 8 : 16; }
+		static size_t compressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+		// Matching VkFormat value, as stored in the KTX2 header
+		static uint32_t vkFormat(BlockFormat format, bool srgb);
+		// Basic data format descriptor block for the KTX2 container
+		static std::vector<uint32_t> dataFormatDescriptor(BlockFormat format, bool srgb);
+
+		// Compresses one RGBA8 image into 4x4 blocks in row-major order, clamping partial edge blocks
+		static std::vector<uint8_t> compress(const uint8_t* pixels, uint32_t width, uint32_t height, BlockFormat format);
+
+	private:
+		static void encodeColorBlock(const uint8_t texels[16][4], uint8_t* out);
+		static void encodeChannelBlock(const uint8_t texels[16][4], int channel, uint8_t* out);
+	};
+}
@@ -0,0 +1,529 @@
+#include "Bvh.hpp"
+#include "../Shaders/scene.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace Solarium
+{
+	static constexpr float MISS = std::numeric_limits<float>::max();
+
+	static float surfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax)
+	{
+		glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(0.0f));
+		return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+	}
+
+	static void primitiveBounds(const BvhPrimitive& primitive, glm::vec3& boundsMin, glm::vec3& boundsMax)
+	{
+		switch (primitive.type)
+		{
+		case BVH_SPHERE:
+			boundsMin = glm::vec3(primitive.shape[0]) - primitive.shape[0].w;
+			boundsMax = glm::vec3(primitive.shape[0]) + primitive.shape[0].w;
+			break;
+		case BVH_BOX:
+			boundsMin = glm::vec3(primitive.shape[0]);
+			boundsMax = glm::vec3(primitive.shape[1]);
+			break;
+		default:
+			boundsMin = glm::min(glm::min(glm::vec3(primitive.shape[0]), glm::vec3(primitive.shape[1])), glm::vec3(primitive.shape[2]));
+			boundsMax = glm::max(glm::max(glm::vec3(primitive.shape[0]), glm::vec3(primitive.shape[1])), glm::vec3(primitive.shape[2]));
+			break;
+		}
+	}
+
+	// ##### INTERSECTIONS #####
+	// The same tests as bvh.glsl; each returns MISS when nothing lies in front of the ray
+
+	static float intersectBounds(glm::vec3 boundsMin, glm::vec3 boundsMax, glm::vec3 origin, glm::vec3 inverseDirection, float maxDistance)
+	{
+		glm::vec3 t1 = (boundsMin - origin) * inverseDirection;
+		glm::vec3 t2 = (boundsMax - origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t1, t2);
+		glm::vec3 tFar = glm::max(t1, t2);
+		float nearest = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		float farthest = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+		return nearest <= farthest ? nearest : MISS;
+	}
+
+	static float intersectPrimitive(const BvhPrimitive& primitive, glm::vec3 origin, glm::vec3 direction, glm::vec3 inverseDirection)
+	{
+		switch (primitive.type)
+		{
+		case BVH_SPHERE:
+		{
+			glm::vec3 oc = origin - glm::vec3(primitive.shape[0]);
+			float b = glm::dot(oc, direction);
+			float h = b * b - glm::dot(oc, oc) + primitive.shape[0].w * primitive.shape[0].w;
+			if (h < 0.0f)
+			{
+				return MISS;
+			}
+			h = std::sqrt(h);
+			// The far side when the ray starts inside
+			float t = -b - h > 0.0f ? -b - h : -b + h;
+			return t > 0.0f ? t : MISS;
+		}
+		case BVH_BOX:
+		{
+			glm::vec3 t1 = (glm::vec3(primitive.shape[0]) - origin) * inverseDirection;
+			glm::vec3 t2 = (glm::vec3(primitive.shape[1]) - origin) * inverseDirection;
+			glm::vec3 tNear = glm::min(t1, t2);
+			glm::vec3 tFar = glm::max(t1, t2);
+			float nearest = std::max(std::max(tNear.x, tNear.y), tNear.z);
+			float farthest = std::min(std::min(tFar.x, tFar.y), tFar.z);
+			if (farthest < std::max(nearest, 0.0f))
+			{
+				return MISS;
+			}
+			float t = nearest > 0.0f ? nearest : farthest;
+			return t > 0.0f ? t : MISS;
+		}
+		default:
+		{
+			// Moller-Trumbore, from both sides
+			glm::vec3 edge1 = glm::vec3(primitive.shape[1]) - glm::vec3(primitive.shape[0]);
+			glm::vec3 edge2 = glm::vec3(primitive.shape[2]) - glm::vec3(primitive.shape[0]);
+			glm::vec3 p = glm::cross(direction, edge2);
+			float determinant = glm::dot(edge1, p);
+			if (std::fabs(determinant) < 1e-12f)
+			{
+				return MISS;
+			}
+			float inverseDeterminant = 1.0f / determinant;
+			glm::vec3 s = origin - glm::vec3(primitive.shape[0]);
+			float u = glm::dot(s, p) * inverseDeterminant;
+			glm::vec3 q = glm::cross(s, edge1);
+			float v = glm::dot(direction, q) * inverseDeterminant;
+			if (u < 0.0f || v < 0.0f || u + v > 1.0f)
+			{
+				return MISS;
+			}
+			float t = glm::dot(edge2, q) * inverseDeterminant;
+			return t > 0.0f ? t : MISS;
+		}
+		}
+	}
+
+	static glm::vec3 primitiveNormal(const BvhPrimitive& primitive, glm::vec3 position, glm::vec3 direction)
+	{
+		glm::vec3 normal;
+		switch (primitive.type)
+		{
+		case BVH_SPHERE:
+			normal = glm::normalize(position - glm::vec3(primitive.shape[0]));
+			break;
+		case BVH_BOX:
+		{
+			// The face whose axis the hit lies farthest along, relative to the half extents
+			glm::vec3 center = (glm::vec3(primitive.shape[0]) + glm::vec3(primitive.shape[1])) * 0.5f;
+			glm::vec3 local = (position - center) / (glm::vec3(primitive.shape[1]) - center);
+			glm::vec3 size = glm::abs(local);
+			int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+			normal = glm::vec3(0.0f);
+			normal[axis] = local[axis] < 0.0f ? -1.0f : 1.0f;
+			break;
+		}
+		default:
+			normal = glm::normalize(glm::cross(glm::vec3(primitive.shape[1]) - glm::vec3(primitive.shape[0]), glm::vec3(primitive.shape[2]) - glm::vec3(primitive.shape[0])));
+			break;
+		}
+		return glm::dot(normal, direction) > 0.0f ? -normal : normal;
+	}
+
+	// ##### BODIES #####
+
+	uint32_t Bvh::addBody(glm::vec3 position)
+	{
+		bodies.push_back({ position, false });
+		structureChanged = true;
+		return static_cast<uint32_t>(bodies.size() - 1);
+	}
+
+	void Bvh::addPrimitive(BvhPrimitiveType type, uint32_t body, glm::vec4 shape0, glm::vec4 shape1, glm::vec4 shape2, glm::vec3 albedo, float roughness)
+	{
+		BvhPrimitive primitive{};
+		primitive.shape[0] = shape0;
+		primitive.shape[1] = shape1;
+		primitive.shape[2] = shape2;
+		primitive.albedo = albedo;
+		primitive.roughness = roughness;
+		primitive.type = type;
+		primitive.body = body;
+		localPrimitives.push_back(primitive);
+	}
+
+	uint32_t Bvh::addSphere(glm::vec3 center, float radius, glm::vec3 albedo, float roughness)
+	{
+		uint32_t body = addBody(center);
+		addPrimitive(BVH_SPHERE, body, glm::vec4(0.0f, 0.0f, 0.0f, radius), glm::vec4(0.0f), glm::vec4(0.0f), albedo, roughness);
+		return body;
+	}
+
+	uint32_t Bvh::addBox(glm::vec3 center, glm::vec3 halfExtents, glm::vec3 albedo, float roughness)
+	{
+		uint32_t body = addBody(center);
+		addPrimitive(BVH_BOX, body, glm::vec4(-halfExtents, 0.0f), glm::vec4(halfExtents, 0.0f), glm::vec4(0.0f), albedo, roughness);
+		return body;
+	}
+
+	uint32_t Bvh::addMesh(glm::vec3 position, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, glm::vec3 albedo, float roughness)
+	{
+		if (indices.size() % 3 != 0)
+		{
+			throw std::runtime_error("Mesh indices must come in triangles");
+		}
+		uint32_t body = addBody(position);
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			addPrimitive(BVH_TRIANGLE, body, glm::vec4(vertices.at(indices[i]), 0.0f), glm::vec4(vertices.at(indices[i + 1]), 0.0f), glm::vec4(vertices.at(indices[i + 2]), 0.0f), albedo, roughness);
+		}
+		return body;
+	}
+
+	void Bvh::setBodyPosition(uint32_t body, glm::vec3 position)
+	{
+		if (bodies[body].position != position)
+		{
+			bodies[body].position = position;
+			bodies[body].moved = true;
+			anyMoved = true;
+		}
+	}
+
+	BvhPrimitive Bvh::placePrimitive(uint32_t localPrimitive) const
+	{
+		BvhPrimitive primitive = localPrimitives[localPrimitive];
+		glm::vec3 position = bodies[primitive.body].position;
+		// A sphere only moves its centre, the radius in w stays
+		uint32_t points = primitive.type == BVH_SPHERE ? 1 : primitive.type == BVH_BOX ? 2 : 3;
+		for (uint32_t i = 0; i < points; i++)
+		{
+			primitive.shape[i] += glm::vec4(position, 0.0f);
+		}
+		return primitive;
+	}
+
+	// ##### BUILD #####
+
+	bool Bvh::update()
+	{
+		if (structureChanged)
+		{
+			build();
+			return true;
+		}
+		if (anyMoved)
+		{
+			refit();
+			if (cost > builtCost * REBUILD_COST_RATIO)
+			{
+				build();
+			}
+			return true;
+		}
+		return false;
+	}
+
+	void Bvh::build()
+	{
+		std::vector<BuildReference> references(localPrimitives.size());
+		for (uint32_t i = 0; i < localPrimitives.size(); i++)
+		{
+			primitiveBounds(placePrimitive(i), references[i].boundsMin, references[i].boundsMax);
+			references[i].centroid = (references[i].boundsMin + references[i].boundsMax) * 0.5f;
+			references[i].primitive = i;
+		}
+
+		nodes.clear();
+		primitives.clear();
+		primitiveOrder.clear();
+		// A binary tree with a primitive or more per leaf has fewer than twice as many nodes as primitives
+		nodes.reserve(2 * references.size());
+		primitives.reserve(references.size());
+		primitiveOrder.reserve(references.size());
+		if (!references.empty())
+		{
+			buildNode(references, 0, static_cast<uint32_t>(references.size()), 0);
+		}
+
+		for (Body& body : bodies)
+		{
+			body.moved = false;
+		}
+		structureChanged = false;
+		anyMoved = false;
+		cost = computeCost();
+		builtCost = cost;
+	}
+
+	uint32_t Bvh::buildNode(std::vector<BuildReference>& references, uint32_t begin, uint32_t end, uint32_t depth)
+	{
+		uint32_t index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back({});
+
+		glm::vec3 boundsMin(MISS), boundsMax(-MISS), centroidMin(MISS), centroidMax(-MISS);
+		for (uint32_t i = begin; i < end; i++)
+		{
+			boundsMin = glm::min(boundsMin, references[i].boundsMin);
+			boundsMax = glm::max(boundsMax, references[i].boundsMax);
+			centroidMin = glm::min(centroidMin, references[i].centroid);
+			centroidMax = glm::max(centroidMax, references[i].centroid);
+		}
+		nodes[index].boundsMin = boundsMin;
+		nodes[index].boundsMax = boundsMax;
+
+		// Binned SAH over all three axes: every primitive goes to the bin its centroid falls in, and the planes
+		// between bins are scored by the area and primitive count on either side
+		uint32_t count = end - begin;
+		float leafCost = static_cast<float>(count);
+		float bestCost = MISS;
+		int bestAxis = -1;
+		uint32_t bestPlane = 0;
+		if (count > 1 && depth + 1 < MAX_DEPTH)
+		{
+			float parentArea = surfaceArea(boundsMin, boundsMax);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float extent = centroidMax[axis] - centroidMin[axis];
+				if (extent <= 0.0f)
+				{
+					continue;
+				}
+				struct Bin {
+					glm::vec3 boundsMin{ MISS };
+					glm::vec3 boundsMax{ -MISS };
+					uint32_t count = 0;
+				};
+				std::array<Bin, BIN_COUNT> bins{};
+				float scale = BIN_COUNT / extent;
+				for (uint32_t i = begin; i < end; i++)
+				{
+					uint32_t bin = std::min(static_cast<uint32_t>((references[i].centroid[axis] - centroidMin[axis]) * scale), BIN_COUNT - 1);
+					bins[bin].boundsMin = glm::min(bins[bin].boundsMin, references[i].boundsMin);
+					bins[bin].boundsMax = glm::max(bins[bin].boundsMax, references[i].boundsMax);
+					bins[bin].count++;
+				}
+
+				// Sweep from the right first, then score every plane sweeping from the left
+				std::array<float, BIN_COUNT> rightArea{};
+				std::array<uint32_t, BIN_COUNT> rightCount{};
+				glm::vec3 sweepMin(MISS), sweepMax(-MISS);
+				uint32_t sweepCount = 0;
+				for (uint32_t plane = BIN_COUNT - 1; plane > 0; plane--)
+				{
+					sweepMin = glm::min(sweepMin, bins[plane].boundsMin);
+					sweepMax = glm::max(sweepMax, bins[plane].boundsMax);
+					sweepCount += bins[plane].count;
+					rightArea[plane] = surfaceArea(sweepMin, sweepMax);
+					rightCount[plane] = sweepCount;
+				}
+				sweepMin = glm::vec3(MISS);
+				sweepMax = glm::vec3(-MISS);
+				sweepCount = 0;
+				for (uint32_t plane = 1; plane < BIN_COUNT; plane++)
+				{
+					sweepMin = glm::min(sweepMin, bins[plane - 1].boundsMin);
+					sweepMax = glm::max(sweepMax, bins[plane - 1].boundsMax);
+					sweepCount += bins[plane - 1].count;
+					if (sweepCount == 0 || rightCount[plane] == 0)
+					{
+						continue;
+					}
+					float splitCost = TRAVERSAL_COST + (surfaceArea(sweepMin, sweepMax) * sweepCount + rightArea[plane] * rightCount[plane]) / parentArea;
+					if (splitCost < bestCost)
+					{
+						bestCost = splitCost;
+						bestAxis = axis;
+						bestPlane = plane;
+					}
+				}
+			}
+		}
+
+		if (bestAxis < 0 || (bestCost >= leafCost && count <= MAX_LEAF_SIZE))
+		{
+			nodes[index].first = static_cast<uint32_t>(primitives.size());
+			nodes[index].count = count;
+			for (uint32_t i = begin; i < end; i++)
+			{
+				primitives.push_back(placePrimitive(references[i].primitive));
+				primitiveOrder.push_back(references[i].primitive);
+			}
+			return index;
+		}
+
+		float scale = BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+		auto middle = std::partition(references.begin() + begin, references.begin() + end, [&](const BuildReference& reference)
+		{
+			return std::min(static_cast<uint32_t>((reference.centroid[bestAxis] - centroidMin[bestAxis]) * scale), BIN_COUNT - 1) < bestPlane;
+		});
+		uint32_t split = static_cast<uint32_t>(middle - references.begin());
+
+		// The left child lands right after this node
+		buildNode(references, begin, split, depth + 1);
+		uint32_t right = buildNode(references, split, end, depth + 1);
+		nodes[index].first = right;
+		nodes[index].count = 0;
+		return index;
+	}
+
+	void Bvh::refit()
+	{
+		for (size_t i = 0; i < primitives.size(); i++)
+		{
+			if (bodies[primitives[i].body].moved)
+			{
+				primitives[i] = placePrimitive(primitiveOrder[i]);
+			}
+		}
+
+		// Children always come after their parent, so walking backwards finishes them first
+		for (size_t i = nodes.size(); i-- > 0;)
+		{
+			BvhNode& node = nodes[i];
+			if (node.count > 0)
+			{
+				node.boundsMin = glm::vec3(MISS);
+				node.boundsMax = glm::vec3(-MISS);
+				for (uint32_t p = node.first; p < node.first + node.count; p++)
+				{
+					glm::vec3 boundsMin, boundsMax;
+					primitiveBounds(primitives[p], boundsMin, boundsMax);
+					node.boundsMin = glm::min(node.boundsMin, boundsMin);
+					node.boundsMax = glm::max(node.boundsMax, boundsMax);
+				}
+			}
+			else
+			{
+				const BvhNode& left = nodes[i + 1];
+				const BvhNode& right = nodes[node.first];
+				node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+				node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+			}
+		}
+
+		for (Body& body : bodies)
+		{
+			body.moved = false;
+		}
+		anyMoved = false;
+		cost = computeCost();
+	}
+
+	float Bvh::computeCost() const
+	{
+		if (nodes.empty())
+		{
+			return 0.0f;
+		}
+		// A ray through the root enters every node with the probability of the ratio of their areas
+		float rootArea = std::max(surfaceArea(nodes[0].boundsMin, nodes[0].boundsMax), 1e-12f);
+		float total = 0.0f;
+		for (const BvhNode& node : nodes)
+		{
+			total += surfaceArea(node.boundsMin, node.boundsMax) / rootArea * (node.count > 0 ? static_cast<float>(node.count) : TRAVERSAL_COST);
+		}
+		return total;
+	}
+
+	// ##### TRAVERSAL #####
+
+	bool Bvh::intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BvhHit& hit) const
+	{
+		if (nodes.empty())
+		{
+			return false;
+		}
+		glm::vec3 inverseDirection = 1.0f / direction;
+		if (intersectBounds(nodes[0].boundsMin, nodes[0].boundsMax, origin, inverseDirection, maxDistance) == MISS)
+		{
+			return false;
+		}
+
+		float closest = maxDistance;
+		uint32_t closestPrimitive = UINT32_MAX;
+		std::array<uint32_t, MAX_DEPTH> stack;
+		std::array<float, MAX_DEPTH> stackDistance;
+		uint32_t stackSize = 0;
+		uint32_t index = 0;
+		while (true)
+		{
+			const BvhNode& node = nodes[index];
+			if (node.count > 0)
+			{
+				for (uint32_t p = node.first; p < node.first + node.count; p++)
+				{
+					float t = intersectPrimitive(primitives[p], origin, direction, inverseDirection);
+					if (t < closest)
+					{
+						closest = t;
+						closestPrimitive = p;
+					}
+				}
+			}
+			else
+			{
+				// Into the nearer child first, the farther one waits on the stack
+				uint32_t near = index + 1;
+				uint32_t far = node.first;
+				float nearDistance = intersectBounds(nodes[near].boundsMin, nodes[near].boundsMax, origin, inverseDirection, closest);
+				float farDistance = intersectBounds(nodes[far].boundsMin, nodes[far].boundsMax, origin, inverseDirection, closest);
+				if (farDistance < nearDistance)
+				{
+					std::swap(near, far);
+					std::swap(nearDistance, farDistance);
+				}
+				if (nearDistance != MISS)
+				{
+					if (farDistance != MISS)
+					{
+						stack[stackSize] = far;
+						stackDistance[stackSize] = farDistance;
+						stackSize++;
+					}
+					index = near;
+					continue;
+				}
+			}
+
+			// Skip what a hit found since has moved in front of
+			while (stackSize > 0 && stackDistance[stackSize - 1] >= closest)
+			{
+				stackSize--;
+			}
+			if (stackSize == 0)
+			{
+				break;
+			}
+			index = stack[--stackSize];
+		}
+
+		if (closestPrimitive == UINT32_MAX)
+		{
+			return false;
+		}
+		const BvhPrimitive& primitive = primitives[closestPrimitive];
+		hit.distance = closest;
+		hit.normal = primitiveNormal(primitive, origin + direction * closest, direction);
+		hit.albedo = primitive.albedo;
+		hit.roughness = primitive.roughness;
+		return true;
+	}
+
+	void addSceneBodies(Bvh& bvh)
+	{
+		bvh.addSphere(glm::vec3(MOON_CENTER), MOON_RADIUS, glm::vec3(MOON_ALBEDO));
+		bvh.addSphere(glm::vec3(MIRROR_CENTER), MIRROR_RADIUS, glm::vec3(MIRROR_ALBEDO), 0.0f);
+		bvh.addBox(glm::vec3(MONOLITH_CENTER), glm::vec3(MONOLITH_HALF_EXTENTS), glm::vec3(MONOLITH_ALBEDO));
+
+		const float size = static_cast<float>(CRYSTAL_SIZE);
+		std::vector<glm::vec3> vertices{ { size, 0.0f, 0.0f }, { -size, 0.0f, 0.0f }, { 0.0f, size, 0.0f }, { 0.0f, -size, 0.0f }, { 0.0f, 0.0f, size }, { 0.0f, 0.0f, -size } };
+		std::vector<uint32_t> indices{ 0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5 };
+		bvh.addMesh(glm::vec3(CRYSTAL_CENTER), vertices, indices, glm::vec3(CRYSTAL_ALBEDO));
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Solarium
+{
+	// BvhNode in bvh.glsl. Nodes are laid out depth first: an interior node (count 0) has its left child right after
+	// it and its right child at first; a leaf holds count primitives from first.
+	struct BvhNode {
+		glm::vec3 boundsMin;
+		uint32_t first;
+		glm::vec3 boundsMax;
+		uint32_t count;
+	};
+	static_assert(sizeof(BvhNode) == 32, "BvhNode must match the std430 layout in bvh.glsl");
+
+	enum BvhPrimitiveType : uint32_t {
+		BVH_SPHERE,
+		BVH_BOX,
+		BVH_TRIANGLE
+	};
+
+	// BvhPrimitive in bvh.glsl
+	struct BvhPrimitive {
+		// Sphere: centre and radius in shape[0]. Box: min and max corner in the xyz of shape[0] and shape[1].
+		// Triangle: corners in the xyz of all three.
+		glm::vec4 shape[3];
+		glm::vec3 albedo;
+		// Below 0.01 the surface is a mirror, as for the planet in raytrace.comp
+		float roughness;
+		uint32_t type;
+		uint32_t body;
+		uint32_t padding[2];
+	};
+	static_assert(sizeof(BvhPrimitive) == 80, "BvhPrimitive must match the std430 layout in bvh.glsl");
+
+	struct BvhHit {
+		float distance;
+		// Faces against the ray
+		glm::vec3 normal;
+		glm::vec3 albedo;
+		float roughness;
+	};
+
+	// Bounding volume hierarchy over the bodies the path tracer intersects analytically: spheres, boxes and triangle
+	// meshes. Built on the CPU with binned SAH splits and flattened into the node array the GPU traverses with a
+	// stack, so a ray visits a number of nodes that grows with the log of the scene size. Moving a body only refits
+	// the bounds; once refits have made the tree REBUILD_COST_RATIO times costlier than when it was built, it is
+	// built again.
+	class Bvh
+	{
+	public:
+		static constexpr uint32_t BIN_COUNT = 16;
+		// BVH_STACK_SIZE in bvh.glsl; deeper nodes become leaves, so the traversal stack cannot overflow
+		static constexpr uint32_t MAX_DEPTH = 32;
+		// Larger leaves are split even where the SAH would keep them
+		static constexpr uint32_t MAX_LEAF_SIZE = 8;
+		// Cost of visiting a node, relative to intersecting a primitive
+		static constexpr float TRAVERSAL_COST = 1.0f;
+		static constexpr float REBUILD_COST_RATIO = 1.5f;
+
+		Bvh() = default;
+		Bvh(const Bvh&) = delete;
+		Bvh& operator=(const Bvh&) = delete;
+
+		// Each returns the body, whose position is the given centre
+		uint32_t addSphere(glm::vec3 center, float radius, glm::vec3 albedo, float roughness = 1.0f);
+		uint32_t addBox(glm::vec3 center, glm::vec3 halfExtents, glm::vec3 albedo, float roughness = 1.0f);
+		// Triangles from every three indices, with vertices relative to position
+		uint32_t addMesh(glm::vec3 position, const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices, glm::vec3 albedo, float roughness = 1.0f);
+		void setBodyPosition(uint32_t body, glm::vec3 position);
+		glm::vec3 getBodyPosition(uint32_t body) { return bodies[body].position; }
+		uint32_t getBodyCount() { return static_cast<uint32_t>(bodies.size()); }
+
+		// Builds after bodies were added and refits after they moved; true if the nodes or primitives changed
+		bool update();
+		void build();
+		void refit();
+
+		// Closest hit nearer than maxDistance, with the same tests as bvh.glsl
+		bool intersect(glm::vec3 origin, glm::vec3 direction, float maxDistance, BvhHit& hit) const;
+
+		const std::vector<BvhNode>& getNodes() const { return nodes; }
+		// In leaf order
+		const std::vector<BvhPrimitive>& getPrimitives() const { return primitives; }
+		// Expected cost of a ray through the root, in primitive intersections
+		float getCost() const { return cost; }
+
+	private:
+		struct Body {
+			glm::vec3 position;
+			bool moved;
+		};
+
+		struct BuildReference {
+			glm::vec3 boundsMin;
+			glm::vec3 boundsMax;
+			glm::vec3 centroid;
+			uint32_t primitive;
+		};
+
+		uint32_t addBody(glm::vec3 position);
+		void addPrimitive(BvhPrimitiveType type, uint32_t body, glm::vec4 shape0, glm::vec4 shape1, glm::vec4 shape2, glm::vec3 albedo, float roughness);
+		uint32_t buildNode(std::vector<BuildReference>& references, uint32_t begin, uint32_t end, uint32_t depth);
+		BvhPrimitive placePrimitive(uint32_t localPrimitive) const;
+		float computeCost() const;
+
+		std::vector<Body> bodies;
+		// Relative to their body's position, in the order they were added
+		std::vector<BvhPrimitive> localPrimitives;
+		std::vector<BvhPrimitive> primitives;
+		// The localPrimitives entry of every primitive
+		std::vector<uint32_t> primitiveOrder;
+		std::vector<BvhNode> nodes;
+
+		bool structureChanged = false;
+		bool anyMoved = false;
+		float cost = 0.0f;
+		float builtCost = 0.0f;
+	};
+
+	// Adds the bodies of Shaders/scene.h
+	void addSceneBodies(Bvh& bvh);
+}
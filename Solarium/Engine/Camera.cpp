@@ -4,13 +4,9 @@ namespace Solarium
 {
 	void Camera::updateViewMatrix()
 	{
-		glm::mat4 rotM = glm::mat4(1.0f);
+		glm::mat4 rotM = TransformMath::eulerRotation(glm::vec3(rotation.x * (flipY ? -1.0f : 1.0f), rotation.y, rotation.z));
 		glm::mat4 transM;
 
-		rotM = glm::rotate(rotM, glm::radians(rotation.x * (flipY ? -1.0f : 1.0f)), glm::vec3(1.0f, 0.0f, 0.0f));
-		rotM = glm::rotate(rotM, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		rotM = glm::rotate(rotM, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
 		glm::vec3 translation = position;
 		if (flipY) {
 			translation.y *= -1.0f;
@@ -19,11 +15,11 @@ namespace Solarium
 
 		if (type == CameraType::firstperson)
 		{
-			matrices.view = rotM * transM;
+			TransformMath::multiply(rotM, transM, matrices.view);
 		}
 		else
 		{
-			matrices.view = transM * rotM;
+			TransformMath::multiply(transM, rotM, matrices.view);
 		}
 
 		viewPos = glm::vec4(position, 0.0f) * glm::vec4(-1.0f, 1.0f, -1.0f, 1.0f);
@@ -0,0 +1,91 @@
+#include "ComputePipeline.hpp"
+#include <stdexcept>
+
+namespace Solarium
+{
+	ComputePipeline::ComputePipeline(Device& device, const ComputePipelineConfigInfo& configInfo) : ldevice{ device }
+	{
+		pipelineLayout = configInfo.pipelineLayout;
+		pushConstantRange = configInfo.pushConstantRange;
+		localSize = configInfo.localSize;
+
+		vk::PipelineShaderStageCreateInfo shaderStage = configInfo.shaderStage;
+		vk::SpecializationInfo specializationInfo{ static_cast<uint32_t>(configInfo.specializationEntries.size()), configInfo.specializationEntries.data(), configInfo.specializationData.size(), configInfo.specializationData.data() };
+		if (!configInfo.specializationEntries.empty())
+		{
+			shaderStage.pSpecializationInfo = &specializationInfo;
+		}
+
+		vk::ComputePipelineCreateInfo pipelineInfo{ {}, shaderStage, configInfo.pipelineLayout };
+		pipelineInfo.basePipelineIndex = -1;
+
+		computePipeline = ldevice.device().createComputePipelines(configInfo.pipelineCache, pipelineInfo).value[0];
+		if (!computePipeline) {
+			throw std::runtime_error("Failed to create compute pipeline.");
+		}
+	}
+
+	ComputePipeline::~ComputePipeline()
+	{
+		ldevice.device().destroyPipeline(computePipeline);
+	}
+
+	void ComputePipeline::bind(vk::CommandBuffer commandBuffer)
+	{
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline);
+	}
+
+	void ComputePipeline::bindDescriptorSets(vk::CommandBuffer commandBuffer, uint32_t firstSet, const std::vector<vk::DescriptorSet>& descriptorSets)
+	{
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipelineLayout, firstSet, descriptorSets, nullptr);
+	}
+
+	void ComputePipeline::pushConstants(vk::CommandBuffer commandBuffer, const void* data)
+	{
+		if (pushConstantRange.size == 0)
+		{
+			return;
+		}
+		commandBuffer.pushConstants(pipelineLayout, pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size, static_cast<const char*>(data) + pushConstantRange.offset);
+	}
+
+	void ComputePipeline::dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height, uint32_t depth)
+	{
+		commandBuffer.dispatch(groupCount(width, localSize[0]), groupCount(height, localSize[1]), groupCount(depth, localSize[2]));
+	}
+
+	void ComputePipeline::memoryBarrier(vk::CommandBuffer commandBuffer, vk::PipelineStageFlags dstStages, vk::AccessFlags dstAccess)
+	{
+		vk::MemoryBarrier barrier{ vk::AccessFlagBits::eShaderWrite, dstAccess };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, dstStages, {}, barrier, nullptr, nullptr);
+	}
+
+	void ComputePipeline::computeToDrawBarrier(vk::CommandBuffer commandBuffer)
+	{
+		memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput | vk::PipelineStageFlagBits::eVertexShader,
+			vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eIndexRead | vk::AccessFlagBits::eShaderRead);
+	}
+
+	void ComputePipeline::computeToFragmentImageBarrier(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange)
+	{
+		vk::ImageMemoryBarrier barrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, subresourceRange };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, barrier);
+	}
+
+	void ComputePipeline::fragmentToComputeImageBarrier(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange)
+	{
+		// Sampling only reads, so there is nothing to make available; the stage dependency covers the write after read
+		vk::ImageMemoryBarrier barrier{ {}, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, subresourceRange };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+	}
+
+	void ComputePipeline::prepareStorageImage(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange, vk::PipelineStageFlags srcStages)
+	{
+		// Waiting on srcStages keeps earlier reads of the image from seeing the new writes
+		vk::ImageMemoryBarrier barrier{ {}, vk::AccessFlagBits::eShaderWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, subresourceRange };
+		commandBuffer.pipelineBarrier(srcStages, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+	}
+}
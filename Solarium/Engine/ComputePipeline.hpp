@@ -0,0 +1,67 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+
+#include <array>
+#include <vector>
+
+namespace Solarium
+{
+
+	struct ComputePipelineConfigInfo {
+		vk::PipelineShaderStageCreateInfo shaderStage;
+		// Identifies the code behind shaderStage, see ShaderHelper::getShaderHash
+		uint64_t shaderHash = 0;
+		// Workgroup size of the shader, see ShaderReflection::getLocalSize
+		std::array<uint32_t, 3> localSize{ 1, 1, 1 };
+		std::vector<vk::SpecializationMapEntry> specializationEntries;
+		std::vector<char> specializationData;
+		// Empty when the shader has no push constant block
+		vk::PushConstantRange pushConstantRange{};
+		vk::PipelineLayout pipelineLayout = nullptr;
+		// Not part of the pipeline state
+		vk::PipelineCache pipelineCache = nullptr;
+	};
+
+	class ComputePipeline
+	{
+	public:
+		ComputePipeline(Device& device, const ComputePipelineConfigInfo& configInfo);
+		~ComputePipeline();
+		ComputePipeline(const ComputePipeline&) = delete;
+		void operator=(const ComputePipeline&) = delete;
+
+		void bind(vk::CommandBuffer commandBuffer);
+		void bindDescriptorSets(vk::CommandBuffer commandBuffer, uint32_t firstSet, const std::vector<vk::DescriptorSet>& descriptorSets);
+		// data must cover the pipeline's push constant range
+		void pushConstants(vk::CommandBuffer commandBuffer, const void* data);
+		// Dispatches enough workgroups to run at least width * height * depth invocations. The shader has to
+		// discard the invocations past the end itself.
+		void dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height = 1, uint32_t depth = 1);
+
+		static uint32_t groupCount(uint32_t invocations, uint32_t localSize) { return (invocations + localSize - 1) / localSize; }
+
+		// Makes compute shader writes visible to the given later stages. A global memory barrier covers every
+		// buffer at once and is no slower than per-buffer barriers on current drivers.
+		static void memoryBarrier(vk::CommandBuffer commandBuffer, vk::PipelineStageFlags dstStages, vk::AccessFlags dstAccess);
+		// Storage buffer written by compute and then read as vertex, index or indirect draw data
+		static void computeToDrawBarrier(vk::CommandBuffer commandBuffer);
+		// Storage image written by compute and then sampled by the fragment shader, moved from eGeneral to eShaderReadOnlyOptimal
+		static void computeToFragmentImageBarrier(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange);
+		// The way back once the fragment shader is done sampling it: eShaderReadOnlyOptimal to eGeneral, keeping the contents
+		static void fragmentToComputeImageBarrier(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange);
+		// Moves an image to eGeneral so compute can write it; its previous contents are discarded
+		static void prepareStorageImage(vk::CommandBuffer commandBuffer, vk::Image image, const vk::ImageSubresourceRange& subresourceRange, vk::PipelineStageFlags srcStages);
+
+		vk::Pipeline getComputePipeline() { return computePipeline; }
+		vk::PipelineLayout getPipelineLayout() { return pipelineLayout; }
+
+	private:
+		Device& ldevice;
+		vk::Pipeline computePipeline;
+		vk::PipelineLayout pipelineLayout;
+		vk::PushConstantRange pushConstantRange;
+		std::array<uint32_t, 3> localSize;
+	};
+}
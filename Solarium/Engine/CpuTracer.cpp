@@ -0,0 +1,504 @@
+#include "CpuTracer.hpp"
+#include "../Shaders/scene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOLARIUM_TRACE_SSE
+#endif
+
+namespace Solarium
+{
+
+	static constexpr float PI = 3.14159265f;
+	static constexpr float TWO_PI = 2.0f * PI;
+
+	// ##### PACKETS #####
+	// Four lanes, on SSE2 where available and as plain loops otherwise. AVX2 builds stay at four lanes: a 2x2 pixel
+	// quad keeps its rays close together, and wider packets would diverge sooner on the terrain.
+
+	struct Mask4
+	{
+#if defined(SOLARIUM_TRACE_SSE)
+		__m128 v;
+#else
+		bool v[4];
+#endif
+	};
+
+	struct Float4
+	{
+#if defined(SOLARIUM_TRACE_SSE)
+		__m128 v;
+
+		Float4() : v(_mm_setzero_ps()) {}
+		Float4(__m128 v_) : v(v_) {}
+		Float4(float s) : v(_mm_set1_ps(s)) {}
+
+		float lane(uint32_t i) const { alignas(16) float lanes[4]; _mm_store_ps(lanes, v); return lanes[i]; }
+		void setLane(uint32_t i, float value) { alignas(16) float lanes[4]; _mm_store_ps(lanes, v); lanes[i] = value; v = _mm_load_ps(lanes); }
+#else
+		float v[4];
+
+		Float4() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+		Float4(float s) : v{ s, s, s, s } {}
+
+		float lane(uint32_t i) const { return v[i]; }
+		void setLane(uint32_t i, float value) { v[i] = value; }
+#endif
+	};
+
+#if defined(SOLARIUM_TRACE_SSE)
+	static Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+	static Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+	static Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+	static Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+	static Float4 max4(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+	static Float4 sqrt4(Float4 a) { return _mm_sqrt_ps(a.v); }
+	static Float4 abs4(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+	// SSE2 has no rounding instruction: truncate, then step down where that rounded up. Exact below 2^31.
+	static Float4 floor4(Float4 a)
+	{
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f)));
+	}
+
+	static Mask4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+	static Mask4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+	static Mask4 operator&(Mask4 a, Mask4 b) { return { _mm_and_ps(a.v, b.v) }; }
+	static Mask4 operator|(Mask4 a, Mask4 b) { return { _mm_or_ps(a.v, b.v) }; }
+	// a and not b
+	static Mask4 andNot(Mask4 a, Mask4 b) { return { _mm_andnot_ps(b.v, a.v) }; }
+	static uint32_t bits(Mask4 a) { return static_cast<uint32_t>(_mm_movemask_ps(a.v)); }
+	static Mask4 maskFromBits(uint32_t laneBits)
+	{
+		__m128i lanes = _mm_and_si128(_mm_set1_epi32(static_cast<int>(laneBits)), _mm_setr_epi32(1, 2, 4, 8));
+		return { _mm_castsi128_ps(_mm_cmpeq_epi32(lanes, _mm_setr_epi32(1, 2, 4, 8))) };
+	}
+	static Float4 select(Mask4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+#else
+	template<typename Op>
+	static Float4 perLane(Float4 a, Float4 b, Op op)
+	{
+		Float4 result;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			result.v[i] = op(a.v[i], b.v[i]);
+		}
+		return result;
+	}
+
+	template<typename Op>
+	static Mask4 perLaneMask(Float4 a, Float4 b, Op op)
+	{
+		Mask4 result;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			result.v[i] = op(a.v[i], b.v[i]);
+		}
+		return result;
+	}
+
+	static Float4 operator+(Float4 a, Float4 b) { return perLane(a, b, [](float x, float y) { return x + y; }); }
+	static Float4 operator-(Float4 a, Float4 b) { return perLane(a, b, [](float x, float y) { return x - y; }); }
+	static Float4 operator*(Float4 a, Float4 b) { return perLane(a, b, [](float x, float y) { return x * y; }); }
+	static Float4 operator/(Float4 a, Float4 b) { return perLane(a, b, [](float x, float y) { return x / y; }); }
+	static Float4 max4(Float4 a, Float4 b) { return perLane(a, b, [](float x, float y) { return std::max(x, y); }); }
+	static Float4 sqrt4(Float4 a) { return perLane(a, a, [](float x, float) { return std::sqrt(x); }); }
+	static Float4 abs4(Float4 a) { return perLane(a, a, [](float x, float) { return std::fabs(x); }); }
+	static Float4 floor4(Float4 a) { return perLane(a, a, [](float x, float) { return std::floor(x); }); }
+
+	static Mask4 operator<(Float4 a, Float4 b) { return perLaneMask(a, b, [](float x, float y) { return x < y; }); }
+	static Mask4 operator>(Float4 a, Float4 b) { return perLaneMask(a, b, [](float x, float y) { return x > y; }); }
+	static Mask4 operator&(Mask4 a, Mask4 b) { return { a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3] }; }
+	static Mask4 operator|(Mask4 a, Mask4 b) { return { a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3] }; }
+	static Mask4 andNot(Mask4 a, Mask4 b) { return { a.v[0] && !b.v[0], a.v[1] && !b.v[1], a.v[2] && !b.v[2], a.v[3] && !b.v[3] }; }
+	static uint32_t bits(Mask4 a) { return (a.v[0] ? 1u : 0u) | (a.v[1] ? 2u : 0u) | (a.v[2] ? 4u : 0u) | (a.v[3] ? 8u : 0u); }
+	static Mask4 maskFromBits(uint32_t laneBits) { return { (laneBits & 1u) != 0, (laneBits & 2u) != 0, (laneBits & 4u) != 0, (laneBits & 8u) != 0 }; }
+	static Float4 select(Mask4 mask, Float4 a, Float4 b)
+	{
+		Float4 result;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			result.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+		}
+		return result;
+	}
+#endif
+
+	// Folded into [0, pi/2] and evaluated with the Taylor series up to x^12, within 5e-7 of std::cos there
+	static Float4 cos4(Float4 x)
+	{
+		x = x - floor4(x * Float4(1.0f / TWO_PI) + Float4(0.5f)) * Float4(TWO_PI);
+		Float4 a = abs4(x);
+		Mask4 flip = a > Float4(0.5f * PI);
+		a = select(flip, Float4(PI) - a, a);
+		Float4 a2 = a * a;
+		Float4 p = Float4(1.0f / 479001600.0f);
+		p = Float4(-1.0f / 3628800.0f) + a2 * p;
+		p = Float4(1.0f / 40320.0f) + a2 * p;
+		p = Float4(-1.0f / 720.0f) + a2 * p;
+		p = Float4(1.0f / 24.0f) + a2 * p;
+		p = Float4(-0.5f) + a2 * p;
+		p = Float4(1.0f) + a2 * p;
+		return select(flip, Float4(0.0f) - p, p);
+	}
+
+	struct Vec3x4
+	{
+		Float4 x, y, z;
+
+		glm::vec3 lane(uint32_t i) const { return glm::vec3(x.lane(i), y.lane(i), z.lane(i)); }
+		void setLane(uint32_t i, glm::vec3 value) { x.setLane(i, value.x); y.setLane(i, value.y); z.setLane(i, value.z); }
+	};
+
+	static Vec3x4 operator+(const Vec3x4& a, const Vec3x4& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	static Vec3x4 operator-(const Vec3x4& a, const Vec3x4& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	static Vec3x4 operator*(const Vec3x4& a, Float4 s) { return { a.x * s, a.y * s, a.z * s }; }
+	static Vec3x4 splat(glm::vec3 v) { return { Float4(v.x), Float4(v.y), Float4(v.z) }; }
+	static Float4 dot(const Vec3x4& a, const Vec3x4& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+	// ##### SCENE #####
+	// Ports of planet.glsl and noise.glsl; the packet versions cover what runs every march step, the scalar ones
+	// what runs once per hit.
+
+	static const glm::vec3 planetCenter{ PLANET_CENTER_X, PLANET_CENTER_Y, PLANET_CENTER_Z };
+	static const glm::vec3 planetBoundsMin = planetCenter - glm::vec3(PLANET_RADIUS + TERRAIN_HEIGHT + BOUNDS_MARGIN);
+	static const glm::vec3 planetBoundsMax = planetCenter + glm::vec3(PLANET_RADIUS + TERRAIN_HEIGHT + BOUNDS_MARGIN);
+
+	static Float4 planet(const Vec3x4& pos)
+	{
+		Vec3x4 local = pos - splat(planetCenter);
+		Float4 length = sqrt4(dot(local, local));
+		Vec3x4 coord = local * (Float4(static_cast<float>(TERRAIN_FREQUENCY)) / length);
+
+		// fbmcyclic
+		Float4 value = Float4(0.0f);
+		Float4 scale = Float4(1.0f);
+		Float4 atten = Float4(0.5f);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(TERRAIN_OCTAVES); i++)
+		{
+			Float4 cyclic = abs4(cos4(coord.x * scale) + cos4(coord.y * scale) + cos4(coord.z * scale)) * Float4(1.0f / 3.0f);
+			value = value + cyclic * atten;
+			scale = scale * Float4(2.0f);
+			atten = atten * Float4(0.5f);
+		}
+		return Float4(static_cast<float>(ESTIMATOR_SCALE)) * (length - Float4(static_cast<float>(PLANET_RADIUS)) - Float4(static_cast<float>(TERRAIN_HEIGHT)) * value);
+	}
+
+	static Float4 sceneDistance(const Vec3x4& pos, Mask4 active, float collisionDistance)
+	{
+		// Nothing lies outside the bounds, so the distance to them is a safe step
+		Vec3x4 outside{
+			max4(max4(Float4(planetBoundsMin.x) - pos.x, pos.x - Float4(planetBoundsMax.x)), Float4(0.0f)),
+			max4(max4(Float4(planetBoundsMin.y) - pos.y, pos.y - Float4(planetBoundsMax.y)), Float4(0.0f)),
+			max4(max4(Float4(planetBoundsMin.z) - pos.z, pos.z - Float4(planetBoundsMax.z)), Float4(0.0f)) };
+		Float4 boundsDistance = sqrt4(dot(outside, outside));
+		Mask4 outsideBounds = boundsDistance > Float4(0.0f);
+		Float4 skip = boundsDistance + Float4(collisionDistance);
+		if (bits(andNot(active, outsideBounds)) == 0)
+		{
+			return skip;
+		}
+		return select(outsideBounds, skip, planet(pos));
+	}
+
+	static Vec3x4 planetNormal(const Vec3x4& pos)
+	{
+		const float offset = 1e-3f;
+		Vec3x4 dx{ Float4(offset), Float4(0.0f), Float4(0.0f) };
+		Vec3x4 dy{ Float4(0.0f), Float4(offset), Float4(0.0f) };
+		Vec3x4 dz{ Float4(0.0f), Float4(0.0f), Float4(offset) };
+		Vec3x4 gradient{ planet(pos + dx) - planet(pos - dx), planet(pos + dy) - planet(pos - dy), planet(pos + dz) - planet(pos - dz) };
+		return gradient * (Float4(1.0f) / sqrt4(dot(gradient, gradient)));
+	}
+
+	static float smoothstep(float edge0, float edge1, float x)
+	{
+		float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+		return t * t * (3.0f - 2.0f * t);
+	}
+
+	static glm::vec3 fract(glm::vec3 v) { return v - glm::floor(v); }
+
+	// Dave_Hoskins Hash33: https://www.shadertoy.com/view/4djSRW
+	static glm::vec3 hash(glm::vec3 p3)
+	{
+		p3 = fract(p3 * glm::vec3(0.1031f, 0.1030f, 0.0973f));
+		p3 += glm::dot(p3, glm::vec3(p3.y, p3.x, p3.z) + 33.33f);
+		return fract((glm::vec3(p3.x, p3.x, p3.y) + glm::vec3(p3.y, p3.x, p3.x)) * glm::vec3(p3.z, p3.y, p3.x));
+	}
+
+	// worley(coord, period) and fbmworleytiled, the analytic side of the GPU's baked FBM Worley texture
+	static float worley(glm::vec3 coord, float period)
+	{
+		glm::vec3 cell = glm::floor(coord);
+		float mindist = 1000.0f;
+		for (int z = -1; z < 2; z++)
+		{
+			for (int y = -1; y < 2; y++)
+			{
+				for (int x = -1; x < 2; x++)
+				{
+					glm::vec3 ncell = cell + glm::vec3(x, y, z);
+					glm::vec3 point = ncell + hash(ncell - period * glm::floor(ncell / period));
+					mindist = std::min(glm::dot(coord - point, coord - point), mindist);
+				}
+			}
+		}
+		return std::sqrt(mindist);
+	}
+
+	static float fbmworleytiled(glm::vec3 coord, uint32_t octaves)
+	{
+		// worleyPeriod in noise.glsl
+		const float worleyPeriod = 8.0f;
+		float value = 0.0f;
+		float scale = 1.0f;
+		float atten = 0.5f;
+		for (uint32_t i = 0; i < octaves; i++)
+		{
+			value += worley(coord * scale, worleyPeriod * scale) * atten;
+			scale *= 2.0f;
+			atten *= 0.5f;
+		}
+		return value;
+	}
+
+	static glm::vec3 planetAlbedo(glm::vec3 pos)
+	{
+		glm::vec3 local = pos - planetCenter;
+		float height = (glm::length(local) - static_cast<float>(PLANET_RADIUS)) / static_cast<float>(TERRAIN_HEIGHT);
+		float rock = fbmworleytiled(glm::normalize(local) * static_cast<float>(ROCK_FREQUENCY), ROCK_OCTAVES);
+		glm::vec3 land = glm::mix(glm::vec3(LAND_ALBEDO), glm::vec3(ROCK_ALBEDO), smoothstep(ROCK_COVER_MIN, ROCK_COVER_MAX, rock));
+		return glm::mix(glm::vec3(OCEAN_ALBEDO), land, smoothstep(SHORE_HEIGHT_MIN, SHORE_HEIGHT_MAX, height));
+	}
+
+	static glm::vec3 skyCol(glm::vec3 dir)
+	{
+		const glm::vec3 sundir = glm::normalize(glm::vec3(SUN_DIRECTION));
+		glm::vec3 sky = glm::mix(glm::vec3(SKY_HORIZON), glm::vec3(SKY_ZENITH), std::clamp(dir.z * 0.5f + 0.5f, 0.0f, 1.0f));
+		return sky + glm::vec3(SUN_RADIANCE) * smoothstep(SUN_EDGE_MIN, SUN_EDGE_MAX, glm::dot(dir, sundir));
+	}
+
+	// ##### RNG #####
+	// Random Number Generation made by Michael0884, as in raytrace.comp
+	// https://www.shadertoy.com/view/wltcRS
+	static void pcg(uint32_t& ns)
+	{
+		uint32_t state = ns * 747796405u + 2891336453u;
+		uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		ns = (word >> 22u) ^ word;
+	}
+
+	static float rand(uint32_t& ns) { pcg(ns); return static_cast<float>(ns) / static_cast<float>(0xffffffffu); }
+
+	// Cosine-weighted direction around norm
+	static glm::vec3 diffuseDir(glm::vec3 norm, uint32_t& ns)
+	{
+		float r0 = rand(ns);
+		float r1 = rand(ns);
+		float phi = TWO_PI * r0;
+		float sintheta = std::sqrt(r1);
+		glm::vec3 tangent = glm::normalize(glm::cross(std::fabs(norm.x) > 0.5f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), norm));
+		glm::vec3 bitangent = glm::cross(norm, tangent);
+		return glm::normalize(tangent * std::cos(phi) * sintheta + bitangent * std::sin(phi) * sintheta + norm * std::sqrt(1.0f - r1));
+	}
+
+	// ##### TRACING #####
+
+	// Marches the active lanes together until every one has hit or given up past its maxDistance lane; dist holds
+	// the hit distance of the lanes in the returned mask
+	static Mask4 intersectPlanet(const Vec3x4& rayori, const Vec3x4& raydir, Mask4 active, Float4 maxDistance, const CpuTraceSettings& settings, Float4& dist)
+	{
+		dist = Float4(0.0f);
+		Mask4 hit = maskFromBits(0);
+		for (uint32_t i = 0; i < settings.maxMarches; i++)
+		{
+			active = andNot(active, dist > maxDistance);
+			if (bits(active) == 0)
+			{
+				break;
+			}
+			Float4 distest = sceneDistance(rayori + raydir * dist, active, settings.collisionDistance);
+			Mask4 collided = active & (distest < Float4(settings.collisionDistance));
+			hit = hit | collided;
+			active = andNot(active, collided);
+			dist = select(active, dist + distest, dist);
+		}
+		return hit;
+	}
+
+	CpuTraceStats CpuTracer::render(const CpuTraceSettings& settings, std::vector<glm::vec3>& out)
+	{
+		out.assign(static_cast<size_t>(settings.width) * settings.height, glm::vec3(0.0f));
+		uint32_t tilesX = (settings.width + TILE_SIZE - 1) / TILE_SIZE;
+		uint32_t tilesY = (settings.height + TILE_SIZE - 1) / TILE_SIZE;
+		std::atomic<uint64_t> rays{ 0 };
+
+		auto start = std::chrono::steady_clock::now();
+		// Tiles write disjoint pixels, so they need no synchronisation beyond the ray count
+		auto traceTiles = [&](uint32_t begin, uint32_t end)
+		{
+			uint64_t tileRays = 0;
+			for (uint32_t tile = begin; tile < end; tile++)
+			{
+				renderTile(settings, tile % tilesX, tile / tilesX, out, tileRays);
+			}
+			rays += tileRays;
+		};
+		if (jobSystem)
+		{
+			// One tile per batch; tiles over the sky finish far sooner than tiles over the terrain
+			jobSystem->parallelFor(tilesX * tilesY, 1, traceTiles);
+		}
+		else
+		{
+			traceTiles(0, tilesX * tilesY);
+		}
+
+		CpuTraceStats stats;
+		stats.rays = rays.load();
+		stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return stats;
+	}
+
+	void CpuTracer::renderTile(const CpuTraceSettings& settings, uint32_t tileX, uint32_t tileY, std::vector<glm::vec3>& out, uint64_t& rays)
+	{
+		uint32_t endX = std::min((tileX + 1) * TILE_SIZE, settings.width);
+		uint32_t endY = std::min((tileY + 1) * TILE_SIZE, settings.height);
+		glm::vec2 size{ static_cast<float>(settings.width), static_cast<float>(settings.height) };
+
+		for (uint32_t quadY = tileY * TILE_SIZE; quadY < endY; quadY += 2)
+		{
+			for (uint32_t quadX = tileX * TILE_SIZE; quadX < endX; quadX += 2)
+			{
+				// Lane i is pixel (quadX + i % 2, quadY + i / 2); lanes past the edge of the image stay off
+				uint32_t validBits = 0;
+				uint32_t ns[4];
+				glm::vec3 color[4]{};
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					uint32_t x = quadX + i % 2;
+					uint32_t y = quadY + i / 2;
+					if (x < endX && y < endY)
+					{
+						validBits |= 1u << i;
+					}
+					ns[i] = 185730u * settings.frameIndex + x + y * settings.width;
+				}
+				Mask4 valid = maskFromBits(validBits);
+
+				for (uint32_t sample = 0; sample < settings.samplesPerPixel; sample++)
+				{
+					Vec3x4 raypos = splat(settings.cameraPosition);
+					Vec3x4 raydir;
+					for (uint32_t i = 0; i < 4; i++)
+					{
+						// Jittered inside the pixel, so averaging also anti-aliases
+						glm::vec2 pixel{ static_cast<float>(quadX + i % 2), static_cast<float>(quadY + i / 2) };
+						glm::vec2 jitter{ rand(ns[i]), rand(ns[i]) };
+						glm::vec2 ndc = 2.0f * (pixel + jitter) / size - 1.0f;
+						glm::vec4 target = settings.inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+						raydir.setLane(i, glm::normalize(glm::vec3(target) / target.w - settings.cameraPosition));
+					}
+
+					glm::vec3 attenuation[4]{ glm::vec3(1.0f), glm::vec3(1.0f), glm::vec3(1.0f), glm::vec3(1.0f) };
+					Mask4 alive = valid;
+					for (uint32_t bounce = 0; bounce < settings.maxBounces && bits(alive) != 0; bounce++)
+					{
+						uint32_t aliveBits = bits(alive);
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							rays += (aliveBits >> i) & 1u;
+						}
+
+						// Bodies first, as in raytrace.comp's intersect(): the march need not go past the nearest one
+						BvhHit bodyHits[4];
+						uint32_t bodyBits = 0;
+						Float4 marchDistance(settings.maxDistance);
+						for (uint32_t i = 0; i < 4 && settings.bodies; i++)
+						{
+							if (((aliveBits >> i) & 1u) && settings.bodies->intersect(raypos.lane(i), raydir.lane(i), settings.maxDistance, bodyHits[i]))
+							{
+								bodyBits |= 1u << i;
+								marchDistance.setLane(i, bodyHits[i].distance);
+							}
+						}
+
+						Float4 intersection;
+						Mask4 planetHit = intersectPlanet(raypos, raydir, alive, marchDistance, settings, intersection);
+						uint32_t planetBits = bits(planetHit);
+						uint32_t hitBits = planetBits | bodyBits;
+						Mask4 hit = maskFromBits(hitBits);
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							// The ray didn't hit anything
+							if ((aliveBits >> i) & ~hitBits & 1u)
+							{
+								color[i] += attenuation[i] * skyCol(raydir.lane(i));
+							}
+						}
+						alive = hit;
+						if (hitBits == 0)
+						{
+							break;
+						}
+
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							if (((bodyBits & ~planetBits) >> i) & 1u)
+							{
+								intersection.setLane(i, bodyHits[i].distance);
+							}
+						}
+						Vec3x4 hitpos = raypos + raydir * intersection;
+						Vec3x4 norm = planetNormal(hitpos);
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							if ((hitBits >> i) & 1u)
+							{
+								bool onPlanet = (planetBits >> i) & 1u;
+								glm::vec3 n = onPlanet ? norm.lane(i) : bodyHits[i].normal;
+								float roughness = onPlanet ? 1.0f : bodyHits[i].roughness;
+								// Step off the surface so the next march does not hit it again straight away
+								raypos.setLane(i, hitpos.lane(i) + n * settings.collisionDistance * 4.0f);
+								attenuation[i] *= onPlanet ? planetAlbedo(hitpos.lane(i)) : bodyHits[i].albedo;
+								raydir.setLane(i, roughness > 0.01f ? diffuseDir(n, ns[i]) : glm::reflect(raydir.lane(i), n));
+							}
+						}
+					}
+					// Lanes still alive ran out of bounces and add nothing
+				}
+
+				for (uint32_t i = 0; i < 4; i++)
+				{
+					if ((validBits >> i) & 1u)
+					{
+						out[static_cast<size_t>(quadY + i / 2) * settings.width + quadX + i % 2] = color[i] / static_cast<float>(settings.samplesPerPixel);
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<uint8_t> CpuTracer::tonemap(const std::vector<glm::vec3>& radiance)
+	{
+		std::vector<uint8_t> pixels(radiance.size() * 3);
+		for (size_t i = 0; i < radiance.size(); i++)
+		{
+			glm::vec3 mapped = radiance[i] / (radiance[i] + 1.0f);
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				float linear = std::clamp(mapped[c], 0.0f, 1.0f);
+				float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+				pixels[i * 3 + c] = static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+			}
+		}
+		return pixels;
+	}
+}
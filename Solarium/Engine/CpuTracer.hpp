@@ -0,0 +1,67 @@
+#pragma once
+
+#include "JobSystem.hpp"
+#include "Bvh.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace Solarium
+{
+
+	struct CpuTraceSettings
+	{
+		uint32_t width = 640;
+		uint32_t height = 360;
+		uint32_t samplesPerPixel = 64;
+		// Seeds the random numbers the same way raytrace.comp does for this frame
+		uint32_t frameIndex = 0;
+		// Defaults are ShaderQuality::forTier(QUALITY_HIGH), which is not used here so the tracer needs no Vulkan
+		uint32_t maxBounces = 32;
+		uint32_t maxMarches = 128;
+		float collisionDistance = 1e-4f;
+		float maxDistance = 32.0f;
+		glm::mat4 inverseViewProj{ 1.0f };
+		glm::vec3 cameraPosition{ 0.0f };
+		// Bodies to trace besides the planet, already built; none when null
+		const Bvh* bodies = nullptr;
+	};
+
+	struct CpuTraceStats
+	{
+		// Camera rays plus bounce rays; every one is a full march
+		uint64_t rays = 0;
+		double seconds = 0.0;
+
+		double raysPerSecond() const { return seconds > 0.0 ? rays / seconds : 0.0; }
+	};
+
+	// Reference path tracer for the planet of Shaders/planet.glsl, following raytrace.comp step by step but without
+	// the baked distance field, so it serves as ground truth for the GPU output and runs where there is no GPU. The
+	// image is split into TILE_SIZE tiles spread over the job system, and every tile is traced in packets of 2x2
+	// pixels, one SIMD lane each, which march the distance estimator together. Bodies are intersected one lane at a
+	// time, their Bvh traversal diverges too soon for packets to pay off.
+	class CpuTracer
+	{
+	public:
+		static constexpr uint32_t TILE_SIZE = 16;
+
+		// A null job system traces on the calling thread
+		CpuTracer(JobSystem* jobSystem_ = nullptr) : jobSystem(jobSystem_) {}
+		CpuTracer(const CpuTracer&) = delete;
+		CpuTracer& operator=(const CpuTracer&) = delete;
+
+		// Writes the mean radiance of every pixel to out, row by row from the top, like the accumulation image
+		CpuTraceStats render(const CpuTraceSettings& settings, std::vector<glm::vec3>& out);
+
+		// raytrace_present.frag's curve followed by the sRGB encoding the swapchain applies; three bytes per pixel
+		static std::vector<uint8_t> tonemap(const std::vector<glm::vec3>& radiance);
+
+	private:
+		void renderTile(const CpuTraceSettings& settings, uint32_t tileX, uint32_t tileY, std::vector<glm::vec3>& out, uint64_t& rays);
+
+		JobSystem* jobSystem;
+	};
+}
@@ -0,0 +1,300 @@
+#include "Culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SOLARIUM_CULL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOLARIUM_CULL_SSE
+#endif
+
+namespace Solarium
+{
+
+	static void appendMask(uint32_t mask, uint32_t base, uint32_t lanes, std::vector<uint32_t>& visible)
+	{
+		for (uint32_t lane = 0; lane < lanes; lane++)
+		{
+			if (mask & (1u << lane))
+			{
+				visible.push_back(base + lane);
+			}
+		}
+	}
+
+	Frustum Frustum::fromMatrix(const glm::mat4& viewProj)
+	{
+		glm::vec4 row0{ viewProj[0][0], viewProj[1][0], viewProj[2][0], viewProj[3][0] };
+		glm::vec4 row1{ viewProj[0][1], viewProj[1][1], viewProj[2][1], viewProj[3][1] };
+		glm::vec4 row2{ viewProj[0][2], viewProj[1][2], viewProj[2][2], viewProj[3][2] };
+		glm::vec4 row3{ viewProj[0][3], viewProj[1][3], viewProj[2][3], viewProj[3][3] };
+
+		Frustum frustum{};
+		frustum.planes[0] = row3 + row0;
+		frustum.planes[1] = row3 - row0;
+		frustum.planes[2] = row3 + row1;
+		frustum.planes[3] = row3 - row1;
+		// -w <= z is exact for GL style depth and slightly conservative for [0, 1] depth
+		frustum.planes[4] = row3 + row2;
+		frustum.planes[5] = row3 - row2;
+
+		for (auto& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	uint32_t FrustumCuller::addBounds(glm::vec3 center, float radius_, glm::vec3 extents)
+	{
+		centerX.push_back(center.x);
+		centerY.push_back(center.y);
+		centerZ.push_back(center.z);
+		radius.push_back(radius_);
+		extentX.push_back(extents.x);
+		extentY.push_back(extents.y);
+		extentZ.push_back(extents.z);
+		return size() - 1;
+	}
+
+	void FrustumCuller::setBounds(uint32_t index, glm::vec3 center, float radius_, glm::vec3 extents)
+	{
+		centerX[index] = center.x;
+		centerY[index] = center.y;
+		centerZ[index] = center.z;
+		radius[index] = radius_;
+		extentX[index] = extents.x;
+		extentY[index] = extents.y;
+		extentZ[index] = extents.z;
+	}
+
+	void FrustumCuller::reserve(size_t count)
+	{
+		centerX.reserve(count);
+		centerY.reserve(count);
+		centerZ.reserve(count);
+		radius.reserve(count);
+		extentX.reserve(count);
+		extentY.reserve(count);
+		extentZ.reserve(count);
+	}
+
+	void FrustumCuller::resize(size_t count)
+	{
+		centerX.resize(count);
+		centerY.resize(count);
+		centerZ.resize(count);
+		radius.resize(count);
+		extentX.resize(count);
+		extentY.resize(count);
+		extentZ.resize(count);
+	}
+
+	void FrustumCuller::clear()
+	{
+		centerX.clear();
+		centerY.clear();
+		centerZ.clear();
+		radius.clear();
+		extentX.clear();
+		extentY.clear();
+		extentZ.clear();
+	}
+
+	void FrustumCuller::cullSpheres(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible)
+	{
+		cull(frustum, jobSystem, BoundsType::SPHERE, visible);
+	}
+
+	void FrustumCuller::cullBoxes(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible)
+	{
+		cull(frustum, jobSystem, BoundsType::BOX, visible);
+	}
+
+	void FrustumCuller::cull(const Frustum& frustum, JobSystem* jobSystem, BoundsType type, std::vector<uint32_t>& visible)
+	{
+		visible.clear();
+		uint32_t count = size();
+		if (count == 0)
+		{
+			return;
+		}
+
+		// Every batch writes into its own list so the merged result stays sorted without locking
+		uint32_t batchCount = (count + BATCH_SIZE - 1) / BATCH_SIZE;
+		batchResults.resize(batchCount);
+
+		auto cullBatch = [&](uint32_t begin, uint32_t end)
+		{
+			std::vector<uint32_t>& out = batchResults[begin / BATCH_SIZE];
+			out.clear();
+			if (type == BoundsType::SPHERE)
+			{
+				cullSpheresRange(frustum, begin, end, out);
+			}
+			else
+			{
+				cullBoxesRange(frustum, begin, end, out);
+			}
+		};
+
+		if (jobSystem)
+		{
+			jobSystem->parallelFor(count, BATCH_SIZE, cullBatch);
+		}
+		else
+		{
+			for (uint32_t begin = 0; begin < count; begin += BATCH_SIZE)
+			{
+				cullBatch(begin, std::min(begin + BATCH_SIZE, count));
+			}
+		}
+
+		size_t total = 0;
+		for (uint32_t i = 0; i < batchCount; i++)
+		{
+			total += batchResults[i].size();
+		}
+		visible.reserve(total);
+		for (uint32_t i = 0; i < batchCount; i++)
+		{
+			visible.insert(visible.end(), batchResults[i].begin(), batchResults[i].end());
+		}
+	}
+
+	void FrustumCuller::cullSpheresRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+	{
+		uint32_t i = begin;
+
+#if defined(SOLARIUM_CULL_AVX2)
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(&centerX[i]);
+			__m256 cy = _mm256_loadu_ps(&centerY[i]);
+			__m256 cz = _mm256_loadu_ps(&centerZ[i]);
+			__m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&radius[i]));
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+			for (const auto& plane : frustum.planes)
+			{
+				__m256 dist = _mm256_fmadd_ps(cx, _mm256_set1_ps(plane.x), _mm256_set1_ps(plane.w));
+				dist = _mm256_fmadd_ps(cy, _mm256_set1_ps(plane.y), dist);
+				dist = _mm256_fmadd_ps(cz, _mm256_set1_ps(plane.z), dist);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+			}
+			appendMask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, 8, visible);
+		}
+#elif defined(SOLARIUM_CULL_SSE)
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(&centerX[i]);
+			__m128 cy = _mm_loadu_ps(&centerY[i]);
+			__m128 cz = _mm_loadu_ps(&centerZ[i]);
+			__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius[i]));
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (const auto& plane : frustum.planes)
+			{
+				__m128 dist = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+				dist = _mm_add_ps(_mm_mul_ps(cy, _mm_set1_ps(plane.y)), dist);
+				dist = _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), dist);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+			}
+			appendMask(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, 4, visible);
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			bool inside = true;
+			for (const auto& plane : frustum.planes)
+			{
+				float dist = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+				if (dist < -radius[i])
+				{
+					inside = false;
+					break;
+				}
+			}
+			if (inside)
+			{
+				visible.push_back(i);
+			}
+		}
+	}
+
+	void FrustumCuller::cullBoxesRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible)
+	{
+		uint32_t i = begin;
+
+#if defined(SOLARIUM_CULL_AVX2)
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 cx = _mm256_loadu_ps(&centerX[i]);
+			__m256 cy = _mm256_loadu_ps(&centerY[i]);
+			__m256 cz = _mm256_loadu_ps(&centerZ[i]);
+			__m256 ex = _mm256_loadu_ps(&extentX[i]);
+			__m256 ey = _mm256_loadu_ps(&extentY[i]);
+			__m256 ez = _mm256_loadu_ps(&extentZ[i]);
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+			for (const auto& plane : frustum.planes)
+			{
+				__m256 dist = _mm256_fmadd_ps(cx, _mm256_set1_ps(plane.x), _mm256_set1_ps(plane.w));
+				dist = _mm256_fmadd_ps(cy, _mm256_set1_ps(plane.y), dist);
+				dist = _mm256_fmadd_ps(cz, _mm256_set1_ps(plane.z), dist);
+				__m256 projected = _mm256_mul_ps(ex, _mm256_set1_ps(std::fabs(plane.x)));
+				projected = _mm256_fmadd_ps(ey, _mm256_set1_ps(std::fabs(plane.y)), projected);
+				projected = _mm256_fmadd_ps(ez, _mm256_set1_ps(std::fabs(plane.z)), projected);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, projected), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+			appendMask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, 8, visible);
+		}
+#elif defined(SOLARIUM_CULL_SSE)
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(&centerX[i]);
+			__m128 cy = _mm_loadu_ps(&centerY[i]);
+			__m128 cz = _mm_loadu_ps(&centerZ[i]);
+			__m128 ex = _mm_loadu_ps(&extentX[i]);
+			__m128 ey = _mm_loadu_ps(&extentY[i]);
+			__m128 ez = _mm_loadu_ps(&extentZ[i]);
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (const auto& plane : frustum.planes)
+			{
+				__m128 dist = _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_set1_ps(plane.w));
+				dist = _mm_add_ps(_mm_mul_ps(cy, _mm_set1_ps(plane.y)), dist);
+				dist = _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), dist);
+				__m128 projected = _mm_mul_ps(ex, _mm_set1_ps(std::fabs(plane.x)));
+				projected = _mm_add_ps(_mm_mul_ps(ey, _mm_set1_ps(std::fabs(plane.y))), projected);
+				projected = _mm_add_ps(_mm_mul_ps(ez, _mm_set1_ps(std::fabs(plane.z))), projected);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, projected), _mm_setzero_ps()));
+			}
+			appendMask(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, 4, visible);
+		}
+#endif
+
+		for (; i < end; i++)
+		{
+			bool inside = true;
+			for (const auto& plane : frustum.planes)
+			{
+				float dist = plane.x * centerX[i] + plane.y * centerY[i] + plane.z * centerZ[i] + plane.w;
+				float projected = std::fabs(plane.x) * extentX[i] + std::fabs(plane.y) * extentY[i] + std::fabs(plane.z) * extentZ[i];
+				if (dist + projected < 0.0f)
+				{
+					inside = false;
+					break;
+				}
+			}
+			if (inside)
+			{
+				visible.push_back(i);
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "JobSystem.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Solarium
+{
+
+	struct Frustum
+	{
+		// left, right, bottom, top, near, far; xyz is the inward normal, w the distance
+		glm::vec4 planes[6];
+
+		static Frustum fromMatrix(const glm::mat4& viewProj);
+	};
+
+	class FrustumCuller
+	{
+	public:
+		static constexpr uint32_t BATCH_SIZE = 16384;
+
+		FrustumCuller() = default;
+		FrustumCuller(const FrustumCuller&) = delete;
+		FrustumCuller& operator=(const FrustumCuller&) = delete;
+
+		uint32_t addBounds(glm::vec3 center, float radius, glm::vec3 extents);
+		uint32_t addSphere(glm::vec3 center, float radius) { return addBounds(center, radius, glm::vec3(radius)); }
+		void setBounds(uint32_t index, glm::vec3 center, float radius, glm::vec3 extents);
+		void setSphere(uint32_t index, glm::vec3 center, float radius) { setBounds(index, center, radius, glm::vec3(radius)); }
+		void reserve(size_t count);
+		// Grows or shrinks to count objects; new ones are empty spheres at the origin until they are set
+		void resize(size_t count);
+		void clear();
+		uint32_t size() { return static_cast<uint32_t>(radius.size()); }
+		glm::vec3 getCenter(uint32_t index) { return glm::vec3(centerX[index], centerY[index], centerZ[index]); }
+		float getRadius(uint32_t index) { return radius[index]; }
+
+		// Writes the indices of every object whose bounding sphere/box touches the frustum, in ascending order.
+		// Passing a null job system runs the test on the calling thread.
+		void cullSpheres(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible);
+		void cullBoxes(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible);
+
+	private:
+		enum class BoundsType { SPHERE, BOX };
+
+		void cull(const Frustum& frustum, JobSystem* jobSystem, BoundsType type, std::vector<uint32_t>& visible);
+		void cullSpheresRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible);
+		void cullBoxesRange(const Frustum& frustum, uint32_t begin, uint32_t end, std::vector<uint32_t>& visible);
+
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> radius;
+		std::vector<float> extentX;
+		std::vector<float> extentY;
+		std::vector<float> extentZ;
+		std::vector<std::vector<uint32_t>> batchResults;
+	};
+}
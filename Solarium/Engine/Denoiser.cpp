@@ -0,0 +1,223 @@
+#include "Denoiser.hpp"
+#include "ShaderHelper.hpp"
+
+namespace Solarium
+{
+	// The last iteration has to read PING to write OUTPUT through atrousSets[2]
+	static_assert(Denoiser::ATROUS_ITERATIONS % 2 == 1, "The a-trous passes must end on PING");
+
+	Denoiser::Denoiser(SwapChain* swapChain_, Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		layoutCache = layoutCache_;
+		descriptorAllocator = descriptorAllocator_;
+		pipelineRegistry = pipelineRegistry_;
+	}
+
+	Denoiser::~Denoiser()
+	{
+		cleanup();
+	}
+
+	void Denoiser::createChain(vk::ImageView accumulationView)
+	{
+		createImages();
+		createPipelines();
+		createDescriptorSets(accumulationView);
+		frameParity = 0;
+	}
+
+	void Denoiser::cleanup()
+	{
+		// Pipelines and sets belong to the registry and the allocator
+		temporalPipeline = nullptr;
+		atrousPipeline = nullptr;
+		for (StorageImage& storage : images)
+		{
+			device->device().destroyImageView(storage.view);
+			device->device().destroyImage(storage.image);
+			device->device().freeMemory(storage.memory);
+			storage = StorageImage{};
+		}
+	}
+
+	vk::Format Denoiser::imageFormat(DenoiserImage image)
+	{
+		switch (image)
+		{
+		case POSITION:
+		case PREVIOUS_POSITION:
+			// Half floats are too coarse to tell neighbouring surfaces apart a few units from the origin
+			return vk::Format::eR32G32B32A32Sfloat;
+		case ALBEDO:
+			return vk::Format::eR8G8B8A8Unorm;
+		default:
+			return vk::Format::eR16G16B16A16Sfloat;
+		}
+	}
+
+	void Denoiser::createImages()
+	{
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		vk::CommandBuffer commandBuffer = device->beginSingleTimeCommands();
+		for (uint32_t i = 0; i < DENOISER_IMAGE_COUNT; i++)
+		{
+			DenoiserImage image = static_cast<DenoiserImage>(i);
+			vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+			if (image == OUTPUT)
+			{
+				usage |= vk::ImageUsageFlagBits::eSampled;
+			}
+			vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, imageFormat(image), vk::Extent3D{ swapChain->width(), swapChain->height(), 1 }, 1, 1, vk::SampleCountFlagBits::e1,
+				vk::ImageTiling::eOptimal, usage, vk::SharingMode::eExclusive };
+			device->createImageWithInfo(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, images[i].image, images[i].memory);
+
+			images[i].view = device->device().createImageView(vk::ImageViewCreateInfo{ {}, images[i].image, vk::ImageViewType::e2D, imageInfo.format, {}, subresourceRange });
+			if (!images[i].view)
+			{
+				throw std::runtime_error("Failed to create denoiser image view");
+			}
+
+			// Every image but the output stays in eGeneral. Cleared so the first frame finds no history: a previous
+			// position with w = 0 rejects every reprojected tap.
+			ComputePipeline::prepareStorageImage(commandBuffer, images[i].image, subresourceRange, vk::PipelineStageFlagBits::eTopOfPipe);
+			commandBuffer.clearColorImage(images[i].image, vk::ImageLayout::eGeneral, vk::ClearColorValue{ std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f } }, subresourceRange);
+		}
+		vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, barrier, nullptr, nullptr);
+		// The output rests in eShaderReadOnlyOptimal for the present pass between denoises
+		ComputePipeline::computeToFragmentImageBarrier(commandBuffer, images[OUTPUT].image, subresourceRange);
+		device->endSingleTimeCommands(commandBuffer);
+	}
+
+	void Denoiser::createPipelines()
+	{
+		ShaderHelper temporalShaders(ShaderHelper::findComputeShader("../../../Shaders", "denoise_temporal"), device->device());
+		ShaderHelper atrousShaders(ShaderHelper::findComputeShader("../../../Shaders", "denoise_atrous"), device->device());
+
+		auto build = [&](ShaderHelper& shaders, std::vector<vk::DescriptorSetLayoutBinding>& bindings, size_t pushConstantsSize)
+		{
+			ShaderReflection reflection = shaders.reflect();
+			bindings = reflection.getSetBindings(0);
+			std::vector<vk::PushConstantRange> pushConstantRanges = reflection.getPushConstantRanges();
+			if (pushConstantRanges.size() != 1 || pushConstantRanges[0].offset + pushConstantRanges[0].size > pushConstantsSize)
+			{
+				throw std::runtime_error("Push constant block does not match the denoiser's push constants");
+			}
+
+			ComputePipelineConfigInfo configInfo{};
+			configInfo.shaderStage = shaders.getShaderStages()[0];
+			configInfo.shaderHash = shaders.getShaderHash();
+			configInfo.localSize = reflection.getLocalSize();
+			configInfo.pushConstantRange = pushConstantRanges[0];
+			configInfo.pipelineLayout = layoutCache->createPipelineLayout({ layoutCache->createDescriptorSetLayout(bindings) }, pushConstantRanges);
+			return pipelineRegistry->getComputePipeline(configInfo);
+		};
+		temporalPipeline = build(temporalShaders, temporalBindings, sizeof(DenoiseTemporalPushConstants));
+		atrousPipeline = build(atrousShaders, atrousBindings, sizeof(DenoiseAtrousPushConstants));
+
+		temporalShaders.destroyShaderModules(device->device());
+		atrousShaders.destroyShaderModules(device->device());
+	}
+
+	vk::DescriptorSet Denoiser::writeSet(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, const std::vector<vk::ImageView>& views)
+	{
+		vk::DescriptorSet descriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(bindings));
+		DescriptorTemplate* updateTemplate = layoutCache->getUpdateTemplate(bindings);
+		std::vector<DescriptorInfo> data = updateTemplate->createData();
+		// views is indexed by binding; bindings the compiler stripped are skipped
+		for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+		{
+			data[updateTemplate->slot(binding.binding)].image = vk::DescriptorImageInfo{ nullptr, views[binding.binding], vk::ImageLayout::eGeneral };
+		}
+		updateTemplate->update(descriptorSet, data);
+		return descriptorSet;
+	}
+
+	void Denoiser::createDescriptorSets(vk::ImageView accumulationView)
+	{
+		for (uint32_t parity = 0; parity < 2; parity++)
+		{
+			StorageImage& previousMoments = images[parity == 0 ? MOMENTS_SWAP : MOMENTS];
+			StorageImage& moments = images[parity == 0 ? MOMENTS : MOMENTS_SWAP];
+			temporalSets[parity] = writeSet(temporalBindings, { accumulationView, images[POSITION].view, images[NORMAL].view, images[ALBEDO].view,
+				images[PREVIOUS_POSITION].view, images[PREVIOUS_NORMAL].view, images[HISTORY].view, previousMoments.view, moments.view, images[PING].view });
+		}
+
+		const std::array<std::pair<DenoiserImage, DenoiserImage>, 3> passes{ { { PING, PONG }, { PONG, PING }, { PING, OUTPUT } } };
+		for (size_t i = 0; i < passes.size(); i++)
+		{
+			atrousSets[i] = writeSet(atrousBindings, { images[passes[i].first].view, images[passes[i].second].view, images[POSITION].view, images[NORMAL].view, images[ALBEDO].view });
+		}
+	}
+
+	void Denoiser::copyImage(vk::CommandBuffer commandBuffer, DenoiserImage source, DenoiserImage destination)
+	{
+		vk::ImageSubresourceLayers layers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+		vk::ImageCopy region{ layers, { 0, 0, 0 }, layers, { 0, 0, 0 }, vk::Extent3D{ swapChain->width(), swapChain->height(), 1 } };
+		commandBuffer.copyImage(images[source].image, vk::ImageLayout::eGeneral, images[destination].image, vk::ImageLayout::eGeneral, region);
+	}
+
+	void Denoiser::denoise(vk::CommandBuffer commandBuffer, const glm::mat4& viewProj, const glm::vec3& cameraPosition, uint32_t accumulatedSamples)
+	{
+		// Moving the camera restarts accumulation and the tracer rewrites the G-buffer, so only then does it differ from the previous one
+		bool newGBuffer = accumulatedSamples == 0;
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		ComputePipeline::fragmentToComputeImageBarrier(commandBuffer, images[OUTPUT].image, subresourceRange);
+
+		DenoiseTemporalPushConstants temporalConstants{ previousViewProj, accumulatedSamples };
+		temporalPipeline->bind(commandBuffer);
+		temporalPipeline->bindDescriptorSets(commandBuffer, 0, { temporalSets[frameParity] });
+		temporalPipeline->pushConstants(commandBuffer, &temporalConstants);
+		temporalPipeline->dispatch(commandBuffer, swapChain->width(), swapChain->height());
+		ComputePipeline::memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+
+		// Angle between neighbouring pixels, from the directions through two of them at the centre of the screen
+		glm::mat4 inverseViewProj = glm::inverse(viewProj);
+		auto direction = [&](glm::vec2 ndc)
+		{
+			glm::vec4 target = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+			return glm::normalize(glm::vec3(target) / target.w - cameraPosition);
+		};
+		float pixelWidth = glm::length(direction(glm::vec2(0.0f, 2.0f / swapChain->height())) - direction(glm::vec2(0.0f)));
+
+		atrousPipeline->bind(commandBuffer);
+		for (uint32_t i = 0; i < ATROUS_ITERATIONS; i++)
+		{
+			bool last = i + 1 == ATROUS_ITERATIONS;
+			DenoiseAtrousPushConstants atrousConstants{ glm::vec4(cameraPosition, pixelWidth), 1 << i, last ? 1u : 0u };
+			atrousPipeline->bindDescriptorSets(commandBuffer, 0, { atrousSets[last ? 2 : i % 2] });
+			atrousPipeline->pushConstants(commandBuffer, &atrousConstants);
+			atrousPipeline->dispatch(commandBuffer, swapChain->width(), swapChain->height());
+
+			if (i == 0)
+			{
+				// As in SVGF, the history the next frame reprojects is the first iteration's output: filtered enough
+				// to be stable, not so much that detail is lost for good
+				ComputePipeline::memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+					vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead);
+				copyImage(commandBuffer, PONG, HISTORY);
+				if (newGBuffer)
+				{
+					copyImage(commandBuffer, POSITION, PREVIOUS_POSITION);
+					copyImage(commandBuffer, NORMAL, PREVIOUS_NORMAL);
+				}
+				vk::MemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+				commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, barrier, nullptr, nullptr);
+			}
+			else if (!last)
+			{
+				ComputePipeline::memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+			}
+		}
+
+		ComputePipeline::computeToFragmentImageBarrier(commandBuffer, images[OUTPUT].image, subresourceRange);
+
+		if (newGBuffer)
+		{
+			previousViewProj = viewProj;
+		}
+		frameParity ^= 1;
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineRegistry.hpp"
+#include "ComputePipeline.hpp"
+
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+namespace Solarium
+{
+	// Push constants of denoise_temporal.comp
+	struct DenoiseTemporalPushConstants {
+		glm::mat4 previousViewProj;
+		uint32_t accumulatedSamples;
+	};
+
+	// Push constants of denoise_atrous.comp
+	struct DenoiseAtrousPushConstants {
+		// xyz: camera position, w: width a pixel covers one unit away from the camera
+		glm::vec4 camera;
+		int32_t stepSize;
+		uint32_t remodulate;
+	};
+
+	// Spatiotemporal variance-guided filter (SVGF) for the RayTracer's accumulation image, so a handful of samples
+	// per pixel already give a usable picture. Runs as compute after each trace: a temporal pass reprojects the
+	// filtered illumination of earlier frames through the G-buffer the tracer writes, then ATROUS_ITERATIONS
+	// edge-aware wavelet passes blur what noise remains along surfaces.
+	class Denoiser
+	{
+	public:
+		static constexpr uint32_t ATROUS_ITERATIONS = 5;
+		// Past this many samples the accumulation image is clean enough on its own and filtering would only blur it
+		static constexpr uint32_t MAX_DENOISED_SAMPLES = 256;
+
+		enum GBufferTarget {
+			GBUFFER_POSITION,
+			GBUFFER_NORMAL,
+			GBUFFER_ALBEDO,
+			GBUFFER_TARGET_COUNT
+		};
+
+		Denoiser(SwapChain* swapChain_, Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_);
+		~Denoiser();
+		Denoiser(const Denoiser&) = delete;
+		Denoiser& operator=(const Denoiser&) = delete;
+
+		// The accumulation image is the tracer's, in eGeneral and sized like the swapchain
+		void createChain(vk::ImageView accumulationView);
+		void cleanup();
+		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
+
+		// For the storage image bindings the tracer writes the G-buffer through
+		vk::DescriptorImageInfo getGBufferInfo(GBufferTarget target) { return vk::DescriptorImageInfo{ nullptr, images[target].view, vk::ImageLayout::eGeneral }; }
+		// The denoised color, in eShaderReadOnlyOptimal outside of denoise
+		vk::DescriptorImageInfo getOutputInfo(vk::Sampler sampler) { return vk::DescriptorImageInfo{ sampler, images[OUTPUT].view, vk::ImageLayout::eShaderReadOnlyOptimal }; }
+
+		// Records the passes over this frame's trace; outside of any render pass, after the trace's writes are visible
+		// to compute. The output is left ready for the fragment shader to sample. accumulatedSamples counts the
+		// samples in the accumulation image before this frame's.
+		void denoise(vk::CommandBuffer commandBuffer, const glm::mat4& viewProj, const glm::vec3& cameraPosition, uint32_t accumulatedSamples);
+
+	private:
+		// G-buffer first, in GBufferTarget order
+		enum DenoiserImage {
+			POSITION,
+			NORMAL,
+			ALBEDO,
+			PREVIOUS_POSITION,
+			PREVIOUS_NORMAL,
+			HISTORY,
+			MOMENTS,
+			MOMENTS_SWAP,
+			PING,
+			PONG,
+			OUTPUT,
+			DENOISER_IMAGE_COUNT
+		};
+
+		struct StorageImage {
+			vk::Image image;
+			vk::DeviceMemory memory;
+			vk::ImageView view;
+		};
+
+		void createImages();
+		void createPipelines();
+		void createDescriptorSets(vk::ImageView accumulationView);
+		vk::DescriptorSet writeSet(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, const std::vector<vk::ImageView>& views);
+		void copyImage(vk::CommandBuffer commandBuffer, DenoiserImage source, DenoiserImage destination);
+		static vk::Format imageFormat(DenoiserImage image);
+
+		Device* device;
+		SwapChain* swapChain;
+		DescriptorLayoutCache* layoutCache;
+		DescriptorAllocator* descriptorAllocator;
+		PipelineRegistry* pipelineRegistry;
+
+		std::array<StorageImage, DENOISER_IMAGE_COUNT> images{};
+
+		// Owned by pipelineRegistry
+		ComputePipeline* temporalPipeline = nullptr;
+		ComputePipeline* atrousPipeline = nullptr;
+		std::vector<vk::DescriptorSetLayoutBinding> temporalBindings;
+		std::vector<vk::DescriptorSetLayoutBinding> atrousBindings;
+		// The moments ping-pong between frames, so there is one temporal set for each direction
+		std::array<vk::DescriptorSet, 2> temporalSets;
+		// PING to PONG, PONG to PING and PING to OUTPUT
+		std::array<vk::DescriptorSet, 3> atrousSets;
+
+		// The camera the previous G-buffer was traced from
+		glm::mat4 previousViewProj{ 1.0f };
+		uint32_t frameParity = 0;
+	};
+}
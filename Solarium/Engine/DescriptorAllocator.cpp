@@ -0,0 +1,121 @@
+#include "DescriptorAllocator.hpp"
+#include <algorithm>
+#include <array>
+
+namespace Solarium
+{
+	namespace
+	{
+		struct PoolRatio
+		{
+			vk::DescriptorType type;
+			float ratio;
+		};
+
+		// Descriptors of each type per set, weighted towards what materials and passes typically bind
+		const std::array<PoolRatio, 6> POOL_RATIOS{
+			PoolRatio{ vk::DescriptorType::eUniformBuffer, 2.0f },
+			PoolRatio{ vk::DescriptorType::eCombinedImageSampler, 4.0f },
+			PoolRatio{ vk::DescriptorType::eStorageBuffer, 2.0f },
+			PoolRatio{ vk::DescriptorType::eUniformBufferDynamic, 1.0f },
+			PoolRatio{ vk::DescriptorType::eStorageImage, 1.0f },
+			PoolRatio{ vk::DescriptorType::eSampledImage, 1.0f } };
+	}
+
+	DescriptorAllocator::DescriptorAllocator(Device* device_, uint32_t initialSetsPerPool_)
+	{
+		device = device_;
+		initialSetsPerPool = initialSetsPerPool_;
+		setsPerPool = initialSetsPerPool_;
+	}
+
+	DescriptorAllocator::~DescriptorAllocator()
+	{
+		cleanup();
+	}
+
+	void DescriptorAllocator::cleanup()
+	{
+		for (vk::DescriptorPool pool : usedPools)
+		{
+			device->device().destroyDescriptorPool(pool);
+		}
+		for (vk::DescriptorPool pool : freePools)
+		{
+			device->device().destroyDescriptorPool(pool);
+		}
+		usedPools.clear();
+		freePools.clear();
+		currentPool = nullptr;
+		setsPerPool = initialSetsPerPool;
+	}
+
+	vk::DescriptorSet DescriptorAllocator::allocate(vk::DescriptorSetLayout layout)
+	{
+		if (!currentPool)
+		{
+			currentPool = grabPool();
+		}
+
+		vk::DescriptorSetAllocateInfo allocInfo{ currentPool, layout };
+		try
+		{
+			return device->device().allocateDescriptorSets(allocInfo)[0];
+		}
+		catch (vk::OutOfPoolMemoryError&)
+		{
+		}
+		catch (vk::FragmentedPoolError&)
+		{
+		}
+
+		// The current pool is exhausted; chain a fresh one and retry once
+		currentPool = grabPool();
+		allocInfo.descriptorPool = currentPool;
+		std::vector<vk::DescriptorSet> sets = device->device().allocateDescriptorSets(allocInfo);
+		if (sets.empty() || !sets[0])
+		{
+			throw std::runtime_error("Failed to allocate descriptor set");
+		}
+		return sets[0];
+	}
+
+	void DescriptorAllocator::reset()
+	{
+		for (vk::DescriptorPool pool : usedPools)
+		{
+			device->device().resetDescriptorPool(pool);
+			freePools.push_back(pool);
+		}
+		usedPools.clear();
+		currentPool = nullptr;
+	}
+
+	vk::DescriptorPool DescriptorAllocator::grabPool()
+	{
+		vk::DescriptorPool pool;
+		if (!freePools.empty())
+		{
+			pool = freePools.back();
+			freePools.pop_back();
+		}
+		else
+		{
+			std::vector<vk::DescriptorPoolSize> poolSizes;
+			for (const PoolRatio& ratio : POOL_RATIOS)
+			{
+				poolSizes.push_back(vk::DescriptorPoolSize{ ratio.type, static_cast<uint32_t>(ratio.ratio * setsPerPool) });
+			}
+			vk::DescriptorPoolCreateInfo poolInfo{ {}, setsPerPool, poolSizes };
+			pool = device->device().createDescriptorPool(poolInfo);
+			if (!pool)
+			{
+				throw std::runtime_error("Failed to create descriptor pool");
+			}
+			// Each new pool is larger so a growing workload settles on a handful of pools
+			setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+		}
+		usedPools.push_back(pool);
+		return pool;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+
+#include <vector>
+
+namespace Solarium
+{
+
+	// Hands out descriptor sets from a chain of pools. When the current pool runs out a new, larger one is
+	// chained on, so callers never size pools up front. reset() recycles every pool at once, which makes a
+	// per-frame allocator a cheap home for transient sets.
+	class DescriptorAllocator
+	{
+	public:
+		DescriptorAllocator(Device* device_, uint32_t initialSetsPerPool_ = 64);
+		~DescriptorAllocator();
+		DescriptorAllocator(const DescriptorAllocator&) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+		void cleanup();
+		void update(Device* device_) { device = device_; }
+
+		vk::DescriptorSet allocate(vk::DescriptorSetLayout layout);
+		// Every set handed out so far becomes invalid; the pools are kept for reuse
+		void reset();
+
+	private:
+		static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+		vk::DescriptorPool grabPool();
+
+		Device* device;
+		uint32_t initialSetsPerPool;
+		uint32_t setsPerPool;
+		vk::DescriptorPool currentPool;
+		std::vector<vk::DescriptorPool> usedPools;
+		std::vector<vk::DescriptorPool> freePools;
+	};
+}
@@ -0,0 +1,168 @@
+#include "DescriptorLayoutCache.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace Solarium
+{
+	DescriptorLayoutCache::DescriptorLayoutCache(Device* device_)
+	{
+		device = device_;
+	}
+
+	DescriptorLayoutCache::~DescriptorLayoutCache()
+	{
+		cleanup();
+	}
+
+	void DescriptorLayoutCache::cleanup()
+	{
+		for (auto& entry : pipelineLayouts)
+		{
+			device->device().destroyPipelineLayout(entry.second);
+		}
+		pipelineLayouts.clear();
+		for (auto& entry : layouts)
+		{
+			entry.second.updateTemplate.reset();
+			device->device().destroyDescriptorSetLayout(entry.second.layout);
+		}
+		layouts.clear();
+	}
+
+	vk::DescriptorSetLayout DescriptorLayoutCache::createDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags, const std::vector<vk::DescriptorBindingFlags>& bindingFlags)
+	{
+		return findOrCreate(bindings, flags, bindingFlags).second.layout;
+	}
+
+	DescriptorTemplate* DescriptorLayoutCache::getUpdateTemplate(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags, const std::vector<vk::DescriptorBindingFlags>& bindingFlags)
+	{
+		auto& entry = findOrCreate(bindings, flags, bindingFlags);
+		if (!entry.second.updateTemplate)
+		{
+			entry.second.updateTemplate = std::make_unique<DescriptorTemplate>(device, entry.second.layout, entry.first.bindings);
+		}
+		return entry.second.updateTemplate.get();
+	}
+
+	std::pair<const DescriptorLayoutCache::LayoutKey, DescriptorLayoutCache::CachedLayout>& DescriptorLayoutCache::findOrCreate(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags, const std::vector<vk::DescriptorBindingFlags>& bindingFlags)
+	{
+		for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+		{
+			if (binding.pImmutableSamplers)
+			{
+				throw std::runtime_error("Immutable samplers are not supported by the layout cache");
+			}
+		}
+
+		// Sorting by binding number makes the key independent of the order the bindings were declared in
+		std::vector<size_t> order(bindings.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&bindings](size_t a, size_t b) { return bindings[a].binding < bindings[b].binding; });
+
+		LayoutKey key{ flags };
+		for (size_t index : order)
+		{
+			key.bindings.push_back(bindings[index]);
+			if (!bindingFlags.empty())
+			{
+				key.bindingFlags.push_back(bindingFlags[index]);
+			}
+		}
+
+		auto it = layouts.find(key);
+		if (it != layouts.end())
+		{
+			return *it;
+		}
+
+		vk::DescriptorSetLayoutCreateInfo layoutInfo{ flags, key.bindings };
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{ key.bindingFlags };
+		if (!key.bindingFlags.empty())
+		{
+			layoutInfo.pNext = &bindingFlagsInfo;
+		}
+
+		vk::DescriptorSetLayout layout = device->device().createDescriptorSetLayout(layoutInfo);
+		if (!layout)
+		{
+			throw std::runtime_error("Failed to create descriptor set layout");
+		}
+		return *layouts.emplace(std::move(key), CachedLayout{ layout }).first;
+	}
+
+	vk::PipelineLayout DescriptorLayoutCache::createPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+	{
+		std::vector<uint64_t> key;
+		for (vk::DescriptorSetLayout setLayout : setLayouts)
+		{
+			key.push_back((uint64_t)static_cast<VkDescriptorSetLayout>(setLayout));
+		}
+		for (const vk::PushConstantRange& range : pushConstantRanges)
+		{
+			key.push_back((static_cast<uint64_t>(static_cast<VkShaderStageFlags>(range.stageFlags)) << 32) | range.offset);
+			key.push_back(range.size);
+		}
+
+		auto it = pipelineLayouts.find(key);
+		if (it != pipelineLayouts.end())
+		{
+			return it->second;
+		}
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{ {}, setLayouts, pushConstantRanges };
+		vk::PipelineLayout pipelineLayout = device->device().createPipelineLayout(pipelineLayoutInfo);
+		if (!pipelineLayout)
+		{
+			throw std::runtime_error("Failed to create pipeline layout");
+		}
+		pipelineLayouts.emplace(std::move(key), pipelineLayout);
+		return pipelineLayout;
+	}
+
+	bool DescriptorLayoutCache::LayoutKey::operator==(const LayoutKey& other) const
+	{
+		if (flags != other.flags || bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < bindings.size(); i++)
+		{
+			const vk::DescriptorSetLayoutBinding& a = bindings[i];
+			const vk::DescriptorSetLayoutBinding& b = other.bindings[i];
+			if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	size_t DescriptorLayoutCache::PipelineLayoutKeyHash::operator()(const std::vector<uint64_t>& key) const
+	{
+		size_t hash = 0;
+		for (uint64_t value : key)
+		{
+			hash ^= std::hash<uint64_t>{}(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+		return hash;
+	}
+
+	size_t DescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey& key) const
+	{
+		auto combine = [](size_t seed, size_t value) { return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2)); };
+
+		size_t hash = combine(0, static_cast<VkDescriptorSetLayoutCreateFlags>(key.flags));
+		for (size_t i = 0; i < key.bindings.size(); i++)
+		{
+			const vk::DescriptorSetLayoutBinding& binding = key.bindings[i];
+			size_t packed = binding.binding | (static_cast<size_t>(binding.descriptorType) << 8) | (static_cast<size_t>(static_cast<VkShaderStageFlags>(binding.stageFlags)) << 16);
+			hash = combine(hash, packed);
+			hash = combine(hash, binding.descriptorCount);
+			if (!key.bindingFlags.empty())
+			{
+				hash = combine(hash, static_cast<VkDescriptorBindingFlags>(key.bindingFlags[i]));
+			}
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "DescriptorTemplate.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Solarium
+{
+
+	// Deduplicates descriptor set and pipeline layouts: equal descriptions map to one layout owned by the cache
+	class DescriptorLayoutCache
+	{
+	public:
+		DescriptorLayoutCache(Device* device_);
+		~DescriptorLayoutCache();
+		DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+		DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+		void cleanup();
+		void update(Device* device_) { device = device_; }
+
+		// Binding order does not matter. bindingFlags, when given, has one entry per binding in the order passed in.
+		// Immutable samplers are not supported.
+		vk::DescriptorSetLayout createDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags = {}, const std::vector<vk::DescriptorBindingFlags>& bindingFlags = {});
+		// Update template for the same layout, built on first use and owned by the cache
+		DescriptorTemplate* getUpdateTemplate(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags = {}, const std::vector<vk::DescriptorBindingFlags>& bindingFlags = {});
+
+		// Pipelines built from the same set layouts and push constant ranges share one pipeline layout
+		vk::PipelineLayout createPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges);
+
+		size_t size() { return layouts.size(); }
+
+	private:
+		struct LayoutKey
+		{
+			vk::DescriptorSetLayoutCreateFlags flags;
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;
+			std::vector<vk::DescriptorBindingFlags> bindingFlags;
+
+			bool operator==(const LayoutKey& other) const;
+		};
+
+		struct LayoutKeyHash
+		{
+			size_t operator()(const LayoutKey& key) const;
+		};
+
+		struct CachedLayout
+		{
+			vk::DescriptorSetLayout layout;
+			std::unique_ptr<DescriptorTemplate> updateTemplate;
+		};
+
+		std::pair<const LayoutKey, CachedLayout>& findOrCreate(const std::vector<vk::DescriptorSetLayoutBinding>& bindings, vk::DescriptorSetLayoutCreateFlags flags, const std::vector<vk::DescriptorBindingFlags>& bindingFlags);
+
+		// Set layout handles and push constant ranges flattened into one list
+		struct PipelineLayoutKeyHash
+		{
+			size_t operator()(const std::vector<uint64_t>& key) const;
+		};
+
+		Device* device;
+		std::unordered_map<LayoutKey, CachedLayout, LayoutKeyHash> layouts;
+		std::unordered_map<std::vector<uint64_t>, vk::PipelineLayout, PipelineLayoutKeyHash> pipelineLayouts;
+	};
+}
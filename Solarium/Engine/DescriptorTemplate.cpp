@@ -0,0 +1,58 @@
+#include "DescriptorTemplate.hpp"
+
+namespace Solarium
+{
+	DescriptorTemplate::DescriptorTemplate(Device* device_, vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		device = device_;
+
+		std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+		for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+		{
+			if (binding.descriptorCount == 0)
+			{
+				continue;
+			}
+			if (binding.descriptorType == vk::DescriptorType::eInlineUniformBlockEXT || binding.descriptorType == vk::DescriptorType::eAccelerationStructureKHR)
+			{
+				throw std::runtime_error("Descriptor type is not supported by update templates");
+			}
+			bindingSlots.push_back(BindingSlots{ binding.binding, slotCount, binding.descriptorCount });
+			entries.push_back(vk::DescriptorUpdateTemplateEntry{ binding.binding, 0, binding.descriptorCount, binding.descriptorType, slotCount * sizeof(DescriptorInfo), sizeof(DescriptorInfo) });
+			slotCount += binding.descriptorCount;
+		}
+
+		vk::DescriptorUpdateTemplateCreateInfo templateInfo{ {}, entries, vk::DescriptorUpdateTemplateType::eDescriptorSet, layout };
+		updateTemplate = device->device().createDescriptorUpdateTemplate(templateInfo);
+		if (!updateTemplate)
+		{
+			throw std::runtime_error("Failed to create descriptor update template");
+		}
+	}
+
+	DescriptorTemplate::~DescriptorTemplate()
+	{
+		device->device().destroyDescriptorUpdateTemplate(updateTemplate);
+	}
+
+	uint32_t DescriptorTemplate::slot(uint32_t binding, uint32_t arrayElement)
+	{
+		for (const BindingSlots& slots : bindingSlots)
+		{
+			if (slots.binding == binding && arrayElement < slots.count)
+			{
+				return slots.firstSlot + arrayElement;
+			}
+		}
+		throw std::runtime_error("Binding is not part of the descriptor template");
+	}
+
+	void DescriptorTemplate::update(vk::DescriptorSet set, const std::vector<DescriptorInfo>& data)
+	{
+		if (data.size() < slotCount)
+		{
+			throw std::runtime_error("Descriptor template data is too small");
+		}
+		device->device().updateDescriptorSetWithTemplate(set, updateTemplate, data.data());
+	}
+}
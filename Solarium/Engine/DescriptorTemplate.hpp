@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+
+#include <vector>
+
+namespace Solarium
+{
+
+	// One descriptor of any type as vkUpdateDescriptorSetWithTemplate reads it
+	union DescriptorInfo
+	{
+		DescriptorInfo() : buffer() {}
+
+		vk::DescriptorImageInfo image;
+		vk::DescriptorBufferInfo buffer;
+		vk::BufferView texelBuffer;
+	};
+
+	// A descriptor update template generated from a set layout's bindings. Every descriptor in the set gets one
+	// DescriptorInfo slot, in binding order, so a whole set is written from one packed array in a single call.
+	class DescriptorTemplate
+	{
+	public:
+		// bindings must be sorted by binding number, as DescriptorLayoutCache stores them
+		DescriptorTemplate(Device* device_, vk::DescriptorSetLayout layout, const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+		~DescriptorTemplate();
+		DescriptorTemplate(const DescriptorTemplate&) = delete;
+		DescriptorTemplate& operator=(const DescriptorTemplate&) = delete;
+
+		// Zeroed data sized for one set
+		std::vector<DescriptorInfo> createData() { return std::vector<DescriptorInfo>(slotCount); }
+		uint32_t slot(uint32_t binding, uint32_t arrayElement = 0);
+		void update(vk::DescriptorSet set, const std::vector<DescriptorInfo>& data);
+
+		vk::DescriptorUpdateTemplate getUpdateTemplate() { return updateTemplate; }
+
+	private:
+		struct BindingSlots
+		{
+			uint32_t binding;
+			uint32_t firstSlot;
+			uint32_t count;
+		};
+
+		Device* device;
+		vk::DescriptorUpdateTemplate updateTemplate;
+		std::vector<BindingSlots> bindingSlots;
+		uint32_t slotCount = 0;
+	};
+}
@@ -1,4 +1,5 @@
 #include "Device.hpp"
+#include "GraphicsPipelineLibrary.hpp"
 // std headers
 #include <cstring>
 #include <iostream>
@@ -131,7 +132,7 @@ namespace Solarium {
 
 		if (!physicalDevice_) 
 		{
-			throw std::runtime_error("failed to find a suitable GPU!");
+			throw std::runtime_error("failed to find a suitable GPU! Solarium needs Vulkan 1.2 with descriptor indexing, see README.md");
 		}
 
 		properties = physicalDevice_.getProperties();
@@ -157,15 +158,42 @@ namespace Solarium {
 
 		vk::PhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.textureCompressionBC = physicalDevice_.getFeatures().textureCompressionBC;
+		// Needed for r16f storage images, such as the baked distance field
+		deviceFeatures.shaderStorageImageExtendedFormats = physicalDevice_.getFeatures().shaderStorageImageExtendedFormats;
+		enabledFeatures = deviceFeatures;
+
+		// Everything the bindless table needs, checked for in supportsBindlessDescriptors
+		vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+		enabledDescriptorIndexingFeatures = descriptorIndexingFeatures;
+
+		std::vector<const char*> extensions = deviceExtensions;
+		graphicsPipelineLibraryEnabled = supportsGraphicsPipelineLibrary(physicalDevice_);
+		GraphicsPipelineLibrary::Features graphicsPipelineLibraryFeatures;
+		if (graphicsPipelineLibraryEnabled)
+		{
+			graphicsPipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+			descriptorIndexingFeatures.pNext = &graphicsPipelineLibraryFeatures;
+			extensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+			extensions.push_back(GraphicsPipelineLibrary::EXTENSION_NAME);
+		}
 
 		vk::DeviceCreateInfo createInfo = {};
+		createInfo.pNext = &descriptorIndexingFeatures;
 
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
 		createInfo.pEnabledFeatures = &deviceFeatures;
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		createInfo.ppEnabledExtensionNames = extensions.data();
 
 		if (enableValidationLayers) 
 		{
@@ -218,7 +246,41 @@ namespace Solarium {
 		vk::PhysicalDeviceFeatures supportedFeatures = device.getFeatures();
 
 		return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-			supportedFeatures.samplerAnisotropy;
+			supportedFeatures.samplerAnisotropy && supportsBindlessDescriptors(device);
+	}
+
+	bool Device::supportsBindlessDescriptors(vk::PhysicalDevice device)
+	{
+		if (device.getProperties().apiVersion < VK_API_VERSION_1_2)
+		{
+			return false;
+		}
+
+		auto features = device.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorIndexingFeatures>();
+		const vk::PhysicalDeviceDescriptorIndexingFeatures& indexing = features.get<vk::PhysicalDeviceDescriptorIndexingFeatures>();
+		return indexing.runtimeDescriptorArray && indexing.descriptorBindingPartiallyBound &&
+			indexing.descriptorBindingUpdateUnusedWhilePending &&
+			indexing.descriptorBindingSampledImageUpdateAfterBind && indexing.descriptorBindingStorageBufferUpdateAfterBind &&
+			indexing.shaderSampledImageArrayNonUniformIndexing && indexing.shaderStorageBufferArrayNonUniformIndexing;
+	}
+
+	bool Device::supportsGraphicsPipelineLibrary(vk::PhysicalDevice device)
+	{
+		std::set<std::string> requiredExtensions{ VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, GraphicsPipelineLibrary::EXTENSION_NAME };
+		for (const auto& extension : device.enumerateDeviceExtensionProperties())
+		{
+			requiredExtensions.erase(extension.extensionName);
+		}
+		if (!requiredExtensions.empty())
+		{
+			return false;
+		}
+
+		// Queried through the C entry point, as vk::PhysicalDeviceFeatures2 chains only structures vulkan.hpp knows
+		GraphicsPipelineLibrary::Features libraryFeatures;
+		VkPhysicalDeviceFeatures2 features{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &libraryFeatures };
+		vkGetPhysicalDeviceFeatures2(device, &features);
+		return libraryFeatures.graphicsPipelineLibrary;
 	}
 
 	void Device::populateDebugMessengerCreateInfo(
@@ -336,7 +398,8 @@ namespace Solarium {
 		int i = 0;
 		for (const auto& queueFamily : queueFamilies) 
 		{
-			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+			// Compute work is recorded into the same command buffers as drawing, so the family must support both
+			if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute))
 			{
 				indices.graphicsFamily = i;
 				indices.graphicsFamilyHasValue = true;
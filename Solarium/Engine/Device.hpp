@@ -76,6 +76,10 @@ namespace Solarium {
 			vk::DeviceMemory& imageMemory);
 
 		vk::PhysicalDeviceProperties properties;
+		vk::PhysicalDeviceFeatures enabledFeatures;
+		vk::PhysicalDeviceDescriptorIndexingFeatures enabledDescriptorIndexingFeatures;
+		// VK_EXT_graphics_pipeline_library is enabled, see PipelineRegistry
+		bool graphicsPipelineLibraryEnabled = false;
 
 	private:
 		void createInstance();
@@ -87,6 +91,8 @@ namespace Solarium {
 
 		// helper functions
 		bool isDeviceSuitable(vk::PhysicalDevice device);
+		bool supportsBindlessDescriptors(vk::PhysicalDevice device);
+		bool supportsGraphicsPipelineLibrary(vk::PhysicalDevice device);
 		std::vector<const char*> getRequiredExtensions();
 		bool checkValidationLayerSupport();
 		QueueFamilyIndices findQueueFamilies(vk::PhysicalDevice device);
@@ -0,0 +1,119 @@
+#include "DistanceField.hpp"
+#include "ShaderHelper.hpp"
+#include "Logger.hpp"
+
+namespace Solarium
+{
+	DistanceField::DistanceField(Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, uint32_t resolution_)
+	{
+		device = device_;
+		layoutCache = layoutCache_;
+		descriptorAllocator = descriptorAllocator_;
+		pipelineRegistry = pipelineRegistry_;
+		resolution = resolution_;
+	}
+
+	DistanceField::~DistanceField()
+	{
+		cleanup();
+	}
+
+	void DistanceField::createChain()
+	{
+		baked = supportsBaking();
+		if (!baked)
+		{
+			Logger::Log("r16f storage images are not supported, ray marching without the baked distance field");
+		}
+
+		// Linear filtering of r16f is required of every device, only storing it is optional
+		uint32_t size = baked ? resolution : 1;
+		vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eSampled;
+		if (baked)
+		{
+			usage |= vk::ImageUsageFlagBits::eStorage;
+		}
+		vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e3D, FORMAT, vk::Extent3D{ size, size, size }, 1, 1, vk::SampleCountFlagBits::e1,
+			vk::ImageTiling::eOptimal, usage, vk::SharingMode::eExclusive };
+		device->createImageWithInfo(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, image, imageMemory);
+
+		imageView = device->device().createImageView(vk::ImageViewCreateInfo{ {}, image, vk::ImageViewType::e3D, FORMAT, {}, { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } });
+		if (!imageView)
+		{
+			throw std::runtime_error("Failed to create distance field image view");
+		}
+
+		vk::SamplerCreateInfo samplerInfo{ {}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eNearest,
+			vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge };
+		sampler = device->device().createSampler(samplerInfo);
+		if (!sampler)
+		{
+			throw std::runtime_error("Failed to create distance field sampler");
+		}
+
+		bake();
+	}
+
+	void DistanceField::cleanup()
+	{
+		device->device().destroySampler(sampler);
+		device->device().destroyImageView(imageView);
+		device->device().destroyImage(image);
+		device->device().freeMemory(imageMemory);
+		sampler = nullptr;
+		imageView = nullptr;
+		image = nullptr;
+		imageMemory = nullptr;
+		baked = false;
+	}
+
+	bool DistanceField::supportsBaking()
+	{
+		vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eStorageImage | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		return device->enabledFeatures.shaderStorageImageExtendedFormats && (device->physicalDevice().getFormatProperties(FORMAT).optimalTilingFeatures & required) == required;
+	}
+
+	void DistanceField::bake()
+	{
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		vk::CommandBuffer commandBuffer = device->beginSingleTimeCommands();
+
+		ShaderHelper* bakeShaders = nullptr;
+		if (baked)
+		{
+			bakeShaders = new ShaderHelper(ShaderHelper::findComputeShader("../../../Shaders", "sdf_bake"), device->device());
+			ShaderReflection reflection = bakeShaders->reflect();
+			std::vector<vk::DescriptorSetLayoutBinding> bindings = reflection.getSetBindings(0);
+
+			ComputePipelineConfigInfo configInfo{};
+			configInfo.shaderStage = bakeShaders->getShaderStages()[0];
+			configInfo.shaderHash = bakeShaders->getShaderHash();
+			configInfo.localSize = reflection.getLocalSize();
+			configInfo.pipelineLayout = layoutCache->createPipelineLayout({ layoutCache->createDescriptorSetLayout(bindings) }, {});
+			ComputePipeline* bakePipeline = pipelineRegistry->getComputePipeline(configInfo);
+
+			vk::DescriptorSet descriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(bindings));
+			DescriptorTemplate* updateTemplate = layoutCache->getUpdateTemplate(bindings);
+			std::vector<DescriptorInfo> descriptorData = updateTemplate->createData();
+			descriptorData[updateTemplate->slot(0)].image = vk::DescriptorImageInfo{ nullptr, imageView, vk::ImageLayout::eGeneral };
+			updateTemplate->update(descriptorSet, descriptorData);
+
+			ComputePipeline::prepareStorageImage(commandBuffer, image, subresourceRange, vk::PipelineStageFlagBits::eTopOfPipe);
+			bakePipeline->bind(commandBuffer);
+			bakePipeline->bindDescriptorSets(commandBuffer, 0, { descriptorSet });
+			bakePipeline->dispatch(commandBuffer, resolution, resolution, resolution);
+		}
+
+		// From here on the volume is only sampled, by compute
+		vk::ImageMemoryBarrier barrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead, baked ? vk::ImageLayout::eGeneral : vk::ImageLayout::eUndefined,
+			vk::ImageLayout::eShaderReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, subresourceRange };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, nullptr, nullptr, barrier);
+		device->endSingleTimeCommands(commandBuffer);
+
+		if (bakeShaders)
+		{
+			bakeShaders->destroyShaderModules(device->device());
+			delete bakeShaders;
+		}
+	}
+}
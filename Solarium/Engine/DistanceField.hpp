@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineRegistry.hpp"
+
+namespace Solarium
+{
+
+	// The planet's distance estimator baked into a 3D texture by sdf_bake.comp over the bounds declared in planet.glsl.
+	// The ray marcher steps by the filtered volume far from surfaces, which costs one texture fetch instead of the
+	// estimator's noise octaves, and only evaluates the estimator near them.
+	class DistanceField
+	{
+	public:
+		static constexpr uint32_t DEFAULT_RESOLUTION = 128;
+		static constexpr vk::Format FORMAT = vk::Format::eR16Sfloat;
+
+		DistanceField(Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, uint32_t resolution_ = DEFAULT_RESOLUTION);
+		~DistanceField();
+		DistanceField(const DistanceField&) = delete;
+		DistanceField& operator=(const DistanceField&) = delete;
+
+		// Creates the volume and bakes it, waiting for the bake to finish
+		void createChain();
+		void cleanup();
+		void update(Device* device_) { device = device_; }
+
+		// False when the device cannot store FORMAT from a shader; the volume is then a placeholder that must not be sampled
+		bool isBaked() { return baked; }
+		// For a combined image sampler; valid, if not baked, either way
+		vk::DescriptorImageInfo getDescriptorInfo() { return vk::DescriptorImageInfo{ sampler, imageView, vk::ImageLayout::eShaderReadOnlyOptimal }; }
+
+	private:
+		bool supportsBaking();
+		void bake();
+
+		Device* device;
+		DescriptorLayoutCache* layoutCache;
+		DescriptorAllocator* descriptorAllocator;
+		PipelineRegistry* pipelineRegistry;
+		uint32_t resolution;
+		bool baked = false;
+
+		vk::Image image;
+		vk::DeviceMemory imageMemory;
+		vk::ImageView imageView;
+		vk::Sampler sampler;
+	};
+}
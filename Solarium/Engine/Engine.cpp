@@ -1,4 +1,5 @@
 #include "Engine.hpp"
+
 namespace Solarium
 {
 
@@ -11,35 +12,68 @@ namespace Solarium
 	{
 		Solarium::Logger::Log("INITIALIZING");
 		_platform = new Platform(applicationName, width, height);
+		jobSystem = new JobSystem();
 		glfwSetFramebufferSizeCallback(_platform->GetWindow(), framebufferResizeCallback);
 		
 		device = new Device{ *_platform };
 		swapChain = new SwapChain(*device, _platform->getExtent());
-		uniformBufferObject = new UBO(swapChain, device);
+		descriptorLayoutCache = new DescriptorLayoutCache(device);
+		descriptorAllocator = new DescriptorAllocator(device);
+		pipelineRegistry = new PipelineRegistry(device, jobSystem);
+		distanceField = new DistanceField(device, descriptorLayoutCache, descriptorAllocator, pipelineRegistry);
+		noiseCache = new NoiseCache(device, descriptorLayoutCache, descriptorAllocator, pipelineRegistry);
+		rayTracer = new RayTracer(swapChain, device, descriptorLayoutCache, descriptorAllocator, pipelineRegistry, distanceField, noiseCache, ShaderQuality::forTier(qualityTier));
+		addSceneBodies(*rayTracer->getBodies());
+		uniformBufferObject = new UBO(swapChain, device, descriptorLayoutCache, descriptorAllocator);
 		texture = new Texture(swapChain, device);
+		textureStreamer = new TextureStreamer(swapChain, device, jobSystem);
+		bindlessTable = new BindlessTable(swapChain, device);
 		vertexBuffer = new VertexBuffer(device);
+		instanceBuffer = new InstanceBuffer(swapChain, device, MAX_INSTANCES);
+		scene = new Scene();
+		cubeEntity = scene->createEntity();
+		float meshRadius = 0.0f;
+		for (const Vertex& vertex : vertexBuffer->vertices)
+		{
+			meshRadius = std::max(meshRadius, glm::length(vertex.pos));
+		}
+		scene->setBoundingRadius(cubeEntity, meshRadius);
 		texture->createImageViews();
+		bindlessTable->createChain();
+		pipelineRegistry->createChain();
 		createPipelineLayout();
 		createPipeline();
-		texture->createChain();
+		distanceField->createChain();
+		noiseCache->createChain();
+		rayTracer->createChain();
+		textureStreamer->createChain();
+		materialTexture = textureStreamer->load("textures/textures.ktx2", "textures/textures.jpg");
 		vertexBuffer->createChain();
-		uniformBufferObject->createChain(texture->getTextureSampler(), texture->getTextureImageView());
+		instanceBuffer->createChain();
+		uniformBufferObject->createChain();
 		createCommandBuffers();
+		createFrameDescriptorAllocators();
 	}
 
 	Engine::~Engine()
 	{
 		cleanupSwapChain();
 
-		device->device().destroySampler(texture->getTextureSampler());
-		device->device().destroyImageView(texture->getTextureImageView());
-		device->device().destroyImage(texture->getTextureImage());
-		device->device().freeMemory(texture->getTextureImageMemory());
-		device->device().destroyDescriptorSetLayout(uniformBufferObject->getDescriptorSetLayout());
 		device->device().destroyBuffer(vertexBuffer->getIndexBuffer());
 		device->device().freeMemory(texture->getIndexBufferMemory());
 		device->device().destroyBuffer(vertexBuffer->getVertexBuffer());
 		device->device().freeMemory(vertexBuffer->getVertexBufferMemory());
+		delete scene;
+		delete instanceBuffer;
+		delete bindlessTable;
+		delete textureStreamer;
+		delete rayTracer;
+		delete noiseCache;
+		delete distanceField;
+		delete pipelineRegistry;
+		delete descriptorAllocator;
+		delete descriptorLayoutCache;
+		delete jobSystem;
 	}
 
 	void Engine::Run()
@@ -47,6 +81,7 @@ namespace Solarium
 		while (!glfwWindowShouldClose(_platform->GetWindow()))
 		{
 			glfwPollEvents();
+			pollQualityKeys();
 			try {
 				drawFrame();
 			}
@@ -57,6 +92,23 @@ namespace Solarium
 		device->device().waitIdle();
 	}
 
+	void Engine::pollQualityKeys()
+	{
+		GLFWwindow* window = _platform->GetWindow();
+		if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS)
+		{
+			setQualityTier(QUALITY_LOW);
+		}
+		else if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS)
+		{
+			setQualityTier(QUALITY_MEDIUM);
+		}
+		else if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS)
+		{
+			setQualityTier(QUALITY_HIGH);
+		}
+	}
+
 	void Engine::OnLoop(const uint32_t deltaTime)
 	{
 
@@ -73,15 +125,35 @@ namespace Solarium
 
 	void Engine::createPipelineLayout()
 	{
-		vk::PipelineLayoutCreateInfo pipelineLayoutInfo{};
-		vk::DescriptorSetLayout descriptorSetLayout = uniformBufferObject->getDescriptorSetLayout();
-		pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-		pipelineLayoutInfo.setLayoutCount = 1;
-		pipelineLayout = device->device().createPipelineLayout(pipelineLayoutInfo, nullptr);
-		if (!pipelineLayout)
+		// The shaders are compiled first so the layout can be reflected from them; createPipeline reuses the modules
+		shaderHelper = new ShaderHelper("../../../Shaders/main.vert", "../../../Shaders/main.frag", device->device());
+		ShaderReflection reflection = shaderHelper->reflect();
+		if (reflection.getSetCount() > DESCRIPTOR_SET_COUNT)
 		{
-			throw std::runtime_error("Failed to create pipeline layout");
+			throw std::runtime_error("Shaders use more descriptor sets than the engine binds");
 		}
+		if (reflection.getVertexStride() != sizeof(Vertex))
+		{
+			throw std::runtime_error("Vertex layout does not match the vertex shader inputs");
+		}
+		vertexAttributeDescriptions = reflection.getVertexAttributes(0);
+
+		pushConstantRanges = reflection.getPushConstantRanges();
+		if (pushConstantRanges.size() > 1 || (!pushConstantRanges.empty() && pushConstantRanges[0].offset + pushConstantRanges[0].size > sizeof(DrawPushConstants)))
+		{
+			throw std::runtime_error("Push constant block does not match DrawPushConstants");
+		}
+
+		uniformBufferObject->setDescriptorSetLayoutBindings(reflection.getSetBindings(FRAME_SET));
+		passSetBindings = reflection.getSetBindings(PASS_SET);
+
+		// The bindless set is reflected as an unbounded array, its real size and flags come from the table itself
+		std::vector<vk::DescriptorSetLayout> descriptorSetLayouts(DESCRIPTOR_SET_COUNT);
+		for (uint32_t set = 0; set < DESCRIPTOR_SET_COUNT; set++)
+		{
+			descriptorSetLayouts[set] = set == MATERIAL_SET ? bindlessTable->getDescriptorSetLayout() : descriptorLayoutCache->createDescriptorSetLayout(reflection.getSetBindings(set));
+		}
+		pipelineLayout = descriptorLayoutCache->createPipelineLayout(descriptorSetLayouts, pushConstantRanges);
 	}
 
 	void Engine::createPipeline()
@@ -89,7 +161,34 @@ namespace Solarium
 		auto pipelineConfig = Pipeline::defaultPipelineConfigInfo(swapChain->width(), swapChain->height());
 		pipelineConfig.renderPass = swapChain->getRenderPass();
 		pipelineConfig.pipelineLayout = pipelineLayout;
-		pipeline = new Pipeline(*device, "../../../Shaders/out/Test_shader.vert.spv", "../../../Shaders/out/Test_shader.frag.spv", pipelineConfig);
+		pipelineConfig.attributeDescriptions = vertexAttributeDescriptions;
+		pipelineConfig.shaderStages = shaderHelper->getShaderStages();
+		pipelineConfig.shaderHash = shaderHelper->getShaderHash();
+		pipelineConfig.pushConstantRange = pushConstantRanges.empty() ? vk::PushConstantRange{} : pushConstantRanges[0];
+
+		// The fallback shades with vertex colours only, so it compiles quickly and is ready before the first frame.
+		// It shares the main layout and vertex shader, which keeps every binding valid for either pipeline.
+		ShaderHelper fallbackShaders("../../../Shaders/main.vert", "../../../Shaders/fallback.frag", device->device());
+		PipelineConfigInfo fallbackConfig = pipelineConfig;
+		fallbackConfig.shaderStages = fallbackShaders.getShaderStages();
+		fallbackConfig.shaderHash = fallbackShaders.getShaderHash();
+		fallbackPipeline = pipelineRegistry->getPipeline(fallbackConfig);
+		fallbackShaders.destroyShaderModules(device->device());
+
+		// The registry destroys the main modules once the worker has compiled them
+		pipelineSlot = pipelineRegistry->requestPipeline(pipelineConfig);
+		delete shaderHelper;
+		shaderHelper = nullptr;
+	}
+
+	void Engine::setQualityTier(QualityTier tier)
+	{
+		if (tier == qualityTier)
+		{
+			return;
+		}
+		qualityTier = tier;
+		rayTracer->setQuality(ShaderQuality::forTier(tier));
 	}
 
 	void Engine::createCommandBuffers()
@@ -103,40 +202,71 @@ namespace Solarium
 		{
 			throw std::runtime_error("Failed to allocate command buffers.");
 		}
+	}
 
-		for (int i = 0; i < commandBuffers.size(); i++)
+	void Engine::createFrameDescriptorAllocators()
+	{
+		frameDescriptorAllocators.resize(swapChain->imageCount());
+		for (size_t i = 0; i < frameDescriptorAllocators.size(); i++)
 		{
-			vk::CommandBufferBeginInfo beginInfo{};
-			commandBuffers[i].begin(beginInfo);
-
-			vk::RenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.renderPass = swapChain->getRenderPass();
-			renderPassInfo.framebuffer = swapChain->getFrameBuffer(i);
-
-			renderPassInfo.renderArea = { { 0, 0 }, {swapChain->getSwapChainExtent()} };
-
-			std::array<vk::ClearValue, 2> clearValues{};
-			clearValues[0].color.setFloat32({ 0, 0, 0, 0 });
-			clearValues[1].depthStencil.depth = 1.0f;
-			clearValues[1].depthStencil.stencil = 0;
-
-			renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			renderPassInfo.pClearValues = clearValues.data();
-
-			commandBuffers[i].beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
-
-			pipeline->bind(commandBuffers[i]);
-			std::vector<vk::Buffer> vertexBuffers = { vertexBuffer->getVertexBuffer()};
-			std::vector<vk::DeviceSize> offsets = {0};
-			commandBuffers[i].bindVertexBuffers(0, vertexBuffers, offsets);
-			commandBuffers[i].bindIndexBuffer(vertexBuffer->getIndexBuffer(), 0, vk::IndexType::eUint16);
-			commandBuffers[i].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, uniformBufferObject->getDescriptorSets()[i], nullptr);
-			commandBuffers[i].drawIndexed(static_cast<uint32_t>(vertexBuffer->indices.size()), 1, 0, 0, 0);
-			commandBuffers[i].endRenderPass();
-			commandBuffers[i].end();
+			frameDescriptorAllocators[i] = new DescriptorAllocator(device);
 		}
 	}
 
+	vk::DescriptorSet Engine::createPassDescriptorSet(uint32_t imageIndex)
+	{
+		vk::DescriptorSet passSet = frameDescriptorAllocators[imageIndex]->allocate(descriptorLayoutCache->createDescriptorSetLayout(passSetBindings));
+		DescriptorTemplate* updateTemplate = descriptorLayoutCache->getUpdateTemplate(passSetBindings);
+		std::vector<DescriptorInfo> descriptorData = updateTemplate->createData();
+		descriptorData[updateTemplate->slot(0)].buffer = vk::DescriptorBufferInfo{ instanceBuffer->getBuffer(imageIndex), 0, VK_WHOLE_SIZE };
+		updateTemplate->update(passSet, descriptorData);
+		return passSet;
+	}
+
+	void Engine::recordCommandBuffer(uint32_t imageIndex)
+	{
+		vk::CommandBuffer commandBuffer = commandBuffers[imageIndex];
+		vk::CommandBufferBeginInfo beginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit };
+		commandBuffer.begin(beginInfo);
+
+		rayTracer->dispatch(commandBuffer, imageIndex);
+
+		vk::RenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.renderPass = swapChain->getRenderPass();
+		renderPassInfo.framebuffer = swapChain->getFrameBuffer(imageIndex);
+
+		renderPassInfo.renderArea = { { 0, 0 }, {swapChain->getSwapChainExtent()} };
+
+		std::array<vk::ClearValue, 2> clearValues{};
+		clearValues[0].color.setFloat32({ 0, 0, 0, 0 });
+		clearValues[1].depthStencil.depth = 1.0f;
+		clearValues[1].depthStencil.stencil = 0;
+
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+		rayTracer->draw(commandBuffer);
+
+		// Draw with the fallback until the real pipeline has finished compiling in the background
+		Pipeline* pipeline = pipelineSlot->get() ? pipelineSlot->get() : fallbackPipeline;
+		pipeline->bind(commandBuffer);
+		std::vector<vk::Buffer> vertexBuffers = { vertexBuffer->getVertexBuffer()};
+		std::vector<vk::DeviceSize> offsets = {0};
+		commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+		commandBuffer.bindIndexBuffer(vertexBuffer->getIndexBuffer(), 0, vk::IndexType::eUint16);
+		// Sets are bound once in frequency order; a later pass or material only rebinds from its own slot upwards
+		std::array<vk::DescriptorSet, DESCRIPTOR_SET_COUNT> descriptorSets{};
+		descriptorSets[FRAME_SET] = uniformBufferObject->getDescriptorSets()[imageIndex];
+		descriptorSets[PASS_SET] = createPassDescriptorSet(imageIndex);
+		descriptorSets[MATERIAL_SET] = bindlessTable->getDescriptorSet();
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, FRAME_SET, descriptorSets, nullptr);
+		pipeline->pushDrawConstants(commandBuffer, drawConstants);
+		instanceBuffer->drawIndexed(commandBuffer, static_cast<uint32_t>(vertexBuffer->indices.size()), visibleInstances);
+		commandBuffer.endRenderPass();
+		commandBuffer.end();
+	}
+
 	void Engine::drawFrame()
 	{
 		uint32_t imageIndex;
@@ -158,6 +288,7 @@ namespace Solarium
 		}
 		swapChain->setImageInFlight(imageIndex, fences[currentFrame]);
 		updateUniformBuffers(imageIndex);
+		recordCommandBuffer(imageIndex);
 
 		vk::SubmitInfo submitInfo{};
 
@@ -206,14 +337,68 @@ namespace Solarium
 
 	void Engine::updateUniformBuffers(uint32_t imageIndex)
 	{
-		ubos.viewmodel.model = glm::rotate(glm::mat4(1.0f), Engine::getdt() * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		ubos.viewmodel.view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-		ubos.viewmodel.proj = glm::perspective(glm::radians(45.0f), swapChain->width() / (float)swapChain->height(), 0.1f, 10.0f);
-		ubos.viewmodel.proj[1][1] *= -1;
-		ubos.viewmodel.rotation = glm::vec3();
-		ubos.viewmodel.position = glm::vec3();
-		ubos.viewmodel.viewPos = glm::vec4();
-		uniformBufferObject->updateUniformbuffer(imageIndex, UBOType::VIEWMODEL, ubos);
+		// The fence for this image has been waited on, so the transient sets it used last time are free
+		frameDescriptorAllocators[imageIndex]->reset();
+
+		scene->setRotation(cubeEntity, glm::angleAxis(Engine::getdt() * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		drawConstants.model = glm::mat4(1.0f);
+		glm::vec3 eye = glm::vec3(2.0f, 2.0f, 2.0f);
+		frameUniforms.view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		frameUniforms.proj = glm::perspective(glm::radians(45.0f), swapChain->width() / (float)swapChain->height(), 0.1f, 10.0f);
+		frameUniforms.proj[1][1] *= -1;
+		frameUniforms.viewProj = frameUniforms.proj * frameUniforms.view;
+		frameUniforms.viewPos = glm::vec4(eye, 1.0f);
+		rayTracer->beginFrame(imageIndex, frameUniforms.viewProj, eye);
+		frustum = Frustum::fromMatrix(frameUniforms.viewProj);
+		uniformBufferObject->updateUniformbuffer(imageIndex, frameUniforms);
+		scene->updateTransforms(instanceBuffer, frameUniforms.viewProj * drawConstants.model, jobSystem, &culler);
+		cullInstances();
+		requestTextureResolutions();
+		textureStreamer->processUploads();
+
+		// A streamed texture changes its view when residency changes, so it moves to a fresh slot and the
+		// old slot stays valid until the frames that may still read it have finished. The cube draws with the
+		// material pushed per draw, so a new slot costs no instance data rewrite.
+		bindlessTable->nextFrame();
+		vk::ImageView textureView = textureStreamer->getImageView(materialTexture);
+		if (textureView != materialTextureView)
+		{
+			if (materialTextureIndex != BindlessTable::INVALID_INDEX)
+			{
+				bindlessTable->removeTexture(materialTextureIndex);
+			}
+			materialTextureIndex = bindlessTable->addTexture(textureView, textureStreamer->getSampler());
+			materialTextureView = textureView;
+		}
+		drawConstants.materialIndex = materialTextureIndex;
+		instanceBuffer->sync(imageIndex);
+	}
+
+	void Engine::cullInstances()
+	{
+		// Scene::updateTransforms keeps the culler's spheres in step with the instances
+		culler.cullSpheres(frustum, jobSystem, visibleInstances);
+	}
+
+	void Engine::requestTextureResolutions()
+	{
+		// A sphere of radius r at view depth z spans r * proj[1][1] * height / z pixels across. The bounds are at
+		// least as large as the textured surface, so this errs towards a finer level. The streamer keeps the
+		// largest request per texture, which is the instance closest to the camera.
+		float pixelsPerUnit = std::abs(frameUniforms.proj[1][1]) * swapChain->height();
+		const InstanceData* instances = instanceBuffer->getInstances();
+		for (uint32_t i : visibleInstances)
+		{
+			// Instances with their own bindless texture are not streamed from here
+			if (instances[i].textureIndex != DRAW_MATERIAL)
+			{
+				continue;
+			}
+			float radius = culler.getRadius(i);
+			float depth = -(frameUniforms.view * glm::vec4(culler.getCenter(i), 1.0f)).z;
+			float pixels = depth > radius ? radius * pixelsPerUnit / depth : std::numeric_limits<float>::max();
+			textureStreamer->requestResolution(materialTexture, pixels);
+		}
 	}
 
 	void Engine::recreateSwapChain()
@@ -233,19 +418,35 @@ namespace Solarium
 		device = new Device{ *_platform };
 		swapChain = new SwapChain(*device, _platform->getExtent());
 		updateAll();
+		bindlessTable->createChain();
+		pipelineRegistry->createChain();
 		createPipelineLayout();
 		createPipeline();
-		texture->createChain();
+		distanceField->createChain();
+		noiseCache->createChain();
+		rayTracer->createChain();
+		textureStreamer->createChain();
 		vertexBuffer->createChain();
-		uniformBufferObject->createChain(texture->getTextureSampler(), texture->getTextureImageView());
+		instanceBuffer->createChain();
+		uniformBufferObject->createChain();
 		createCommandBuffers();
+		createFrameDescriptorAllocators();
 
 		swapChain->getImagesInFlight().resize(swapChain->imageCount());
 	}
 
 	void Engine::updateAll() {
 		texture->update(swapChain, device);
+		textureStreamer->update(swapChain, device);
+		bindlessTable->update(swapChain, device);
+		descriptorLayoutCache->update(device);
+		descriptorAllocator->update(device);
+		pipelineRegistry->update(device);
+		distanceField->update(device);
+		noiseCache->update(device);
+		rayTracer->update(swapChain, device);
 		vertexBuffer->update(swapChain, device);
+		instanceBuffer->update(swapChain, device);
 		uniformBufferObject->update(swapChain, device);
 	}
 
@@ -256,20 +457,29 @@ namespace Solarium
 			device->device().destroyFramebuffer(swapChain->getSwapChainFB()[i]);
 		}
 
-		for (size_t i = 0; i < swapChain->imageCount(); i++)
+		uniformBufferObject->cleanup();
+		rayTracer->cleanup();
+		distanceField->cleanup();
+		noiseCache->cleanup();
+		descriptorAllocator->cleanup();
+		for (DescriptorAllocator* allocator : frameDescriptorAllocators)
 		{
-			device->device().destroyBuffer(uniformBufferObject->getUniformBuffers(UBOType::VIEWMODEL)[i]);
-			device->device().freeMemory(uniformBufferObject->getUniformBuffersMemory(UBOType::VIEWMODEL)[i]);
-			device->device().destroyBuffer(uniformBufferObject->getUniformBuffers(UBOType::CAMERA)[i]);
-			device->device().freeMemory(uniformBufferObject->getUniformBuffersMemory(UBOType::CAMERA)[i]);
+			delete allocator;
 		}
-
-		device->device().destroyDescriptorPool(uniformBufferObject->getDescriptorPool());
+		frameDescriptorAllocators.clear();
+		instanceBuffer->cleanup();
+		textureStreamer->cleanup();
+		bindlessTable->cleanup();
+		materialTextureIndex = BindlessTable::INVALID_INDEX;
+		materialTextureView = nullptr;
 
 		device->device().freeCommandBuffers(device->getCommandPool(), commandBuffers);
 
-		device->device().destroyPipeline(pipeline->getGraphicsPipeline());
-		device->device().destroyPipelineLayout(pipelineLayout);
+		pipelineRegistry->cleanup();
+		pipelineSlot = nullptr;
+		fallbackPipeline = nullptr;
+		// Set and pipeline layouts belong to the device, which is recreated together with the swapchain
+		descriptorLayoutCache->cleanup();
 
 		device->device().destroyRenderPass(swapChain->getRenderPass());
 		
@@ -295,7 +505,6 @@ namespace Solarium
 		device->device().destroy();
 		device->getInstance().destroySurfaceKHR(device->surface());
 		device->getInstance().destroy();
-		device->device().destroyDescriptorSetLayout(uniformBufferObject->getDescriptorSetLayout(), nullptr);
 		glfwDestroyWindow(_platform->GetWindow());
 
 		glfwTerminate();
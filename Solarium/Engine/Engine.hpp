@@ -7,16 +7,28 @@
 #include "Platform.hpp"
 #include "Logger.hpp"
 #include "Pipeline.hpp"
+#include "ShaderHelper.hpp"
+#include "PipelineRegistry.hpp"
 #include "SwapChain.hpp"
 #include "UBO.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
 #include "Texture.hpp"
+#include "TextureStreamer.hpp"
+#include "BindlessTable.hpp"
 #include "VertexBuffer.hpp"
+#include "InstanceBuffer.hpp"
+#include "Scene.hpp"
+#include "JobSystem.hpp"
+#include "Culling.hpp"
+#include "RayTracer.hpp"
 
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <stdexcept>
+#include <limits>
 #include <memory>
 
 namespace Solarium
@@ -39,30 +51,73 @@ namespace Solarium
 		float getdt();
 		bool getFramebufferResized() { return framebufferResized; }
 		void setFramebufferResized(bool resized) { framebufferResized = resized; }
+		// Switches the path tracer's quality constants, bound to F1 (low), F2 (medium) and F3 (high)
+		void setQualityTier(QualityTier tier);
+		QualityTier getQualityTier() { return qualityTier; }
 	private:
+		static constexpr uint32_t MAX_INSTANCES = 65536;
 
+		void pollQualityKeys();
 		void createPipelineLayout();
 		void createPipeline();;
 		void createCommandBuffers();
+		void createFrameDescriptorAllocators();
+		// Transient per-pass set, allocated from the image's frame allocator
+		vk::DescriptorSet createPassDescriptorSet(uint32_t imageIndex);
+		void recordCommandBuffer(uint32_t imageIndex);
 		void drawFrame();
 		void recreateSwapChain();
 		void cleanupSwapChain();
 		void updateAll();
 		void cleanup();
 		void updateUniformBuffers(uint32_t imageIndex);
+		// Fills visibleInstances with the instances whose bounding sphere touches the frustum
+		void cullInstances();
+		// Texture streaming feedback from the projected bounds of every visible instance
+		void requestTextureResolutions();
 
 		Platform* _platform;
 		Device* device;
 		SwapChain* swapChain;
-		Pipeline* pipeline;
+		PipelineRegistry* pipelineRegistry;
+		// Owned by pipelineRegistry
+		PipelineRegistry::PipelineSlot* pipelineSlot = nullptr;
+		QualityTier qualityTier = QUALITY_HIGH;
+		Pipeline* fallbackPipeline = nullptr;
+		DistanceField* distanceField;
+		NoiseCache* noiseCache;
+		RayTracer* rayTracer;
 		UBO* uniformBufferObject;
+		DescriptorLayoutCache* descriptorLayoutCache;
+		// Long-lived sets come from descriptorAllocator; per-image allocators are reset every frame for transient sets
+		DescriptorAllocator* descriptorAllocator;
+		std::vector<DescriptorAllocator*> frameDescriptorAllocators;
 		Texture* texture;
+		TextureStreamer* textureStreamer;
+		TextureHandle materialTexture;
+		BindlessTable* bindlessTable;
+		uint32_t materialTextureIndex = BindlessTable::INVALID_INDEX;
+		vk::ImageView materialTextureView;
 		VertexBuffer* vertexBuffer;
+		InstanceBuffer* instanceBuffer;
+		Scene* scene;
+		Entity cubeEntity;
+		JobSystem* jobSystem;
+		Frustum frustum{};
+		// Bounding spheres of the instances, in instance order, written by the scene as transforms change
+		FrustumCuller culler;
+		std::vector<uint32_t> visibleInstances;
 		vk::PipelineLayout pipelineLayout;
+		// Reflected in createPipelineLayout, consumed by createPipeline
+		ShaderHelper* shaderHelper = nullptr;
+		std::vector<vk::VertexInputAttributeDescription> vertexAttributeDescriptions;
+		std::vector<vk::PushConstantRange> pushConstantRanges;
+		std::vector<vk::DescriptorSetLayoutBinding> passSetBindings;
 		std::vector<vk::CommandBuffer> commandBuffers;
 		std::vector<vk::ImageView> swapChainImageViews;
 		bool framebufferResized = false;
-		UBOlist ubos{};
+		structUBOframe frameUniforms{};
+		DrawPushConstants drawConstants{};
 
 	};
 }
\ No newline at end of file
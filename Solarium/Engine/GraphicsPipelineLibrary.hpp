@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+namespace Solarium
+{
+
+	// VK_EXT_graphics_pipeline_library as laid out by the spec. The bundled Vulkan headers predate the extension, so
+	// its structures and values are declared here; they are passed through pNext and flag fields as plain C data.
+	namespace GraphicsPipelineLibrary
+	{
+		constexpr const char* EXTENSION_NAME = "VK_EXT_graphics_pipeline_library";
+
+		constexpr VkStructureType FEATURES_STRUCTURE_TYPE = static_cast<VkStructureType>(1000320000);
+		constexpr VkStructureType CREATE_INFO_STRUCTURE_TYPE = static_cast<VkStructureType>(1000320002);
+
+		// VkPipelineCreateFlagBits added by the extension
+		constexpr VkPipelineCreateFlags LINK_TIME_OPTIMIZATION = 0x00000400;
+		constexpr VkPipelineCreateFlags RETAIN_LINK_TIME_OPTIMIZATION_INFO = 0x00800000;
+
+		// VkGraphicsPipelineLibraryFlagBitsEXT, in the order a pipeline is split into its parts
+		enum Part : VkFlags {
+			VERTEX_INPUT_INTERFACE = 0x00000001,
+			PRE_RASTERIZATION_SHADERS = 0x00000002,
+			FRAGMENT_SHADER = 0x00000004,
+			FRAGMENT_OUTPUT_INTERFACE = 0x00000008
+		};
+		constexpr Part PARTS[] = { VERTEX_INPUT_INTERFACE, PRE_RASTERIZATION_SHADERS, FRAGMENT_SHADER, FRAGMENT_OUTPUT_INTERFACE };
+
+		// VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT
+		struct Features {
+			VkStructureType sType = FEATURES_STRUCTURE_TYPE;
+			void* pNext = nullptr;
+			VkBool32 graphicsPipelineLibrary = VK_FALSE;
+		};
+
+		// VkGraphicsPipelineLibraryCreateInfoEXT
+		struct CreateInfo {
+			VkStructureType sType = CREATE_INFO_STRUCTURE_TYPE;
+			const void* pNext = nullptr;
+			VkFlags flags = 0;
+		};
+	}
+}
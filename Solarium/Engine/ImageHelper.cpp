@@ -0,0 +1,89 @@
+#include "ImageHelper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace Solarium
+{
+
+	static const float* srgbToLinearTable()
+	{
+		static const std::array<float, 256> table = []()
+		{
+			std::array<float, 256> values{};
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+		return table.data();
+	}
+
+	static uint8_t linearToSrgb(float c)
+	{
+		c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+		return static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+
+	uint32_t ImageHelper::mipLevelCount(uint32_t width, uint32_t height)
+	{
+		return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	}
+
+	void ImageHelper::downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, bool srgb)
+	{
+		const float* toLinear = srgbToLinearTable();
+		uint32_t dstWidth = std::max(srcWidth / 2, 1u);
+		uint32_t dstHeight = std::max(srcHeight / 2, 1u);
+
+		for (uint32_t y = 0; y < dstHeight; y++)
+		{
+			uint32_t y0 = std::min(y * 2, srcHeight - 1);
+			uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+			for (uint32_t x = 0; x < dstWidth; x++)
+			{
+				uint32_t x0 = std::min(x * 2, srcWidth - 1);
+				uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+				const uint8_t* texels[4] = { src + (y0 * srcWidth + x0) * 4, src + (y0 * srcWidth + x1) * 4, src + (y1 * srcWidth + x0) * 4, src + (y1 * srcWidth + x1) * 4 };
+				uint8_t* out = dst + (y * dstWidth + x) * 4;
+
+				for (int channel = 0; channel < 4; channel++)
+				{
+					// Alpha is always stored linearly
+					if (srgb && channel < 3)
+					{
+						float sum = toLinear[texels[0][channel]] + toLinear[texels[1][channel]] + toLinear[texels[2][channel]] + toLinear[texels[3][channel]];
+						out[channel] = linearToSrgb(sum * 0.25f);
+					}
+					else
+					{
+						out[channel] = static_cast<uint8_t>((texels[0][channel] + texels[1][channel] + texels[2][channel] + texels[3][channel] + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<uint8_t> ImageHelper::generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, bool srgb, std::vector<size_t>& levelOffsets)
+	{
+		levelOffsets.resize(mipLevels);
+		size_t totalSize = 0;
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			levelOffsets[level] = totalSize;
+			totalSize += static_cast<size_t>(mipExtent(width, level)) * mipExtent(height, level) * 4;
+		}
+
+		std::vector<uint8_t> chain(totalSize);
+		std::memcpy(chain.data(), pixels, static_cast<size_t>(width) * height * 4);
+		for (uint32_t level = 1; level < mipLevels; level++)
+		{
+			downsample(chain.data() + levelOffsets[level - 1], mipExtent(width, level - 1), mipExtent(height, level - 1), chain.data() + levelOffsets[level], srgb);
+		}
+		return chain;
+	}
+}
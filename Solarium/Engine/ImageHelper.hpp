@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Solarium
+{
+
+	// CPU mip chains for the formats the device cannot blit with linear filtering. TextureStreamer blits the
+	// others on the GPU and reads the levels back, since residency streaming reloads them from system memory.
+	class ImageHelper
+	{
+	public:
+		static uint32_t mipLevelCount(uint32_t width, uint32_t height);
+		static uint32_t mipExtent(uint32_t extent, uint32_t level) { return extent >> level > 0 ? extent >> level : 1; }
+
+		// Box filters one RGBA8 level into the next, averaging in linear space when the data is sRGB
+		static void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, bool srgb);
+
+		// Builds every level of an RGBA8 mip chain, tightly packed with level 0 first.
+		// levelOffsets receives the byte offset of each level.
+		static std::vector<uint8_t> generateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, bool srgb, std::vector<size_t>& levelOffsets);
+	};
+}
@@ -0,0 +1,147 @@
+#include "InstanceBuffer.hpp"
+#include <algorithm>
+
+namespace Solarium
+{
+	InstanceBuffer::InstanceBuffer(SwapChain* swapChain_, Device* device_, uint32_t capacity_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		capacity = capacity_;
+		instances.reserve(capacity);
+	}
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		cleanup();
+	}
+
+	void InstanceBuffer::createChain()
+	{
+		vk::DeviceSize bufferSize = sizeof(InstanceData) * capacity;
+
+		buffers.resize(swapChain->imageCount());
+		buffersMemory.resize(swapChain->imageCount());
+		mappedInstances.resize(swapChain->imageCount());
+		dirtyRanges.assign(swapChain->imageCount(), {});
+
+		for (size_t i = 0; i < swapChain->imageCount(); i++)
+		{
+			BufferHelper::createBuffer(bufferSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, buffers[i], buffersMemory[i], device);
+			mappedInstances[i] = static_cast<InstanceData*>(device->device().mapMemory(buffersMemory[i], 0, bufferSize));
+		}
+
+		markDirty(0, getInstanceCount());
+	}
+
+	void InstanceBuffer::cleanup()
+	{
+		for (size_t i = 0; i < buffers.size(); i++)
+		{
+			device->device().unmapMemory(buffersMemory[i]);
+			device->device().destroyBuffer(buffers[i]);
+			device->device().freeMemory(buffersMemory[i]);
+		}
+		buffers.clear();
+		buffersMemory.clear();
+		mappedInstances.clear();
+		dirtyRanges.clear();
+	}
+
+	uint32_t InstanceBuffer::addInstance(const InstanceData& instance)
+	{
+		uint32_t index = getInstanceCount();
+		resize(index + 1);
+		setInstance(index, instance);
+		return index;
+	}
+
+	void InstanceBuffer::setInstances(uint32_t first, uint32_t count, const InstanceData* data)
+	{
+		if (first + count > getInstanceCount())
+		{
+			throw std::runtime_error("Instance range out of bounds");
+		}
+		std::copy(data, data + count, instances.begin() + first);
+		markDirty(first, count);
+	}
+
+	void InstanceBuffer::resize(uint32_t count)
+	{
+		if (count > capacity)
+		{
+			throw std::runtime_error("Instance buffer capacity exceeded");
+		}
+		instances.resize(count);
+	}
+
+	void InstanceBuffer::markDirty(uint32_t first, uint32_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		for (auto& ranges : dirtyRanges)
+		{
+			// Consecutive writes are the common case, so extend the previous range when they touch
+			if (!ranges.empty() && first >= ranges.back().first && first <= ranges.back().first + ranges.back().count)
+			{
+				ranges.back().count = std::max(ranges.back().count, first + count - ranges.back().first);
+			}
+			else
+			{
+				ranges.push_back({ first, count });
+			}
+		}
+	}
+
+	void InstanceBuffer::sync(uint32_t imageIndex)
+	{
+		std::vector<DirtyRange>& ranges = dirtyRanges[imageIndex];
+		if (ranges.empty())
+		{
+			return;
+		}
+
+		std::sort(ranges.begin(), ranges.end(), [](const DirtyRange& a, const DirtyRange& b) { return a.first < b.first; });
+
+		uint32_t instanceCount = getInstanceCount();
+		uint32_t copiedEnd = 0;
+		for (const auto& range : ranges)
+		{
+			uint32_t first = std::max(range.first, copiedEnd);
+			uint32_t end = std::min(range.first + range.count, instanceCount);
+			if (first < end)
+			{
+				std::copy(instances.begin() + first, instances.begin() + end, mappedInstances[imageIndex] + first);
+				copiedEnd = end;
+			}
+		}
+		ranges.clear();
+	}
+
+	void InstanceBuffer::drawIndexed(vk::CommandBuffer commandBuffer, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset)
+	{
+		if (instances.empty())
+		{
+			return;
+		}
+		commandBuffer.drawIndexed(indexCount, getInstanceCount(), firstIndex, vertexOffset, 0);
+	}
+
+	void InstanceBuffer::drawIndexed(vk::CommandBuffer commandBuffer, uint32_t indexCount, const std::vector<uint32_t>& visible, uint32_t firstIndex, int32_t vertexOffset)
+	{
+		// gl_InstanceIndex starts at firstInstance, so each run still reads its own instance data
+		for (size_t begin = 0; begin < visible.size();)
+		{
+			size_t end = begin + 1;
+			while (end < visible.size() && visible[end] == visible[end - 1] + 1)
+			{
+				end++;
+			}
+			commandBuffer.drawIndexed(indexCount, static_cast<uint32_t>(end - begin), firstIndex, vertexOffset, visible[begin]);
+			begin = end;
+		}
+	}
+}
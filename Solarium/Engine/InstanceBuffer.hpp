@@ -0,0 +1,60 @@
+#pragma once
+
+#include "BufferHelper.hpp"
+#include "Pipeline.hpp"
+#include "SwapChain.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace Solarium
+{
+
+	// Per-object data, one host-visible storage buffer per swapchain image
+	class InstanceBuffer
+	{
+	public:
+		InstanceBuffer(SwapChain* swapChain_, Device* device_, uint32_t capacity_);
+		~InstanceBuffer();
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+		void createChain();
+		void cleanup();
+		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
+
+		uint32_t addInstance(const InstanceData& instance);
+		void setInstance(uint32_t index, const InstanceData& instance) { setInstances(index, 1, &instance); }
+		void setInstances(uint32_t first, uint32_t count, const InstanceData* data);
+		void resize(uint32_t count);
+
+		// Callers that write through getInstances() must report what they touched with markDirty
+		InstanceData* getInstances() { return instances.data(); }
+		void markDirty(uint32_t first, uint32_t count);
+
+		// Copies the ranges changed since this image was last synced into its buffer
+		void sync(uint32_t imageIndex);
+		void drawIndexed(vk::CommandBuffer commandBuffer, uint32_t indexCount, uint32_t firstIndex = 0, int32_t vertexOffset = 0);
+		// Draws only the listed instances, in ascending order; every run of consecutive indices is one draw
+		void drawIndexed(vk::CommandBuffer commandBuffer, uint32_t indexCount, const std::vector<uint32_t>& visible, uint32_t firstIndex = 0, int32_t vertexOffset = 0);
+
+		uint32_t getInstanceCount() { return static_cast<uint32_t>(instances.size()); }
+		uint32_t getCapacity() { return capacity; }
+		vk::Buffer getBuffer(uint32_t imageIndex) { return buffers[imageIndex]; }
+
+	private:
+		struct DirtyRange
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+
+		Device* device;
+		SwapChain* swapChain;
+		uint32_t capacity;
+		std::vector<InstanceData> instances;
+		std::vector<vk::Buffer> buffers;
+		std::vector<vk::DeviceMemory> buffersMemory;
+		std::vector<InstanceData*> mappedInstances;
+		std::vector<std::vector<DirtyRange>> dirtyRanges;
+	};
+}
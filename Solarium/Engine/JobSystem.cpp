@@ -0,0 +1,118 @@
+#include "JobSystem.hpp"
+#include <algorithm>
+
+namespace Solarium
+{
+	JobSystem::JobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			workers.emplace_back(&JobSystem::workerLoop, this);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			stopping = true;
+		}
+		wakeCondition.notify_all();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	void JobSystem::execute(std::function<void()> job)
+	{
+		pendingJobs++;
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			jobs.push(std::move(job));
+		}
+		wakeCondition.notify_one();
+	}
+
+	void JobSystem::parallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> job)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		if (batchSize == 0)
+		{
+			batchSize = 1;
+		}
+
+		auto state = std::make_shared<ParallelForState>();
+		state->job = std::move(job);
+		state->count = count;
+		state->batchSize = batchSize;
+		state->batchCount = (count + batchSize - 1) / batchSize;
+
+		uint32_t helperCount = std::min(state->batchCount - 1, getWorkerCount());
+		for (uint32_t i = 0; i < helperCount; i++)
+		{
+			execute([state]() { runBatches(*state); });
+		}
+
+		runBatches(*state);
+		while (state->finishedBatches.load() < state->batchCount)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::wait()
+	{
+		std::unique_lock<std::mutex> lock(queueMutex);
+		idleCondition.wait(lock, [this]() { return pendingJobs.load() == 0; });
+	}
+
+	void JobSystem::runBatches(ParallelForState& state)
+	{
+		uint32_t batch;
+		while ((batch = state.nextBatch++) < state.batchCount)
+		{
+			uint32_t begin = batch * state.batchSize;
+			uint32_t end = std::min(begin + state.batchSize, state.count);
+			state.job(begin, end);
+			state.finishedBatches++;
+		}
+	}
+
+	void JobSystem::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				wakeCondition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+				if (stopping && jobs.empty())
+				{
+					return;
+				}
+				job = std::move(jobs.front());
+				jobs.pop();
+			}
+
+			job();
+
+			if (--pendingJobs == 0)
+			{
+				std::lock_guard<std::mutex> lock(queueMutex);
+				idleCondition.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Solarium
+{
+
+	class JobSystem
+	{
+	public:
+		// A thread count of 0 uses every hardware thread except the calling one
+		JobSystem(uint32_t threadCount = 0);
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		void execute(std::function<void()> job);
+
+		// Splits [0, count) into batches of batchSize and runs job(begin, end) on every batch.
+		// The calling thread takes part in the work and returns once every batch is done.
+		void parallelFor(uint32_t count, uint32_t batchSize, std::function<void(uint32_t, uint32_t)> job);
+
+		void wait();
+		bool busy() { return pendingJobs.load() > 0; }
+		uint32_t getWorkerCount() { return static_cast<uint32_t>(workers.size()); }
+
+	private:
+		struct ParallelForState
+		{
+			std::function<void(uint32_t, uint32_t)> job;
+			uint32_t count;
+			uint32_t batchSize;
+			uint32_t batchCount;
+			std::atomic<uint32_t> nextBatch{ 0 };
+			std::atomic<uint32_t> finishedBatches{ 0 };
+		};
+
+		void workerLoop();
+		static void runBatches(ParallelForState& state);
+
+		std::vector<std::thread> workers;
+		std::queue<std::function<void()>> jobs;
+		std::mutex queueMutex;
+		std::condition_variable wakeCondition;
+		std::condition_variable idleCondition;
+		std::atomic<uint32_t> pendingJobs{ 0 };
+		bool stopping = false;
+	};
+}
@@ -0,0 +1,125 @@
+#include "Ktx2.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace Solarium
+{
+
+	static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	static const size_t KTX2_HEADER_SIZE = 80;
+	static const size_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+	template<typename T>
+	static T readValue(const std::vector<uint8_t>& data, size_t offset)
+	{
+		T value;
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+	template<typename T>
+	static void writeValue(std::vector<uint8_t>& data, size_t offset, T value)
+	{
+		std::memcpy(data.data() + offset, &value, sizeof(T));
+	}
+
+	Ktx2Image Ktx2::load(const std::string& path)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open " + path);
+		}
+
+		Ktx2Image image;
+		image.data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(image.data.data()), image.data.size());
+
+		if (image.data.size() < KTX2_HEADER_SIZE || std::memcmp(image.data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+		{
+			throw std::runtime_error(path + " is not a KTX2 file");
+		}
+
+		image.vkFormat = readValue<uint32_t>(image.data, 12);
+		image.width = readValue<uint32_t>(image.data, 20);
+		image.height = readValue<uint32_t>(image.data, 24);
+		uint32_t depth = readValue<uint32_t>(image.data, 28);
+		uint32_t layerCount = readValue<uint32_t>(image.data, 32);
+		uint32_t faceCount = readValue<uint32_t>(image.data, 36);
+		uint32_t levelCount = std::max(readValue<uint32_t>(image.data, 40), 1u);
+		uint32_t supercompression = readValue<uint32_t>(image.data, 44);
+
+		if (depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0)
+		{
+			throw std::runtime_error(path + " must be a single uncompressed 2D image");
+		}
+		if (image.data.size() < KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+		{
+			throw std::runtime_error(path + " is truncated");
+		}
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			size_t entry = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			Ktx2Level levelInfo{ static_cast<size_t>(readValue<uint64_t>(image.data, entry)), static_cast<size_t>(readValue<uint64_t>(image.data, entry + 8)) };
+			if (levelInfo.offset + levelInfo.size > image.data.size())
+			{
+				throw std::runtime_error(path + " is truncated");
+			}
+			image.levels.push_back(levelInfo);
+		}
+		return image;
+	}
+
+	void Ktx2::write(const std::string& path, uint32_t vkFormat, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels, const std::vector<uint32_t>& dataFormatDescriptor, size_t levelAlignment)
+	{
+		uint32_t levelCount = static_cast<uint32_t>(levels.size());
+		size_t dfdOffset = KTX2_HEADER_SIZE + levelCount * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+		size_t dfdSize = dataFormatDescriptor.size() * sizeof(uint32_t);
+
+		// Level data is stored smallest first, each level aligned for direct upload
+		std::vector<size_t> levelOffsets(levelCount);
+		size_t end = dfdOffset + dfdSize;
+		for (uint32_t level = levelCount; level-- > 0;)
+		{
+			end = (end + levelAlignment - 1) / levelAlignment * levelAlignment;
+			levelOffsets[level] = end;
+			end += levels[level].size();
+		}
+
+		std::vector<uint8_t> data(end, 0);
+		std::memcpy(data.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+		writeValue<uint32_t>(data, 12, vkFormat);
+		writeValue<uint32_t>(data, 16, 1);          // typeSize
+		writeValue<uint32_t>(data, 20, width);
+		writeValue<uint32_t>(data, 24, height);
+		writeValue<uint32_t>(data, 28, 0);          // pixelDepth
+		writeValue<uint32_t>(data, 32, 0);          // layerCount
+		writeValue<uint32_t>(data, 36, 1);          // faceCount
+		writeValue<uint32_t>(data, 40, levelCount);
+		writeValue<uint32_t>(data, 44, 0);          // supercompressionScheme
+		writeValue<uint32_t>(data, 48, static_cast<uint32_t>(dfdOffset));
+		writeValue<uint32_t>(data, 52, static_cast<uint32_t>(dfdSize));
+
+		for (uint32_t level = 0; level < levelCount; level++)
+		{
+			size_t entry = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+			writeValue<uint64_t>(data, entry, levelOffsets[level]);
+			writeValue<uint64_t>(data, entry + 8, levels[level].size());
+			writeValue<uint64_t>(data, entry + 16, levels[level].size());
+			std::memcpy(data.data() + levelOffsets[level], levels[level].data(), levels[level].size());
+		}
+		std::memcpy(data.data() + dfdOffset, dataFormatDescriptor.data(), dfdSize);
+
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open " + path + " for writing");
+		}
+		file.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+}
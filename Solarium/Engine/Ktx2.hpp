@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Solarium
+{
+	struct Ktx2Level
+	{
+		size_t offset; // Byte offset of the level within Ktx2Image::data
+		size_t size;
+	};
+
+	// A single layer, single face 2D texture, level 0 first
+	struct Ktx2Image
+	{
+		uint32_t vkFormat = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<Ktx2Level> levels;
+		// The whole file; level offsets are aligned to the texel block size so it can be uploaded as is
+		std::vector<uint8_t> data;
+	};
+
+	class Ktx2
+	{
+	public:
+		static Ktx2Image load(const std::string& path);
+		// levels holds the payload of every mip level, level 0 first
+		static void write(const std::string& path, uint32_t vkFormat, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels, const std::vector<uint32_t>& dataFormatDescriptor, size_t levelAlignment);
+	};
+}
@@ -0,0 +1,238 @@
+#include "NoiseCache.hpp"
+#include "ShaderHelper.hpp"
+#include "ComputePipeline.hpp"
+#include "Logger.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace Solarium
+{
+	NoiseCache::NoiseCache(Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, const std::string& cacheDirectory_)
+	{
+		device = device_;
+		layoutCache = layoutCache_;
+		descriptorAllocator = descriptorAllocator_;
+		pipelineRegistry = pipelineRegistry_;
+		cacheDirectory = cacheDirectory_;
+	}
+
+	NoiseCache::~NoiseCache()
+	{
+		cleanup();
+	}
+
+	void NoiseCache::createChain()
+	{
+		uint64_t sourceHash = hashShaderSources();
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+
+		// Texels go through host visible buffers either way: read from disk into them, or baked into them and saved
+		std::array<StagingBuffer, NOISE_TYPE_COUNT> staging{};
+		std::array<bool, NOISE_TYPE_COUNT> toBake{};
+		bool anyToBake = false;
+		for (uint32_t type = 0; type < NOISE_TYPE_COUNT; type++)
+		{
+			staging[type].size = texelBytes(TEXTURES[type]);
+			device->createBuffer(staging[type].size, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, staging[type].buffer, staging[type].memory);
+			staging[type].mapped = device->device().mapMemory(staging[type].memory, 0, staging[type].size);
+			toBake[type] = !loadTexels(cacheFilePath(static_cast<NoiseType>(type), sourceHash), staging[type]);
+			anyToBake |= toBake[type];
+		}
+
+		if (anyToBake)
+		{
+			vk::CommandBuffer commandBuffer = device->beginSingleTimeCommands();
+			bake(commandBuffer, toBake, staging);
+			ComputePipeline::memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eHost, vk::AccessFlagBits::eHostRead);
+			device->endSingleTimeCommands(commandBuffer);
+
+			for (uint32_t type = 0; type < NOISE_TYPE_COUNT; type++)
+			{
+				if (toBake[type])
+				{
+					Logger::Log("Baked %s noise", TEXTURES[type].name);
+					saveTexels(cacheFilePath(static_cast<NoiseType>(type), sourceHash), staging[type]);
+				}
+			}
+		}
+
+		vk::CommandBuffer commandBuffer = device->beginSingleTimeCommands();
+		for (uint32_t type = 0; type < NOISE_TYPE_COUNT; type++)
+		{
+			createImage(static_cast<NoiseType>(type));
+			upload(commandBuffer, static_cast<NoiseType>(type), staging[type]);
+		}
+		device->endSingleTimeCommands(commandBuffer);
+
+		for (StagingBuffer& buffer : staging)
+		{
+			device->device().unmapMemory(buffer.memory);
+			device->device().destroyBuffer(buffer.buffer);
+			device->device().freeMemory(buffer.memory);
+		}
+
+		// Every texture holds exactly one period, so repeating them continues the noise
+		vk::SamplerCreateInfo samplerInfo{ {}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eNearest,
+			vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat };
+		sampler = device->device().createSampler(samplerInfo);
+		if (!sampler)
+		{
+			throw std::runtime_error("Failed to create noise sampler");
+		}
+	}
+
+	void NoiseCache::cleanup()
+	{
+		device->device().destroySampler(sampler);
+		sampler = nullptr;
+		for (uint32_t type = 0; type < NOISE_TYPE_COUNT; type++)
+		{
+			device->device().destroyImageView(imageViews[type]);
+			device->device().destroyImage(images[type]);
+			device->device().freeMemory(imageMemories[type]);
+			imageViews[type] = nullptr;
+			images[type] = nullptr;
+			imageMemories[type] = nullptr;
+		}
+	}
+
+	uint64_t NoiseCache::hashShaderSources()
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (const std::string& path : { ShaderHelper::findComputeShader("../../../Shaders", "noise_bake"), std::string("../../../Shaders/noise.glsl") })
+		{
+			std::ifstream file(path, std::ios::binary);
+			for (std::istreambuf_iterator<char> it(file), end; it != end; ++it)
+			{
+				hash = (hash ^ static_cast<uint8_t>(*it)) * 1099511628211ull;
+			}
+		}
+		return hash;
+	}
+
+	std::string NoiseCache::cacheFilePath(NoiseType type, uint64_t sourceHash)
+	{
+		const NoiseTextureInfo& info = TEXTURES[type];
+		std::ostringstream path;
+		path << cacheDirectory << "/" << info.name << "_" << info.resolution << "_" << info.octaves << "_" << std::hex << sourceHash << ".bin";
+		return path.str();
+	}
+
+	bool NoiseCache::loadTexels(const std::string& path, StagingBuffer& staging)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open() || static_cast<vk::DeviceSize>(file.tellg()) != staging.size)
+		{
+			return false;
+		}
+		file.seekg(0);
+		file.read(static_cast<char*>(staging.mapped), staging.size);
+		return static_cast<bool>(file);
+	}
+
+	void NoiseCache::saveTexels(const std::string& path, const StagingBuffer& staging)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			Logger::Log("Could not write noise cache file %s", path.c_str());
+			return;
+		}
+		file.write(static_cast<const char*>(staging.mapped), staging.size);
+	}
+
+	void NoiseCache::bake(vk::CommandBuffer commandBuffer, const std::array<bool, NOISE_TYPE_COUNT>& toBake, std::array<StagingBuffer, NOISE_TYPE_COUNT>& staging)
+	{
+		ShaderHelper bakeShaders(ShaderHelper::findComputeShader("../../../Shaders", "noise_bake"), device->device());
+		ShaderReflection reflection = bakeShaders.reflect();
+		std::vector<vk::DescriptorSetLayoutBinding> bindings = reflection.getSetBindings(0);
+		std::vector<vk::PushConstantRange> pushConstantRanges = reflection.getPushConstantRanges();
+		if (pushConstantRanges.size() != 1 || pushConstantRanges[0].offset + pushConstantRanges[0].size > sizeof(NoiseBakePushConstants))
+		{
+			throw std::runtime_error("Push constant block does not match NoiseBakePushConstants");
+		}
+
+		vk::DescriptorSetLayout setLayout = layoutCache->createDescriptorSetLayout(bindings);
+		ComputePipelineConfigInfo configInfo{};
+		configInfo.shaderStage = bakeShaders.getShaderStages()[0];
+		configInfo.shaderHash = bakeShaders.getShaderHash();
+		configInfo.localSize = reflection.getLocalSize();
+		configInfo.pushConstantRange = pushConstantRanges[0];
+		configInfo.pipelineLayout = layoutCache->createPipelineLayout({ setLayout }, pushConstantRanges);
+		ComputePipeline* bakePipeline = pipelineRegistry->getComputePipeline(configInfo);
+		bakeShaders.destroyShaderModules(device->device());
+
+		DescriptorTemplate* updateTemplate = layoutCache->getUpdateTemplate(bindings);
+		bakePipeline->bind(commandBuffer);
+		for (uint32_t type = 0; type < NOISE_TYPE_COUNT; type++)
+		{
+			if (!toBake[type])
+			{
+				continue;
+			}
+			const NoiseTextureInfo& info = TEXTURES[type];
+			vk::DescriptorSet descriptorSet = descriptorAllocator->allocate(setLayout);
+			std::vector<DescriptorInfo> descriptorData = updateTemplate->createData();
+			descriptorData[updateTemplate->slot(0)].buffer = vk::DescriptorBufferInfo{ staging[type].buffer, 0, staging[type].size };
+			updateTemplate->update(descriptorSet, descriptorData);
+
+			NoiseBakePushConstants constants{ type, info.resolution, info.octaves };
+			bakePipeline->bindDescriptorSets(commandBuffer, 0, { descriptorSet });
+			bakePipeline->pushConstants(commandBuffer, &constants);
+			// Two texels per invocation
+			bakePipeline->dispatch(commandBuffer, info.resolution / 2, info.resolution, info.dimensions == 3 ? info.resolution : 1);
+		}
+	}
+
+	void NoiseCache::createImage(NoiseType type)
+	{
+		const NoiseTextureInfo& info = TEXTURES[type];
+		uint32_t depth = info.dimensions == 3 ? info.resolution : 1;
+		vk::ImageCreateInfo imageInfo{ {}, info.dimensions == 3 ? vk::ImageType::e3D : vk::ImageType::e2D, FORMAT, vk::Extent3D{ info.resolution, info.resolution, depth }, 1, 1,
+			vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst, vk::SharingMode::eExclusive };
+		device->createImageWithInfo(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, images[type], imageMemories[type]);
+
+		imageViews[type] = device->device().createImageView(vk::ImageViewCreateInfo{ {}, images[type], info.dimensions == 3 ? vk::ImageViewType::e3D : vk::ImageViewType::e2D,
+			FORMAT, {}, { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } });
+		if (!imageViews[type])
+		{
+			throw std::runtime_error("Failed to create noise image view");
+		}
+	}
+
+	void NoiseCache::upload(vk::CommandBuffer commandBuffer, NoiseType type, const StagingBuffer& staging)
+	{
+		const NoiseTextureInfo& info = TEXTURES[type];
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+		vk::ImageMemoryBarrier toTransfer{ {}, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, images[type], subresourceRange };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, nullptr, nullptr, toTransfer);
+
+		vk::BufferImageCopy region{ 0, 0, 0, { vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, { 0, 0, 0 },
+			{ info.resolution, info.resolution, info.dimensions == 3 ? info.resolution : 1 } };
+		commandBuffer.copyBufferToImage(staging.buffer, images[type], vk::ImageLayout::eTransferDstOptimal, region);
+
+		// Sampled by compute and fragment shaders alike
+		vk::ImageMemoryBarrier toShader{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, images[type], subresourceRange };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader, {}, nullptr, nullptr, toShader);
+	}
+
+	vk::DeviceSize NoiseCache::texelBytes(const NoiseTextureInfo& info)
+	{
+		vk::DeviceSize texels = static_cast<vk::DeviceSize>(info.resolution) * info.resolution;
+		if (info.dimensions == 3)
+		{
+			texels *= info.resolution;
+		}
+		// One half float each
+		return texels * sizeof(uint16_t);
+	}
+}
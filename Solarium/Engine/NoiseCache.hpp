@@ -0,0 +1,96 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineRegistry.hpp"
+
+#include <array>
+#include <string>
+
+namespace Solarium
+{
+	// Push constants of noise_bake.comp
+	struct NoiseBakePushConstants {
+		uint32_t noiseType;
+		uint32_t resolution;
+		uint32_t octaves;
+	};
+
+	// Tileable Worley and cyclic noise from Shaders/noise.glsl baked into r16f textures, for shaders that define
+	// NOISE_TEXTURES to sample instead of evaluating the noise. Textures are baked by noise_bake.comp the first time
+	// and saved to the cache directory; later runs load them from there, until the noise shaders change.
+	class NoiseCache
+	{
+	public:
+		// Same order as the bindings declared in noise.glsl and the NOISE_ defines of noise_bake.comp
+		enum NoiseType {
+			WORLEY,
+			FBM_WORLEY,
+			FBM_CYCLIC,
+			FBM_CYCLIC_2D,
+			NOISE_TYPE_COUNT
+		};
+
+		struct NoiseTextureInfo {
+			// Also the cache file name
+			const char* name;
+			uint32_t dimensions;
+			// Texels along each side, even
+			uint32_t resolution;
+			// Past a few octaves the finest one has fewer than a few texels per period and only adds aliasing
+			uint32_t octaves;
+		};
+		static constexpr std::array<NoiseTextureInfo, NOISE_TYPE_COUNT> TEXTURES{ {
+			{ "worley", 3, 64, 1 },
+			{ "fbmworley", 3, 128, 4 },
+			{ "fbmcyclic", 3, 128, 4 },
+			{ "fbmcyclic2d", 2, 512, 6 } } };
+		static constexpr vk::Format FORMAT = vk::Format::eR16Sfloat;
+
+		NoiseCache(Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, const std::string& cacheDirectory_ = "noise_cache");
+		~NoiseCache();
+		NoiseCache(const NoiseCache&) = delete;
+		NoiseCache& operator=(const NoiseCache&) = delete;
+
+		// Loads or bakes every texture, waiting for the GPU to finish
+		void createChain();
+		void cleanup();
+		void update(Device* device_) { device = device_; }
+
+		// For a combined image sampler
+		vk::DescriptorImageInfo getDescriptorInfo(NoiseType type) { return vk::DescriptorImageInfo{ sampler, imageViews[type], vk::ImageLayout::eShaderReadOnlyOptimal }; }
+
+	private:
+		struct StagingBuffer {
+			vk::Buffer buffer;
+			vk::DeviceMemory memory;
+			void* mapped = nullptr;
+			vk::DeviceSize size = 0;
+		};
+
+		// Keys the cache files on the noise shaders' source, so editing the noise invalidates them
+		uint64_t hashShaderSources();
+		std::string cacheFilePath(NoiseType type, uint64_t sourceHash);
+		bool loadTexels(const std::string& path, StagingBuffer& staging);
+		void saveTexels(const std::string& path, const StagingBuffer& staging);
+		// Records the bake of every type flagged in toBake into its staging buffer
+		void bake(vk::CommandBuffer commandBuffer, const std::array<bool, NOISE_TYPE_COUNT>& toBake, std::array<StagingBuffer, NOISE_TYPE_COUNT>& staging);
+		void createImage(NoiseType type);
+		void upload(vk::CommandBuffer commandBuffer, NoiseType type, const StagingBuffer& staging);
+
+		static vk::DeviceSize texelBytes(const NoiseTextureInfo& info);
+
+		Device* device;
+		DescriptorLayoutCache* layoutCache;
+		DescriptorAllocator* descriptorAllocator;
+		PipelineRegistry* pipelineRegistry;
+		std::string cacheDirectory;
+
+		std::array<vk::Image, NOISE_TYPE_COUNT> images{};
+		std::array<vk::DeviceMemory, NOISE_TYPE_COUNT> imageMemories{};
+		std::array<vk::ImageView, NOISE_TYPE_COUNT> imageViews{};
+		vk::Sampler sampler;
+	};
+}
@@ -1,5 +1,6 @@
 #include "Pipeline.hpp"
 #include "ShaderHelper.hpp"
+#include "GraphicsPipelineLibrary.hpp"
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
@@ -12,6 +13,97 @@ namespace Solarium
 		createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
 	}
 
+	Pipeline::Pipeline(Device& device, const PipelineConfigInfo& configInfo, const std::vector<vk::Pipeline>& libraries, bool linkTimeOptimize) : ldevice{ device }
+	{
+		vk::PipelineLibraryCreateInfoKHR linkInfo{ libraries };
+
+		vk::GraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.pNext = &linkInfo;
+		if (linkTimeOptimize)
+		{
+			pipelineInfo.flags = vk::PipelineCreateFlags(GraphicsPipelineLibrary::LINK_TIME_OPTIMIZATION);
+		}
+		pipelineInfo.layout = configInfo.pipelineLayout;
+		pipelineLayout = configInfo.pipelineLayout;
+		pushConstantRange = configInfo.pushConstantRange;
+		pipelineInfo.basePipelineIndex = -1;
+
+		graphicsPipeline = ldevice.device().createGraphicsPipelines(configInfo.pipelineCache, pipelineInfo).value[0];
+		if (!graphicsPipeline) {
+			throw std::runtime_error("Failed to link graphics pipeline.");
+		}
+	}
+
+	vk::Pipeline Pipeline::createLibrary(Device& device, const PipelineConfigInfo& configInfo, VkFlags part)
+	{
+		using namespace GraphicsPipelineLibrary;
+
+		CreateInfo libraryInfo;
+		libraryInfo.flags = part;
+		vk::GraphicsPipelineCreateInfo pipelineInfo{};
+		pipelineInfo.pNext = &libraryInfo;
+		// Keep enough of the library around for an optimized link later on
+		pipelineInfo.flags = vk::PipelineCreateFlagBits::eLibraryKHR | vk::PipelineCreateFlags(RETAIN_LINK_TIME_OPTIMIZATION_INFO);
+		pipelineInfo.basePipelineIndex = -1;
+
+		vk::PipelineVertexInputStateCreateInfo vertexInputInfo{ {}, configInfo.bindingDescriptions, configInfo.attributeDescriptions };
+		vk::PipelineViewportStateCreateInfo viewportInfo{ {}, 1, &configInfo.viewport, 1, &configInfo.scissor };
+		vk::PipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+		colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+
+		vk::ShaderStageFlags partStages;
+		switch (part)
+		{
+		case VERTEX_INPUT_INTERFACE:
+			pipelineInfo.pVertexInputState = &vertexInputInfo;
+			pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
+			break;
+		case PRE_RASTERIZATION_SHADERS:
+			partStages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eTessellationControl | vk::ShaderStageFlagBits::eTessellationEvaluation | vk::ShaderStageFlagBits::eGeometry;
+			pipelineInfo.pViewportState = &viewportInfo;
+			pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
+			pipelineInfo.layout = configInfo.pipelineLayout;
+			break;
+		case FRAGMENT_SHADER:
+			partStages = vk::ShaderStageFlagBits::eFragment;
+			pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+			pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
+			pipelineInfo.layout = configInfo.pipelineLayout;
+			break;
+		case FRAGMENT_OUTPUT_INTERFACE:
+			pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
+			pipelineInfo.pColorBlendState = &colorBlendInfo;
+			break;
+		default:
+			throw std::runtime_error("Unknown graphics pipeline library part.");
+		}
+
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+		for (const vk::PipelineShaderStageCreateInfo& stage : configInfo.shaderStages)
+		{
+			if (partStages & stage.stage)
+			{
+				shaderStages.push_back(stage);
+			}
+		}
+		vk::SpecializationInfo specializationInfo;
+		shaderStages = specializeStages(shaderStages, configInfo, specializationInfo);
+		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineInfo.pStages = shaderStages.data();
+
+		if (part != VERTEX_INPUT_INTERFACE)
+		{
+			pipelineInfo.renderPass = configInfo.renderPass;
+			pipelineInfo.subpass = configInfo.subpass;
+		}
+
+		vk::Pipeline library = device.device().createGraphicsPipelines(configInfo.pipelineCache, pipelineInfo).value[0];
+		if (!library) {
+			throw std::runtime_error("Failed to create graphics pipeline library.");
+		}
+		return library;
+	}
+
 	std::vector<char> Pipeline::readFile(const std::string& filepath)
 	{
 		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
@@ -45,20 +137,17 @@ namespace Solarium
 		//assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
 
 
-		auto bindingDescription = Vertex::getBindingDescription();
-		auto attributeDescription = Vertex::getAttributeDescriptions();
-		
-		ShaderHelper* shaderHelper = new ShaderHelper("../../../Shaders", configInfo, ldevice.device());
-		std::vector<ShaderModules> modules = shaderHelper->getShaderModules();
-		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
-		shaderStages.reserve(modules.size());
-		for (auto& module : modules)
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = configInfo.shaderStages;
+		if (shaderStages.empty())
 		{
-			shaderStages.push_back({{}, module.shaderType, module.module, "main"});
+			ShaderHelper* shaderHelper = new ShaderHelper("../../../Shaders", configInfo, ldevice.device());
+			shaderStages = shaderHelper->getShaderStages();
 		}
+		vk::SpecializationInfo specializationInfo;
+		shaderStages = specializeStages(shaderStages, configInfo, specializationInfo);
 
 
-		vk::PipelineVertexInputStateCreateInfo vertexInputInfo{{},bindingDescription,attributeDescription};
+		vk::PipelineVertexInputStateCreateInfo vertexInputInfo{{}, configInfo.bindingDescriptions, configInfo.attributeDescriptions};
 		vk::PipelineViewportStateCreateInfo viewportInfo{ {}, 1, &configInfo.viewport, 1, &configInfo.scissor};
 
 		vk::GraphicsPipelineCreateInfo pipelineInfo{};
@@ -70,24 +159,67 @@ namespace Solarium
 		pipelineInfo.pViewportState = &viewportInfo;
 		pipelineInfo.pRasterizationState = &configInfo.rasterizationInfo;
 		pipelineInfo.pMultisampleState = &configInfo.multisampleInfo;
-		pipelineInfo.pColorBlendState = &configInfo.colorBlendInfo;
+		// Point at this config's attachment state; copies of a config would otherwise keep pointing at the original
+		vk::PipelineColorBlendStateCreateInfo colorBlendInfo = configInfo.colorBlendInfo;
+		colorBlendInfo.pAttachments = &configInfo.colorBlendAttachment;
+		pipelineInfo.pColorBlendState = &colorBlendInfo;
 		pipelineInfo.pDepthStencilState = &configInfo.depthStencilInfo;
 		pipelineInfo.pDynamicState = nullptr;
 
 		pipelineInfo.layout = configInfo.pipelineLayout;
+		pipelineLayout = configInfo.pipelineLayout;
+		pushConstantRange = configInfo.pushConstantRange;
 		pipelineInfo.renderPass = configInfo.renderPass;
 		pipelineInfo.subpass = configInfo.subpass;
 
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = nullptr;
 
-		graphicsPipeline = ldevice.device().createGraphicsPipelines({}, pipelineInfo).value[0];
+		graphicsPipeline = ldevice.device().createGraphicsPipelines(configInfo.pipelineCache, pipelineInfo).value[0];
 		if (!graphicsPipeline) {
 			throw std::runtime_error("Failed to create graphics pipeline.");
 		}
 
 	}
 
+	std::vector<vk::PipelineShaderStageCreateInfo> Pipeline::specializeStages(const std::vector<vk::PipelineShaderStageCreateInfo>& shaderStages, const PipelineConfigInfo& configInfo, vk::SpecializationInfo& specializationInfo)
+	{
+		if (configInfo.specializationEntries.empty())
+		{
+			return shaderStages;
+		}
+		specializationInfo = vk::SpecializationInfo{ static_cast<uint32_t>(configInfo.specializationEntries.size()), configInfo.specializationEntries.data(), configInfo.specializationData.size(), configInfo.specializationData.data() };
+
+		std::vector<vk::PipelineShaderStageCreateInfo> specializedStages = shaderStages;
+		for (vk::PipelineShaderStageCreateInfo& stage : specializedStages)
+		{
+			stage.pSpecializationInfo = &specializationInfo;
+		}
+		return specializedStages;
+	}
+
+	ShaderQuality ShaderQuality::forTier(QualityTier tier)
+	{
+		switch (tier)
+		{
+		case QUALITY_LOW:
+			return ShaderQuality{ 4, 32, 1e-3f, 16.0f };
+		case QUALITY_MEDIUM:
+			return ShaderQuality{ 12, 64, 5e-4f, 24.0f };
+		default:
+			return ShaderQuality{ DEFAULT_MAX_BOUNCES, DEFAULT_MAX_MARCHES, DEFAULT_COLLISION_DISTANCE, DEFAULT_MAX_DISTANCE };
+		}
+	}
+
+	std::array<vk::SpecializationMapEntry, 4> ShaderQuality::getMapEntries()
+	{
+		return {
+			vk::SpecializationMapEntry{ MAX_BOUNCES_CONSTANT, offsetof(ShaderQuality, maxBounces), sizeof(uint32_t) },
+			vk::SpecializationMapEntry{ MAX_MARCHES_CONSTANT, offsetof(ShaderQuality, maxMarches), sizeof(uint32_t) },
+			vk::SpecializationMapEntry{ COLLISION_DISTANCE_CONSTANT, offsetof(ShaderQuality, collisionDistance), sizeof(float) },
+			vk::SpecializationMapEntry{ MAX_DISTANCE_CONSTANT, offsetof(ShaderQuality, maxDistance), sizeof(float) } };
+	}
+
 	void Pipeline::createShaderModule(const std::vector<char>& code, vk::ShaderModule* shaderModule)
 	{
 		vk::ShaderModuleCreateInfo createInfo{};
@@ -106,10 +238,23 @@ namespace Solarium
 		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, graphicsPipeline);
 	}
 
+	void Pipeline::pushDrawConstants(vk::CommandBuffer commandBuffer, const DrawPushConstants& constants)
+	{
+		if (pushConstantRange.size == 0)
+		{
+			return;
+		}
+		commandBuffer.pushConstants(pipelineLayout, pushConstantRange.stageFlags, pushConstantRange.offset, pushConstantRange.size, reinterpret_cast<const char*>(&constants) + pushConstantRange.offset);
+	}
+
 	PipelineConfigInfo Pipeline::defaultPipelineConfigInfo(uint32_t width, uint32_t height)
 	{
 		PipelineConfigInfo configInfo{};
 
+		auto attributeDescription = Vertex::getAttributeDescriptions();
+		configInfo.bindingDescriptions = { Vertex::getBindingDescription() };
+		configInfo.attributeDescriptions.assign(attributeDescription.begin(), attributeDescription.end());
+
 		configInfo.inputAssemblyInfo.topology = vk::PrimitiveTopology::eTriangleList;
 		configInfo.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
 
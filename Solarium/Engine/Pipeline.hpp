@@ -1,7 +1,9 @@
 #pragma once
 
 #include "Device.hpp"
+#include "../Shaders/quality.h"
 #include <glm/glm.hpp>
+#include <array>
 #include <string>
 #include <vector>
 
@@ -27,6 +29,63 @@ namespace Solarium
 		}
 	};
 
+	// Per-object data, read by the vertex shader from the storage buffer in the per-pass set at gl_InstanceIndex.
+	// Padded to the std430 array stride of the matching GLSL struct.
+	struct InstanceData {
+		glm::mat4 model;
+		// viewProj * draw model * model, batched on the CPU by Scene::updateTransforms
+		glm::mat4 mvp;
+		// Inverse transpose of model, for shaders that transform normals
+		glm::mat4 normalMatrix;
+		// Slot of the instance's texture in the bindless table
+		uint32_t textureIndex;
+		uint32_t padding[3];
+	};
+	static_assert(sizeof(InstanceData) == 208, "InstanceData must match the std430 layout of ObjectData in main.vert");
+
+	// Descriptor set slots, ordered from least to most frequently rebound
+	enum DescriptorSetIndex : uint32_t {
+		FRAME_SET = 0,
+		PASS_SET = 1,
+		MATERIAL_SET = 2,
+		DESCRIPTOR_SET_COUNT = 3
+	};
+
+	// Small per-draw data passed as push constants, so changing it between draws needs no buffer write or descriptor bind.
+	// 68 bytes, well inside the 128 bytes every device guarantees.
+	struct DrawPushConstants {
+		// Applied on the CPU: Scene::updateTransforms folds it into every InstanceData::mvp
+		glm::mat4 model;
+		// Bindless texture slot for instances whose own texture index is DRAW_MATERIAL
+		uint32_t materialIndex;
+	};
+
+	// Specialization constant ids of the quality parameters, as declared in Shaders/quality.glsl
+	enum ShaderQualityConstant : uint32_t {
+		MAX_BOUNCES_CONSTANT = MAX_BOUNCES_CONSTANT_ID,
+		MAX_MARCHES_CONSTANT = MAX_MARCHES_CONSTANT_ID,
+		COLLISION_DISTANCE_CONSTANT = COLLISION_DISTANCE_CONSTANT_ID,
+		MAX_DISTANCE_CONSTANT = MAX_DISTANCE_CONSTANT_ID
+	};
+
+	enum QualityTier : uint32_t {
+		QUALITY_LOW = 0,
+		QUALITY_MEDIUM = 1,
+		QUALITY_HIGH = 2
+	};
+
+	// Values for the quality specialization constants; the field order is the layout of the specialization data
+	struct ShaderQuality {
+		uint32_t maxBounces;
+		uint32_t maxMarches;
+		float collisionDistance;
+		float maxDistance;
+
+		// QUALITY_HIGH is the shader defaults from Shaders/quality.h
+		static ShaderQuality forTier(QualityTier tier);
+		static std::array<vk::SpecializationMapEntry, 4> getMapEntries();
+	};
+
 	struct PipelineConfigInfo {
 		vk::Viewport viewport;
 		vk::Rect2D scissor;
@@ -36,9 +95,23 @@ namespace Solarium
 		vk::PipelineColorBlendAttachmentState colorBlendAttachment;
 		vk::PipelineColorBlendStateCreateInfo colorBlendInfo;
 		vk::PipelineDepthStencilStateCreateInfo depthStencilInfo;
+		std::vector<vk::VertexInputBindingDescription> bindingDescriptions;
+		std::vector<vk::VertexInputAttributeDescription> attributeDescriptions;
+		// Left empty, the pipeline compiles the shaders itself
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+		// Identifies the code behind shaderStages, see ShaderHelper::getShaderHash
+		uint64_t shaderHash = 0;
+		// Specialization applied to every stage; a stage ignores constant ids it does not declare. Held by value so
+		// copies of the config stay valid.
+		std::vector<vk::SpecializationMapEntry> specializationEntries;
+		std::vector<char> specializationData;
+		// Part of DrawPushConstants the layout declares, as reflected from the shaders; empty when no stage reads it
+		vk::PushConstantRange pushConstantRange{ vk::ShaderStageFlagBits::eVertex, 0, sizeof(DrawPushConstants) };
 		vk::PipelineLayout pipelineLayout = nullptr;
 		vk::RenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		// Not part of the pipeline state
+		vk::PipelineCache pipelineCache = nullptr;
 	};
 
 	class Pipeline
@@ -49,12 +122,20 @@ namespace Solarium
 			const std::string& vertFilepath,
 			const std::string& fragFilepath,
 			const PipelineConfigInfo& configInfo);
+		// Links pipeline libraries into a complete pipeline. Without link time optimization this is fast enough
+		// to do on demand; with it the driver recompiles across the parts, which is slower but gives faster code.
+		Pipeline(
+			Device& device,
+			const PipelineConfigInfo& configInfo,
+			const std::vector<vk::Pipeline>& libraries,
+			bool linkTimeOptimize);
 
 		~Pipeline();
 		Pipeline(const Pipeline&) = delete;
 		void operator=(const Pipeline&) = delete;
 		
 		void bind(vk::CommandBuffer commandBuffer);
+		void pushDrawConstants(vk::CommandBuffer commandBuffer, const DrawPushConstants& constants);
 
 		static PipelineConfigInfo defaultPipelineConfigInfo(uint32_t width, uint32_t height);
 		void createGraphicsPipeline(
@@ -62,13 +143,20 @@ namespace Solarium
 			const std::string& fragFilepath,
 			const PipelineConfigInfo& configInfo);
 		VkPipeline getGraphicsPipeline() { return graphicsPipeline; }
+		// Compiles one part of configInfo as a pipeline library, see GraphicsPipelineLibrary::Part. Only the state and
+		// shader stages that belong to the part are used. The caller owns the returned library.
+		static vk::Pipeline createLibrary(Device& device, const PipelineConfigInfo& configInfo, VkFlags part);
 
 	private:
 		static std::vector<char> readFile(const std::string& filepath);
+		// Points every stage at specializationInfo when configInfo carries specialization constants
+		static std::vector<vk::PipelineShaderStageCreateInfo> specializeStages(const std::vector<vk::PipelineShaderStageCreateInfo>& shaderStages, const PipelineConfigInfo& configInfo, vk::SpecializationInfo& specializationInfo);
 		void createShaderModule(const std::vector<char>& code, vk::ShaderModule* shaderModule);
 
 		Device& ldevice;
 		vk::Pipeline graphicsPipeline;
+		vk::PipelineLayout pipelineLayout;
+		vk::PushConstantRange pushConstantRange;
 		vk::ShaderModule vertShaderModule;
 		vk::ShaderModule fragShaderModule;
 
@@ -0,0 +1,467 @@
+#include "PipelineRegistry.hpp"
+#include "Logger.hpp"
+#include "GraphicsPipelineLibrary.hpp"
+#include <cstring>
+#include <fstream>
+
+namespace Solarium
+{
+	namespace
+	{
+		void pushFloat(std::vector<uint32_t>& key, float value)
+		{
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			key.push_back(bits);
+		}
+
+		void pushHandle(std::vector<uint32_t>& key, uint64_t handle)
+		{
+			key.push_back(static_cast<uint32_t>(handle));
+			key.push_back(static_cast<uint32_t>(handle >> 32));
+		}
+	}
+
+	PipelineRegistry::PipelineRegistry(Device* device_, JobSystem* jobSystem_, const std::string& cachePath_)
+	{
+		device = device_;
+		jobSystem = jobSystem_;
+		cachePath = cachePath_;
+	}
+
+	PipelineRegistry::~PipelineRegistry()
+	{
+		cleanup();
+	}
+
+	void PipelineRegistry::createChain()
+	{
+		std::vector<char> cacheData = loadCacheData();
+		vk::PipelineCacheCreateInfo cacheInfo{ {}, cacheData.size(), cacheData.data() };
+		pipelineCache = device->device().createPipelineCache(cacheInfo);
+		if (!pipelineCache)
+		{
+			throw std::runtime_error("Failed to create pipeline cache");
+		}
+	}
+
+	void PipelineRegistry::cleanup()
+	{
+		for (uint32_t pending = pendingCompiles.load(); pending > 0; pending = pendingCompiles.load())
+		{
+			pendingCompiles.wait(pending);
+		}
+
+		for (auto& entry : pipelines)
+		{
+			delete entry.second->optimizedPipeline;
+			delete entry.second->pipeline;
+		}
+		pipelines.clear();
+		// Linked pipelines do not reference their libraries, but destroy them last anyway
+		for (auto& entry : libraries)
+		{
+			device->device().destroyPipeline(entry.second);
+		}
+		libraries.clear();
+		for (auto& entry : computePipelines)
+		{
+			delete entry.second->pipeline;
+		}
+		computePipelines.clear();
+
+		if (pipelineCache)
+		{
+			saveCacheData();
+			device->device().destroyPipelineCache(pipelineCache);
+			pipelineCache = nullptr;
+		}
+	}
+
+	Pipeline* PipelineRegistry::getPipeline(const PipelineConfigInfo& configInfo)
+	{
+		if (configInfo.shaderHash == 0 || configInfo.shaderStages.empty())
+		{
+			throw std::runtime_error("Registered pipelines need compiled shader stages and a shader hash");
+		}
+
+		StateKey key = makeKey(configInfo);
+		auto it = pipelines.find(key);
+		if (it == pipelines.end())
+		{
+			it = pipelines.emplace(std::move(key), std::make_unique<PipelineSlot>()).first;
+			pendingCompiles++;
+			compile(it->second.get(), configInfo, false);
+		}
+
+		PipelineSlot* slot = it->second.get();
+		slot->finished.wait(false, std::memory_order_acquire);
+		if (!slot->pipeline)
+		{
+			throw std::runtime_error("Failed to create graphics pipeline.");
+		}
+		return slot->pipeline;
+	}
+
+	PipelineRegistry::PipelineSlot* PipelineRegistry::requestPipeline(const PipelineConfigInfo& configInfo)
+	{
+		if (configInfo.shaderHash == 0 || configInfo.shaderStages.empty())
+		{
+			throw std::runtime_error("Registered pipelines need compiled shader stages and a shader hash");
+		}
+
+		StateKey key = makeKey(configInfo);
+		auto it = pipelines.find(key);
+		if (it != pipelines.end())
+		{
+			for (const vk::PipelineShaderStageCreateInfo& stage : configInfo.shaderStages)
+			{
+				device->device().destroyShaderModule(stage.module);
+			}
+			return it->second.get();
+		}
+
+		PipelineSlot* slot = pipelines.emplace(std::move(key), std::make_unique<PipelineSlot>()).first->second.get();
+		pendingCompiles++;
+		jobSystem->execute([this, slot, configInfo]() { compile(slot, configInfo, true); });
+		return slot;
+	}
+
+	ComputePipeline* PipelineRegistry::getComputePipeline(const ComputePipelineConfigInfo& configInfo)
+	{
+		if (configInfo.shaderHash == 0 || !configInfo.shaderStage.module)
+		{
+			throw std::runtime_error("Registered pipelines need compiled shader stages and a shader hash");
+		}
+
+		StateKey key = makeKey(configInfo);
+		auto it = computePipelines.find(key);
+		if (it == computePipelines.end())
+		{
+			it = computePipelines.emplace(std::move(key), std::make_unique<ComputePipelineSlot>()).first;
+			pendingCompiles++;
+			compile(it->second.get(), configInfo, false);
+		}
+
+		ComputePipelineSlot* slot = it->second.get();
+		slot->finished.wait(false, std::memory_order_acquire);
+		if (!slot->pipeline)
+		{
+			throw std::runtime_error("Failed to create compute pipeline.");
+		}
+		return slot->pipeline;
+	}
+
+	PipelineRegistry::ComputePipelineSlot* PipelineRegistry::requestComputePipeline(const ComputePipelineConfigInfo& configInfo)
+	{
+		if (configInfo.shaderHash == 0 || !configInfo.shaderStage.module)
+		{
+			throw std::runtime_error("Registered pipelines need compiled shader stages and a shader hash");
+		}
+
+		StateKey key = makeKey(configInfo);
+		auto it = computePipelines.find(key);
+		if (it != computePipelines.end())
+		{
+			device->device().destroyShaderModule(configInfo.shaderStage.module);
+			return it->second.get();
+		}
+
+		ComputePipelineSlot* slot = computePipelines.emplace(std::move(key), std::make_unique<ComputePipelineSlot>()).first->second.get();
+		pendingCompiles++;
+		jobSystem->execute([this, slot, configInfo]() { compile(slot, configInfo, true); });
+		return slot;
+	}
+
+	void PipelineRegistry::compile(PipelineSlot* slot, PipelineConfigInfo configInfo, bool destroyShaderModules)
+	{
+		// vkCreateGraphicsPipelines may use one cache from several threads at once
+		configInfo.pipelineCache = pipelineCache;
+		if (device->graphicsPipelineLibraryEnabled)
+		{
+			try
+			{
+				std::vector<vk::Pipeline> libraryParts;
+				for (VkFlags part : GraphicsPipelineLibrary::PARTS)
+				{
+					libraryParts.push_back(getLibrary(configInfo, part));
+				}
+				slot->pipeline = new Pipeline(*device, configInfo, libraryParts, false);
+
+				// The fast link is usable right away; swap in the optimized link once a worker has built it
+				pendingCompiles++;
+				jobSystem->execute([this, slot, configInfo, libraryParts]() { optimize(slot, configInfo, libraryParts); });
+			}
+			catch (const std::exception& error)
+			{
+				Logger::Error("Pipeline library link failed, compiling the whole pipeline instead: %s", error.what());
+			}
+		}
+		if (!slot->pipeline)
+		{
+			try
+			{
+				slot->pipeline = new Pipeline(*device, "", "", configInfo);
+			}
+			catch (const std::exception& error)
+			{
+				Logger::Error("Pipeline compilation failed: %s", error.what());
+			}
+		}
+
+		if (destroyShaderModules)
+		{
+			for (const vk::PipelineShaderStageCreateInfo& stage : configInfo.shaderStages)
+			{
+				device->device().destroyShaderModule(stage.module);
+			}
+		}
+
+		slot->finished.store(true, std::memory_order_release);
+		slot->finished.notify_all();
+		pendingCompiles--;
+		pendingCompiles.notify_all();
+	}
+
+	void PipelineRegistry::compile(ComputePipelineSlot* slot, ComputePipelineConfigInfo configInfo, bool destroyShaderModule)
+	{
+		configInfo.pipelineCache = pipelineCache;
+		try
+		{
+			slot->pipeline = new ComputePipeline(*device, configInfo);
+		}
+		catch (const std::exception& error)
+		{
+			Logger::Error("Compute pipeline compilation failed: %s", error.what());
+		}
+
+		if (destroyShaderModule)
+		{
+			device->device().destroyShaderModule(configInfo.shaderStage.module);
+		}
+
+		slot->finished.store(true, std::memory_order_release);
+		slot->finished.notify_all();
+		pendingCompiles--;
+		pendingCompiles.notify_all();
+	}
+
+	vk::Pipeline PipelineRegistry::getLibrary(const PipelineConfigInfo& configInfo, VkFlags part)
+	{
+		StateKey key{ part };
+		appendPartKey(key, configInfo, part);
+		{
+			std::lock_guard<std::mutex> lock(librariesMutex);
+			auto it = libraries.find(key);
+			if (it != libraries.end())
+			{
+				return it->second;
+			}
+		}
+
+		// Built outside the lock so workers compiling different parts do not wait on each other
+		vk::Pipeline library = Pipeline::createLibrary(*device, configInfo, part);
+		std::lock_guard<std::mutex> lock(librariesMutex);
+		auto inserted = libraries.emplace(std::move(key), library);
+		if (!inserted.second)
+		{
+			// Another worker built the same part in the meantime
+			device->device().destroyPipeline(library);
+		}
+		return inserted.first->second;
+	}
+
+	void PipelineRegistry::optimize(PipelineSlot* slot, PipelineConfigInfo configInfo, std::vector<vk::Pipeline> libraryParts)
+	{
+		try
+		{
+			slot->optimizedPipeline = new Pipeline(*device, configInfo, libraryParts, true);
+			slot->optimized.store(true, std::memory_order_release);
+		}
+		catch (const std::exception& error)
+		{
+			Logger::Error("Optimized pipeline link failed, keeping the fast link: %s", error.what());
+		}
+
+		pendingCompiles--;
+		pendingCompiles.notify_all();
+	}
+
+	PipelineRegistry::StateKey PipelineRegistry::makeKey(const PipelineConfigInfo& configInfo)
+	{
+		StateKey key;
+		for (VkFlags part : GraphicsPipelineLibrary::PARTS)
+		{
+			appendPartKey(key, configInfo, part);
+		}
+		return key;
+	}
+
+	void PipelineRegistry::appendPartKey(StateKey& key, const PipelineConfigInfo& configInfo, VkFlags part)
+	{
+		using namespace GraphicsPipelineLibrary;
+
+		// The shader parts are keyed by the hash of every stage, so they are only shared between pipelines running the same shaders
+		if (part == PRE_RASTERIZATION_SHADERS || part == FRAGMENT_SHADER)
+		{
+			pushHandle(key, configInfo.shaderHash);
+			for (const vk::PipelineShaderStageCreateInfo& stage : configInfo.shaderStages)
+			{
+				key.push_back(static_cast<uint32_t>(stage.stage));
+			}
+			for (const vk::SpecializationMapEntry& entry : configInfo.specializationEntries)
+			{
+				key.insert(key.end(), { entry.constantID, entry.offset, static_cast<uint32_t>(entry.size) });
+			}
+			for (char byte : configInfo.specializationData)
+			{
+				key.push_back(static_cast<uint8_t>(byte));
+			}
+			// Layouts are deduplicated by DescriptorLayoutCache, so equal handles mean equal layouts
+			pushHandle(key, (uint64_t)static_cast<VkPipelineLayout>(configInfo.pipelineLayout));
+		}
+
+		switch (part)
+		{
+		case VERTEX_INPUT_INTERFACE:
+		{
+			for (const vk::VertexInputBindingDescription& binding : configInfo.bindingDescriptions)
+			{
+				key.insert(key.end(), { binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate) });
+			}
+			for (const vk::VertexInputAttributeDescription& attribute : configInfo.attributeDescriptions)
+			{
+				key.insert(key.end(), { attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format), attribute.offset });
+			}
+			key.insert(key.end(), { static_cast<uint32_t>(configInfo.inputAssemblyInfo.topology), configInfo.inputAssemblyInfo.primitiveRestartEnable });
+			return;
+		}
+		case PRE_RASTERIZATION_SHADERS:
+		{
+			pushFloat(key, configInfo.viewport.x);
+			pushFloat(key, configInfo.viewport.y);
+			pushFloat(key, configInfo.viewport.width);
+			pushFloat(key, configInfo.viewport.height);
+			pushFloat(key, configInfo.viewport.minDepth);
+			pushFloat(key, configInfo.viewport.maxDepth);
+			key.insert(key.end(), { static_cast<uint32_t>(configInfo.scissor.offset.x), static_cast<uint32_t>(configInfo.scissor.offset.y), configInfo.scissor.extent.width, configInfo.scissor.extent.height });
+
+			const vk::PipelineRasterizationStateCreateInfo& raster = configInfo.rasterizationInfo;
+			key.insert(key.end(), { raster.depthClampEnable, raster.rasterizerDiscardEnable, static_cast<uint32_t>(raster.polygonMode),
+				static_cast<uint32_t>(static_cast<VkCullModeFlags>(raster.cullMode)), static_cast<uint32_t>(raster.frontFace), raster.depthBiasEnable });
+			pushFloat(key, raster.depthBiasConstantFactor);
+			pushFloat(key, raster.depthBiasClamp);
+			pushFloat(key, raster.depthBiasSlopeFactor);
+			pushFloat(key, raster.lineWidth);
+			break;
+		}
+		case FRAGMENT_SHADER:
+		case FRAGMENT_OUTPUT_INTERFACE:
+		{
+			const vk::PipelineMultisampleStateCreateInfo& multisample = configInfo.multisampleInfo;
+			key.insert(key.end(), { static_cast<uint32_t>(multisample.rasterizationSamples), multisample.sampleShadingEnable, multisample.alphaToCoverageEnable, multisample.alphaToOneEnable });
+			pushFloat(key, multisample.minSampleShading);
+
+			if (part == FRAGMENT_SHADER)
+			{
+				const vk::PipelineDepthStencilStateCreateInfo& depth = configInfo.depthStencilInfo;
+				key.insert(key.end(), { depth.depthTestEnable, depth.depthWriteEnable, static_cast<uint32_t>(depth.depthCompareOp), depth.depthBoundsTestEnable, depth.stencilTestEnable });
+				pushFloat(key, depth.minDepthBounds);
+				pushFloat(key, depth.maxDepthBounds);
+				for (const vk::StencilOpState& stencil : { depth.front, depth.back })
+				{
+					key.insert(key.end(), { static_cast<uint32_t>(stencil.failOp), static_cast<uint32_t>(stencil.passOp), static_cast<uint32_t>(stencil.depthFailOp),
+						static_cast<uint32_t>(stencil.compareOp), stencil.compareMask, stencil.writeMask, stencil.reference });
+				}
+				break;
+			}
+
+			const vk::PipelineColorBlendAttachmentState& blend = configInfo.colorBlendAttachment;
+			key.insert(key.end(), { blend.blendEnable, static_cast<uint32_t>(blend.srcColorBlendFactor), static_cast<uint32_t>(blend.dstColorBlendFactor), static_cast<uint32_t>(blend.colorBlendOp),
+				static_cast<uint32_t>(blend.srcAlphaBlendFactor), static_cast<uint32_t>(blend.dstAlphaBlendFactor), static_cast<uint32_t>(blend.alphaBlendOp),
+				static_cast<uint32_t>(static_cast<VkColorComponentFlags>(blend.colorWriteMask)) });
+			key.insert(key.end(), { configInfo.colorBlendInfo.logicOpEnable, static_cast<uint32_t>(configInfo.colorBlendInfo.logicOp), configInfo.colorBlendInfo.attachmentCount });
+			for (float constant : configInfo.colorBlendInfo.blendConstants)
+			{
+				pushFloat(key, constant);
+			}
+			break;
+		}
+		default:
+			return;
+		}
+
+		// Render passes are compared by handle: the engine keeps one per attachment setup, which makes this the compatibility class
+		pushHandle(key, (uint64_t)static_cast<VkRenderPass>(configInfo.renderPass));
+		key.push_back(configInfo.subpass);
+	}
+
+	PipelineRegistry::StateKey PipelineRegistry::makeKey(const ComputePipelineConfigInfo& configInfo)
+	{
+		StateKey key;
+		pushHandle(key, configInfo.shaderHash);
+		for (const vk::SpecializationMapEntry& entry : configInfo.specializationEntries)
+		{
+			key.insert(key.end(), { entry.constantID, entry.offset, static_cast<uint32_t>(entry.size) });
+		}
+		for (char byte : configInfo.specializationData)
+		{
+			key.push_back(static_cast<uint8_t>(byte));
+		}
+		pushHandle(key, (uint64_t)static_cast<VkPipelineLayout>(configInfo.pipelineLayout));
+		return key;
+	}
+
+	size_t PipelineRegistry::StateKeyHash::operator()(const StateKey& key) const
+	{
+		// FNV-1a over the serialized state
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t value : key)
+		{
+			hash = (hash ^ value) * 1099511628211ull;
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	std::vector<char> PipelineRegistry::loadCacheData()
+	{
+		std::ifstream file(cachePath, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			return {};
+		}
+		std::vector<char> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(data.data(), data.size());
+
+		// Drivers are meant to reject foreign data themselves, but not all of them do, so check the header first
+		// Header fields as laid out by the spec: header size, header version, vendor id, device id, then the UUID.
+		// Read by offset, as the bundled headers predate VkPipelineCacheHeaderVersionOne.
+		constexpr size_t HEADER_SIZE = 16 + VK_UUID_SIZE;
+		if (data.size() < HEADER_SIZE)
+		{
+			return {};
+		}
+		uint32_t headerSize, headerVersion, vendorID, deviceID;
+		std::memcpy(&headerSize, data.data() + 0, sizeof(uint32_t));
+		std::memcpy(&headerVersion, data.data() + 4, sizeof(uint32_t));
+		std::memcpy(&vendorID, data.data() + 8, sizeof(uint32_t));
+		std::memcpy(&deviceID, data.data() + 12, sizeof(uint32_t));
+		if (headerSize < HEADER_SIZE || headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || vendorID != device->properties.vendorID || deviceID != device->properties.deviceID ||
+			std::memcmp(data.data() + 16, device->properties.pipelineCacheUUID.data(), VK_UUID_SIZE) != 0)
+		{
+			return {};
+		}
+		return data;
+	}
+
+	void PipelineRegistry::saveCacheData()
+	{
+		std::vector<uint8_t> data = device->device().getPipelineCacheData(pipelineCache);
+		std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+		if (file.is_open())
+		{
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "Pipeline.hpp"
+#include "ComputePipeline.hpp"
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Solarium
+{
+
+	// Owns every graphics pipeline and hands out an existing one when the complete pipeline state matches,
+	// so materials that share state share a pipeline. All pipelines are created through one vk::PipelineCache
+	// that is loaded from and saved to disk. Pipelines can be compiled on the job system so the render thread never
+	// waits for the driver; worker threads share the same cache.
+	// With VK_EXT_graphics_pipeline_library each pipeline is linked from four separately compiled and shared parts,
+	// which makes a new combination of known parts cheap. A link time optimized version is then built in the
+	// background and replaces the fast link once ready. Without the extension whole pipelines are compiled.
+	class PipelineRegistry
+	{
+	public:
+		// Filled in by a worker once compilation has finished; the address stays valid until cleanup
+		struct PipelineSlot
+		{
+			// Null while compiling, and for good if compilation failed
+			Pipeline* get()
+			{
+				if (optimized.load(std::memory_order_acquire))
+				{
+					return optimizedPipeline;
+				}
+				return finished.load(std::memory_order_acquire) ? pipeline : nullptr;
+			}
+			bool isFinished() { return finished.load(std::memory_order_acquire); }
+
+			Pipeline* pipeline = nullptr;
+			std::atomic<bool> finished{ false };
+			// Link time optimized replacement for a pipeline linked from libraries. pipeline stays alive until cleanup
+			// since command buffers recorded before the switch may still use it.
+			Pipeline* optimizedPipeline = nullptr;
+			std::atomic<bool> optimized{ false };
+		};
+
+		// PipelineSlot for compute pipelines
+		struct ComputePipelineSlot
+		{
+			ComputePipeline* get() { return finished.load(std::memory_order_acquire) ? pipeline : nullptr; }
+			bool isFinished() { return finished.load(std::memory_order_acquire); }
+
+			ComputePipeline* pipeline = nullptr;
+			std::atomic<bool> finished{ false };
+		};
+
+		PipelineRegistry(Device* device_, JobSystem* jobSystem_, const std::string& cachePath_ = "pipeline_cache.bin");
+		~PipelineRegistry();
+		PipelineRegistry(const PipelineRegistry&) = delete;
+		PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+		// Creates the pipeline cache, seeded from disk when the saved data matches this device
+		void createChain();
+		// Waits for compilations in flight, saves the cache and destroys every pipeline
+		void cleanup();
+		void update(Device* device_) { device = device_; }
+
+		// configInfo.shaderHash must identify the shader stages; the handles in shaderStages are not compared.
+		// Compiles on the calling thread, or waits for a compilation already in flight.
+		Pipeline* getPipeline(const PipelineConfigInfo& configInfo);
+		// Returns at once and compiles on a worker when the state is new. Takes ownership of the shader modules in
+		// configInfo.shaderStages: they are destroyed after compiling, or right away when the state is already known.
+		PipelineSlot* requestPipeline(const PipelineConfigInfo& configInfo);
+		// Compute pipelines are keyed by shader hash, specialization and layout. Compiles on the calling thread, or
+		// waits for a compilation already in flight; configInfo.shaderStage.module stays owned by the caller.
+		ComputePipeline* getComputePipeline(const ComputePipelineConfigInfo& configInfo);
+		// As requestPipeline: compiles on a worker and takes ownership of configInfo.shaderStage.module
+		ComputePipelineSlot* requestComputePipeline(const ComputePipelineConfigInfo& configInfo);
+
+		vk::PipelineCache getPipelineCache() { return pipelineCache; }
+		size_t size() { return pipelines.size(); }
+		size_t librarySize() { return libraries.size(); }
+
+	private:
+		// The state serialized field by field, so equal keys mean equal pipelines
+		typedef std::vector<uint32_t> StateKey;
+
+		struct StateKeyHash
+		{
+			size_t operator()(const StateKey& key) const;
+		};
+
+		static StateKey makeKey(const PipelineConfigInfo& configInfo);
+		static StateKey makeKey(const ComputePipelineConfigInfo& configInfo);
+		// Appends the state that belongs to one library part, so a library is shared by every pipeline with an equal part
+		static void appendPartKey(StateKey& key, const PipelineConfigInfo& configInfo, VkFlags part);
+		void compile(PipelineSlot* slot, PipelineConfigInfo configInfo, bool destroyShaderModules);
+		// Finds or compiles the library for one part; safe to call from several workers
+		vk::Pipeline getLibrary(const PipelineConfigInfo& configInfo, VkFlags part);
+		void optimize(PipelineSlot* slot, PipelineConfigInfo configInfo, std::vector<vk::Pipeline> libraryParts);
+		void compile(ComputePipelineSlot* slot, ComputePipelineConfigInfo configInfo, bool destroyShaderModule);
+		std::vector<char> loadCacheData();
+		void saveCacheData();
+
+		Device* device;
+		JobSystem* jobSystem;
+		std::string cachePath;
+		vk::PipelineCache pipelineCache;
+		std::unordered_map<StateKey, std::unique_ptr<PipelineSlot>, StateKeyHash> pipelines;
+		std::unordered_map<StateKey, std::unique_ptr<ComputePipelineSlot>, StateKeyHash> computePipelines;
+		std::unordered_map<StateKey, vk::Pipeline, StateKeyHash> libraries;
+		std::mutex librariesMutex;
+		std::atomic<uint32_t> pendingCompiles{ 0 };
+	};
+}
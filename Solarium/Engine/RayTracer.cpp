@@ -0,0 +1,371 @@
+#include "RayTracer.hpp"
+#include <algorithm>
+
+namespace Solarium
+{
+	RayTracer::RayTracer(SwapChain* swapChain_, Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, DistanceField* distanceField_, NoiseCache* noiseCache_, ShaderQuality quality_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		layoutCache = layoutCache_;
+		descriptorAllocator = descriptorAllocator_;
+		pipelineRegistry = pipelineRegistry_;
+		distanceField = distanceField_;
+		noiseCache = noiseCache_;
+		quality = quality_;
+		denoiser = new Denoiser(swapChain, device, layoutCache, descriptorAllocator, pipelineRegistry);
+	}
+
+	RayTracer::~RayTracer()
+	{
+		cleanup();
+		delete denoiser;
+	}
+
+	void RayTracer::createChain()
+	{
+		createAccumulationImage();
+		denoiser->createChain(accumulationImageView);
+		createComputePipeline();
+		createPresentPipeline();
+		createDescriptorSets();
+		createBodyBuffers();
+
+		timestampsSupported = device->properties.limits.timestampComputeAndGraphics;
+		if (timestampsSupported)
+		{
+			queryPool = device->device().createQueryPool(vk::QueryPoolCreateInfo{ {}, vk::QueryType::eTimestamp, 2 * static_cast<uint32_t>(swapChain->imageCount()) });
+			if (!queryPool)
+			{
+				throw std::runtime_error("Failed to create timestamp query pool");
+			}
+		}
+		dispatchedSamples.assign(swapChain->imageCount(), 0);
+		constants.accumulatedSamples = 0;
+		presentDenoised = false;
+	}
+
+	void RayTracer::update(SwapChain* swapChain_, Device* device_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		denoiser->update(swapChain, device);
+	}
+
+	void RayTracer::cleanup()
+	{
+		if (computeShaders)
+		{
+			computeShaders->destroyShaderModules(device->device());
+			delete computeShaders;
+			computeShaders = nullptr;
+		}
+		// Pipelines, layouts and sets belong to the registry, the layout cache and the allocator
+		computePipeline = nullptr;
+		pendingComputePipeline = nullptr;
+		presentPipeline = nullptr;
+		computeDescriptorSet = nullptr;
+		presentDescriptorSet = nullptr;
+		denoisedDescriptorSet = nullptr;
+		denoiser->cleanup();
+
+		for (BodyBuffers& buffers : bodyBuffers)
+		{
+			device->device().unmapMemory(buffers.nodesMemory);
+			device->device().unmapMemory(buffers.primitivesMemory);
+			device->device().destroyBuffer(buffers.nodes);
+			device->device().destroyBuffer(buffers.primitives);
+			device->device().freeMemory(buffers.nodesMemory);
+			device->device().freeMemory(buffers.primitivesMemory);
+		}
+		bodyBuffers.clear();
+
+		device->device().destroyQueryPool(queryPool);
+		device->device().destroySampler(sampler);
+		device->device().destroyImageView(accumulationImageView);
+		device->device().destroyImage(accumulationImage);
+		device->device().freeMemory(accumulationImageMemory);
+		queryPool = nullptr;
+		sampler = nullptr;
+		accumulationImageView = nullptr;
+		accumulationImage = nullptr;
+		accumulationImageMemory = nullptr;
+	}
+
+	void RayTracer::createAccumulationImage()
+	{
+		// Float storage keeps the running mean precise over thousands of samples
+		vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, vk::Format::eR32G32B32A32Sfloat, vk::Extent3D{ swapChain->width(), swapChain->height(), 1 }, 1, 1, vk::SampleCountFlagBits::e1,
+			vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled, vk::SharingMode::eExclusive };
+		device->createImageWithInfo(imageInfo, vk::MemoryPropertyFlagBits::eDeviceLocal, accumulationImage, accumulationImageMemory);
+
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		accumulationImageView = device->device().createImageView(vk::ImageViewCreateInfo{ {}, accumulationImage, vk::ImageViewType::e2D, imageInfo.format, {}, subresourceRange });
+		if (!accumulationImageView)
+		{
+			throw std::runtime_error("Failed to create accumulation image view");
+		}
+
+		vk::SamplerCreateInfo samplerInfo{ {}, vk::Filter::eNearest, vk::Filter::eNearest, vk::SamplerMipmapMode::eNearest,
+			vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge, vk::SamplerAddressMode::eClampToEdge };
+		sampler = device->device().createSampler(samplerInfo);
+		if (!sampler)
+		{
+			throw std::runtime_error("Failed to create accumulation sampler");
+		}
+
+		// Between frames the image rests in eShaderReadOnlyOptimal for the present pass; dispatch moves it to
+		// eGeneral while compute writes it
+		vk::CommandBuffer commandBuffer = device->beginSingleTimeCommands();
+		ComputePipeline::prepareStorageImage(commandBuffer, accumulationImage, subresourceRange, vk::PipelineStageFlagBits::eTopOfPipe);
+		ComputePipeline::computeToFragmentImageBarrier(commandBuffer, accumulationImage, subresourceRange);
+		device->endSingleTimeCommands(commandBuffer);
+	}
+
+	void RayTracer::createComputePipeline()
+	{
+		computeShaders = new ShaderHelper(ShaderHelper::findComputeShader("../../../Shaders", "raytrace"), device->device());
+		ShaderReflection reflection = computeShaders->reflect();
+		computeBindings = reflection.getSetBindings(0);
+		bodyBindings = reflection.getSetBindings(1);
+		std::vector<vk::PushConstantRange> pushConstantRanges = reflection.getPushConstantRanges();
+		if (pushConstantRanges.size() != 1 || pushConstantRanges[0].offset + pushConstantRanges[0].size > sizeof(RayTracePushConstants))
+		{
+			throw std::runtime_error("Push constant block does not match RayTracePushConstants");
+		}
+
+		computeConfig = ComputePipelineConfigInfo{};
+		computeConfig.shaderHash = computeShaders->getShaderHash();
+		computeConfig.localSize = reflection.getLocalSize();
+		computeConfig.pushConstantRange = pushConstantRanges[0];
+		computeConfig.pipelineLayout = layoutCache->createPipelineLayout({ layoutCache->createDescriptorSetLayout(computeBindings), layoutCache->createDescriptorSetLayout(bodyBindings) }, pushConstantRanges);
+		computePipeline = pipelineRegistry->getComputePipeline(specializedComputeConfig(computeShaders->getShaderStages()[0]));
+	}
+
+	ComputePipelineConfigInfo RayTracer::specializedComputeConfig(const vk::PipelineShaderStageCreateInfo& shaderStage)
+	{
+		ComputePipelineConfigInfo configInfo = computeConfig;
+		std::array<vk::SpecializationMapEntry, 4> mapEntries = ShaderQuality::getMapEntries();
+		configInfo.specializationEntries.assign(mapEntries.begin(), mapEntries.end());
+		const char* data = reinterpret_cast<const char*>(&quality);
+		configInfo.specializationData.assign(data, data + sizeof(quality));
+
+		// Bool specialization constants are 32 bits wide
+		vk::Bool32 useDistanceField = distanceField->isBaked();
+		configInfo.specializationEntries.push_back(vk::SpecializationMapEntry{ USE_DISTANCE_FIELD_CONSTANT, static_cast<uint32_t>(configInfo.specializationData.size()), sizeof(vk::Bool32) });
+		data = reinterpret_cast<const char*>(&useDistanceField);
+		configInfo.specializationData.insert(configInfo.specializationData.end(), data, data + sizeof(useDistanceField));
+		configInfo.shaderStage = shaderStage;
+		return configInfo;
+	}
+
+	void RayTracer::setQuality(ShaderQuality quality_)
+	{
+		quality = quality_;
+		if (!computeShaders)
+		{
+			return;
+		}
+		// The registry keys on the specialization, so switching back to an earlier quality reuses its pipeline.
+		// It destroys the new module once the worker has compiled it.
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages = computeShaders->createShaderStages(device->device());
+		pendingComputePipeline = pipelineRegistry->requestComputePipeline(specializedComputeConfig(shaderStages[0]));
+	}
+
+	void RayTracer::createPresentPipeline()
+	{
+		ShaderHelper presentShaders("../../../Shaders/fullscreen.vert", "../../../Shaders/raytrace_present.frag", device->device());
+		ShaderReflection reflection = presentShaders.reflect();
+		presentBindings = reflection.getSetBindings(0);
+		presentLayout = layoutCache->createPipelineLayout({ layoutCache->createDescriptorSetLayout(presentBindings) }, {});
+
+		// A background: no vertex input, and it neither tests nor writes depth
+		PipelineConfigInfo configInfo = Pipeline::defaultPipelineConfigInfo(swapChain->width(), swapChain->height());
+		configInfo.bindingDescriptions.clear();
+		configInfo.attributeDescriptions.clear();
+		configInfo.rasterizationInfo.cullMode = vk::CullModeFlagBits::eNone;
+		configInfo.depthStencilInfo.depthTestEnable = VK_FALSE;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		configInfo.pushConstantRange = vk::PushConstantRange{};
+		configInfo.pipelineLayout = presentLayout;
+		configInfo.renderPass = swapChain->getRenderPass();
+		configInfo.shaderStages = presentShaders.getShaderStages();
+		configInfo.shaderHash = presentShaders.getShaderHash();
+		presentPipeline = pipelineRegistry->getPipeline(configInfo);
+		presentShaders.destroyShaderModules(device->device());
+	}
+
+	void RayTracer::createDescriptorSets()
+	{
+		computeDescriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(computeBindings));
+		DescriptorTemplate* computeTemplate = layoutCache->getUpdateTemplate(computeBindings);
+		std::vector<DescriptorInfo> computeData = computeTemplate->createData();
+		computeData[computeTemplate->slot(0)].image = vk::DescriptorImageInfo{ nullptr, accumulationImageView, vk::ImageLayout::eGeneral };
+		computeData[computeTemplate->slot(1)].image = distanceField->getDescriptorInfo();
+		// Noise textures from binding 2 on; the compiler strips the ones the shader does not sample
+		for (const vk::DescriptorSetLayoutBinding& binding : computeBindings)
+		{
+			if (binding.binding >= 2 && binding.binding < 2 + NoiseCache::NOISE_TYPE_COUNT)
+			{
+				computeData[computeTemplate->slot(binding.binding)].image = noiseCache->getDescriptorInfo(static_cast<NoiseCache::NoiseType>(binding.binding - 2));
+			}
+		}
+		// The denoiser's G-buffer follows the noise
+		for (uint32_t target = 0; target < Denoiser::GBUFFER_TARGET_COUNT; target++)
+		{
+			computeData[computeTemplate->slot(6 + target)].image = denoiser->getGBufferInfo(static_cast<Denoiser::GBufferTarget>(target));
+		}
+		computeTemplate->update(computeDescriptorSet, computeData);
+
+		presentDescriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(presentBindings));
+		DescriptorTemplate* presentTemplate = layoutCache->getUpdateTemplate(presentBindings);
+		std::vector<DescriptorInfo> presentData = presentTemplate->createData();
+		presentData[presentTemplate->slot(0)].image = vk::DescriptorImageInfo{ sampler, accumulationImageView, vk::ImageLayout::eShaderReadOnlyOptimal };
+		presentTemplate->update(presentDescriptorSet, presentData);
+
+		denoisedDescriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(presentBindings));
+		presentData[presentTemplate->slot(0)].image = denoiser->getOutputInfo(sampler);
+		presentTemplate->update(denoisedDescriptorSet, presentData);
+	}
+
+	void RayTracer::createBodyBuffers()
+	{
+		// Like InstanceBuffer: the CPU writes an image's copy once its fence has been waited on, so no frame in
+		// flight reads what is being written
+		vk::DeviceSize nodesSize = sizeof(BvhNode) * 2 * MAX_BODY_PRIMITIVES;
+		vk::DeviceSize primitivesSize = sizeof(BvhPrimitive) * MAX_BODY_PRIMITIVES;
+		DescriptorTemplate* bodyTemplate = layoutCache->getUpdateTemplate(bodyBindings);
+		bodyBuffers.resize(swapChain->imageCount());
+		for (BodyBuffers& buffers : bodyBuffers)
+		{
+			device->createBuffer(nodesSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, buffers.nodes, buffers.nodesMemory);
+			device->createBuffer(primitivesSize, vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, buffers.primitives, buffers.primitivesMemory);
+			buffers.mappedNodes = static_cast<BvhNode*>(device->device().mapMemory(buffers.nodesMemory, 0, nodesSize));
+			buffers.mappedPrimitives = static_cast<BvhPrimitive*>(device->device().mapMemory(buffers.primitivesMemory, 0, primitivesSize));
+			buffers.version = 0;
+
+			buffers.descriptorSet = descriptorAllocator->allocate(layoutCache->createDescriptorSetLayout(bodyBindings));
+			std::vector<DescriptorInfo> bodyData = bodyTemplate->createData();
+			bodyData[bodyTemplate->slot(0)].buffer = vk::DescriptorBufferInfo{ buffers.nodes, 0, VK_WHOLE_SIZE };
+			bodyData[bodyTemplate->slot(1)].buffer = vk::DescriptorBufferInfo{ buffers.primitives, 0, VK_WHOLE_SIZE };
+			bodyTemplate->update(buffers.descriptorSet, bodyData);
+		}
+	}
+
+	void RayTracer::syncBodies(uint32_t imageIndex)
+	{
+		BodyBuffers& buffers = bodyBuffers[imageIndex];
+		if (buffers.version == bodyVersion)
+		{
+			return;
+		}
+		const std::vector<BvhNode>& nodes = bodies.getNodes();
+		const std::vector<BvhPrimitive>& primitives = bodies.getPrimitives();
+		if (primitives.size() > MAX_BODY_PRIMITIVES)
+		{
+			throw std::runtime_error("Body primitive capacity exceeded");
+		}
+		std::copy(nodes.begin(), nodes.end(), buffers.mappedNodes);
+		std::copy(primitives.begin(), primitives.end(), buffers.mappedPrimitives);
+		buffers.version = bodyVersion;
+	}
+
+	void RayTracer::beginFrame(uint32_t imageIndex, const glm::mat4& viewProj, const glm::vec3& cameraPosition)
+	{
+		if (timestampsSupported && dispatchedSamples[imageIndex] > 0)
+		{
+			auto timestamps = device->device().getQueryPoolResults<uint64_t>(queryPool, 2 * imageIndex, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+			if (timestamps.result == vk::Result::eSuccess)
+			{
+				float milliseconds = static_cast<float>(timestamps.value[1] - timestamps.value[0]) * device->properties.limits.timestampPeriod * 1e-6f;
+				float cost = milliseconds / dispatchedSamples[imageIndex];
+				// Smoothed, so one slow frame does not swing the sample count
+				sampleCost = sampleCost > 0.0f ? glm::mix(sampleCost, cost, 0.25f) : cost;
+				samplesPerPixel = std::clamp(static_cast<uint32_t>(frameBudget / std::max(sampleCost, 1e-4f)), 1u, MAX_SAMPLES_PER_PIXEL);
+			}
+			dispatchedSamples[imageIndex] = 0;
+		}
+
+		// A quality switch keeps tracing with the current pipeline until the new variant has compiled
+		if (pendingComputePipeline && pendingComputePipeline->isFinished())
+		{
+			ComputePipeline* pipeline = pendingComputePipeline->get();
+			if (pipeline && pipeline != computePipeline)
+			{
+				computePipeline = pipeline;
+				// Samples of the old quality would stay in the mean
+				constants.accumulatedSamples = 0;
+			}
+			pendingComputePipeline = nullptr;
+		}
+
+		// Moved bodies invalidate the accumulated samples just like a moved camera
+		if (bodies.update())
+		{
+			bodyVersion++;
+			constants.accumulatedSamples = 0;
+		}
+		syncBodies(imageIndex);
+		constants.bodyNodeCount = static_cast<uint32_t>(bodies.getNodes().size());
+
+		if (viewProj != lastViewProj)
+		{
+			lastViewProj = viewProj;
+			constants.accumulatedSamples = 0;
+		}
+		constants.inverseViewProj = glm::inverse(viewProj);
+		constants.cameraPosition = glm::vec4(cameraPosition, 1.0f);
+		constants.samplesPerPixel = samplesPerPixel;
+	}
+
+	void RayTracer::dispatch(vk::CommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		if (constants.accumulatedSamples >= MAX_ACCUMULATED_SAMPLES)
+		{
+			presentDenoised = false;
+			return;
+		}
+
+		// Earlier frames' dispatches and present draws must be done with the image before it is written again
+		vk::MemoryBarrier barrier{ vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eComputeShader, {}, barrier, nullptr, nullptr);
+		vk::ImageSubresourceRange subresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		ComputePipeline::fragmentToComputeImageBarrier(commandBuffer, accumulationImage, subresourceRange);
+
+		if (timestampsSupported)
+		{
+			commandBuffer.resetQueryPool(queryPool, 2 * imageIndex, 2);
+			commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, queryPool, 2 * imageIndex);
+		}
+
+		constants.frameIndex++;
+		computePipeline->bind(commandBuffer);
+		computePipeline->bindDescriptorSets(commandBuffer, 0, { computeDescriptorSet, bodyBuffers[imageIndex].descriptorSet });
+		computePipeline->pushConstants(commandBuffer, &constants);
+		computePipeline->dispatch(commandBuffer, swapChain->width(), swapChain->height());
+
+		if (timestampsSupported)
+		{
+			commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, queryPool, 2 * imageIndex + 1);
+			dispatchedSamples[imageIndex] = samplesPerPixel;
+		}
+
+		// Only the trace is timed: the denoiser's cost does not depend on the sample count
+		presentDenoised = denoising && constants.accumulatedSamples < Denoiser::MAX_DENOISED_SAMPLES;
+		if (presentDenoised)
+		{
+			ComputePipeline::memoryBarrier(commandBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead);
+			denoiser->denoise(commandBuffer, lastViewProj, glm::vec3(constants.cameraPosition), constants.accumulatedSamples);
+		}
+
+		ComputePipeline::computeToFragmentImageBarrier(commandBuffer, accumulationImage, subresourceRange);
+		constants.accumulatedSamples += samplesPerPixel;
+	}
+
+	void RayTracer::draw(vk::CommandBuffer commandBuffer)
+	{
+		presentPipeline->bind(commandBuffer);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, presentLayout, 0, presentDenoised ? denoisedDescriptorSet : presentDescriptorSet, nullptr);
+		commandBuffer.draw(3, 1, 0, 0);
+	}
+}
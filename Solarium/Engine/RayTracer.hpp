@@ -0,0 +1,156 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
+#include "PipelineRegistry.hpp"
+#include "ComputePipeline.hpp"
+#include "ShaderHelper.hpp"
+#include "DistanceField.hpp"
+#include "NoiseCache.hpp"
+#include "Denoiser.hpp"
+#include "Bvh.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Solarium
+{
+	// Push constants of raytrace.comp; 96 bytes
+	struct RayTracePushConstants {
+		glm::mat4 inverseViewProj;
+		glm::vec4 cameraPosition;
+		// Seeds the random numbers, so every frame traces different paths
+		uint32_t frameIndex;
+		uint32_t samplesPerPixel;
+		// Samples already averaged into the accumulation image, 0 starts over
+		uint32_t accumulatedSamples;
+		// Nodes of the body Bvh, 0 when there are no bodies
+		uint32_t bodyNodeCount;
+	};
+	static_assert(sizeof(RayTracePushConstants) <= 128, "RayTracePushConstants must fit the guaranteed push constant size");
+
+	// Progressive path tracer for the ray-marched planet, run as a compute pass in 8x8 tiles. While the camera stays
+	// still every frame adds its samples to a running mean, so the image converges over time; any camera change
+	// starts over. The samples per pixel each frame follow the GPU time of the pass, measured with timestamps,
+	// to stay inside a frame time budget. The result is drawn as the background of the swapchain render pass.
+	// Marching steps through the baked DistanceField where it is available, and shading samples NoiseCache.
+	// Until the image has converged far enough the Denoiser filters it before it is drawn. Spheres, boxes and meshes
+	// are intersected through a Bvh, which every swapchain image gets a host-visible copy of.
+	class RayTracer
+	{
+	public:
+		static constexpr uint32_t MAX_SAMPLES_PER_PIXEL = 16;
+		// Past this the image no longer visibly changes, so dispatching stops until the camera moves
+		static constexpr uint32_t MAX_ACCUMULATED_SAMPLES = 4096;
+
+		// Specialization constant id of the usedistancefield switch in raytrace.comp, after the quality constants
+		static constexpr uint32_t USE_DISTANCE_FIELD_CONSTANT = 4;
+		// Size of the body buffers; a Bvh has fewer than twice as many nodes as primitives
+		static constexpr uint32_t MAX_BODY_PRIMITIVES = 4096;
+
+		RayTracer(SwapChain* swapChain_, Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_, PipelineRegistry* pipelineRegistry_, DistanceField* distanceField_, NoiseCache* noiseCache_, ShaderQuality quality_);
+		~RayTracer();
+		RayTracer(const RayTracer&) = delete;
+		RayTracer& operator=(const RayTracer&) = delete;
+
+		// Needs the pipeline registry's cache, the swapchain render pass, a created distance field and noise cache
+		void createChain();
+		void cleanup();
+		void update(SwapChain* swapChain_, Device* device_);
+
+		// Compiles the compute pipeline with new specialization constants on the job system. The current pipeline
+		// keeps tracing until it is ready; accumulation restarts once it is swapped in.
+		void setQuality(ShaderQuality quality_);
+		// GPU time the compute pass may take per frame, in milliseconds
+		void setFrameBudget(float milliseconds) { frameBudget = milliseconds; }
+		uint32_t getSamplesPerPixel() { return samplesPerPixel; }
+		uint32_t getAccumulatedSamples() { return constants.accumulatedSamples; }
+		// Draws the raw accumulation when off, to compare against
+		void setDenoising(bool enabled) { denoising = enabled; }
+		// Bodies may be added or moved between frames; beginFrame refits or rebuilds the hierarchy and restarts accumulation
+		Bvh* getBodies() { return &bodies; }
+
+		// Call once the image's fence has been waited on: reads back the GPU time of its last dispatch
+		void beginFrame(uint32_t imageIndex, const glm::mat4& viewProj, const glm::vec3& cameraPosition);
+		// Records the compute pass; outside of any render pass
+		void dispatch(vk::CommandBuffer commandBuffer, uint32_t imageIndex);
+		// Draws the accumulated or denoised image over the whole framebuffer; inside the swapchain render pass, before other draws
+		void draw(vk::CommandBuffer commandBuffer);
+
+	private:
+		void createAccumulationImage();
+		void createComputePipeline();
+		// computeConfig with shaderStage and the specialization for the current quality
+		ComputePipelineConfigInfo specializedComputeConfig(const vk::PipelineShaderStageCreateInfo& shaderStage);
+		void createPresentPipeline();
+		void createDescriptorSets();
+		void createBodyBuffers();
+		// Copies the bodies into this image's buffers if they changed since it was last used
+		void syncBodies(uint32_t imageIndex);
+
+		struct BodyBuffers {
+			vk::Buffer nodes;
+			vk::DeviceMemory nodesMemory;
+			BvhNode* mappedNodes;
+			vk::Buffer primitives;
+			vk::DeviceMemory primitivesMemory;
+			BvhPrimitive* mappedPrimitives;
+			vk::DescriptorSet descriptorSet;
+			uint32_t version;
+		};
+
+		Device* device;
+		SwapChain* swapChain;
+		DescriptorLayoutCache* layoutCache;
+		DescriptorAllocator* descriptorAllocator;
+		PipelineRegistry* pipelineRegistry;
+		DistanceField* distanceField;
+		NoiseCache* noiseCache;
+		Denoiser* denoiser;
+		ShaderQuality quality;
+
+		// Owned by pipelineRegistry
+		ComputePipeline* computePipeline = nullptr;
+		// Variant for a new quality, replaces computePipeline once compiled
+		PipelineRegistry::ComputePipelineSlot* pendingComputePipeline = nullptr;
+		Pipeline* presentPipeline = nullptr;
+		// Everything but the shader stage, reused when the quality changes
+		ComputePipelineConfigInfo computeConfig;
+		vk::PipelineLayout presentLayout;
+		// Kept for its SPIR-V, so quality changes do not compile the GLSL again
+		ShaderHelper* computeShaders = nullptr;
+		std::vector<vk::DescriptorSetLayoutBinding> computeBindings;
+		std::vector<vk::DescriptorSetLayoutBinding> presentBindings;
+		std::vector<vk::DescriptorSetLayoutBinding> bodyBindings;
+		vk::DescriptorSet computeDescriptorSet;
+		vk::DescriptorSet presentDescriptorSet;
+		vk::DescriptorSet denoisedDescriptorSet;
+
+		vk::Image accumulationImage;
+		vk::DeviceMemory accumulationImageMemory;
+		vk::ImageView accumulationImageView;
+		vk::Sampler sampler;
+
+		Bvh bodies;
+		// Bumped whenever the bodies change, so each image's copy knows when it is stale
+		uint32_t bodyVersion = 1;
+		std::vector<BodyBuffers> bodyBuffers;
+
+		// Two timestamps per swapchain image, around its dispatch
+		vk::QueryPool queryPool;
+		bool timestampsSupported = false;
+		std::vector<uint32_t> dispatchedSamples;
+		float sampleCost = 0.0f;
+		float frameBudget = 4.0f;
+
+		RayTracePushConstants constants{};
+		uint32_t samplesPerPixel = 1;
+		glm::mat4 lastViewProj{ 0.0f };
+		bool denoising = true;
+		// Whether the last dispatch left a denoised image to draw
+		bool presentDenoised = false;
+	};
+}
@@ -0,0 +1,296 @@
+#include "Scene.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace Solarium
+{
+	Entity Scene::createEntity(Entity parent)
+	{
+		Entity entity;
+		if (!freeEntities.empty())
+		{
+			entity = freeEntities.back();
+			freeEntities.pop_back();
+		}
+		else
+		{
+			entity = static_cast<Entity>(entityToIndex.size());
+			entityToIndex.push_back(INVALID_ENTITY);
+		}
+
+		// Appending keeps the parent-before-child order because the parent already has a slot
+		uint32_t index = size();
+		positions.push_back(glm::vec3(0.0f));
+		rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		scales.push_back(glm::vec3(1.0f));
+		parents.push_back(parent == INVALID_ENTITY ? INVALID_ENTITY : entityToIndex[parent]);
+		localMatrices.push_back(glm::mat4(1.0f));
+		worldMatrices.push_back(glm::mat4(1.0f));
+		textureIndices.push_back(DRAW_MATERIAL);
+		boundingRadii.push_back(0.0f);
+		dirty.push_back(1);
+		indexToEntity.push_back(entity);
+		entityToIndex[entity] = index;
+
+		anyDirty = true;
+		hierarchyChanged = true;
+		return entity;
+	}
+
+	void Scene::destroyEntity(Entity entity)
+	{
+		uint32_t target = entityToIndex[entity];
+		std::vector<uint8_t> removed(size(), 0);
+		std::vector<uint32_t> order;
+		order.reserve(size());
+
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			removed[i] = i == target || (parents[i] != INVALID_ENTITY && removed[parents[i]]);
+			if (removed[i])
+			{
+				freeEntities.push_back(indexToEntity[i]);
+				entityToIndex[indexToEntity[i]] = INVALID_ENTITY;
+			}
+			else
+			{
+				order.push_back(i);
+			}
+		}
+
+		permute(order);
+	}
+
+	void Scene::setParent(Entity entity, Entity parent)
+	{
+		uint32_t index = entityToIndex[entity];
+		uint32_t parentIndex = parent == INVALID_ENTITY ? INVALID_ENTITY : entityToIndex[parent];
+
+		for (uint32_t ancestor = parentIndex; ancestor != INVALID_ENTITY; ancestor = parents[ancestor])
+		{
+			if (ancestor == index)
+			{
+				throw std::runtime_error("Cannot parent an entity to one of its descendants");
+			}
+		}
+
+		parents[index] = parentIndex;
+		markDirty(index);
+		if (parentIndex != INVALID_ENTITY && parentIndex > index)
+		{
+			sortHierarchy();
+		}
+	}
+
+	Entity Scene::getParent(Entity entity)
+	{
+		uint32_t parentIndex = parents[entityToIndex[entity]];
+		return parentIndex == INVALID_ENTITY ? INVALID_ENTITY : indexToEntity[parentIndex];
+	}
+
+	void Scene::setPosition(Entity entity, glm::vec3 position)
+	{
+		positions[entityToIndex[entity]] = position;
+		markDirty(entityToIndex[entity]);
+	}
+
+	void Scene::setRotation(Entity entity, glm::quat rotation)
+	{
+		rotations[entityToIndex[entity]] = rotation;
+		markDirty(entityToIndex[entity]);
+	}
+
+	void Scene::setScale(Entity entity, glm::vec3 scale)
+	{
+		scales[entityToIndex[entity]] = scale;
+		markDirty(entityToIndex[entity]);
+	}
+
+	void Scene::setTextureIndex(Entity entity, uint32_t textureIndex)
+	{
+		textureIndices[entityToIndex[entity]] = textureIndex;
+		markDirty(entityToIndex[entity]);
+	}
+
+	void Scene::setBoundingRadius(Entity entity, float radius)
+	{
+		boundingRadii[entityToIndex[entity]] = radius;
+		markDirty(entityToIndex[entity]);
+	}
+
+	void Scene::markDirty(uint32_t index)
+	{
+		dirty[index] = 1;
+		anyDirty = true;
+	}
+
+	void Scene::updateTransforms(InstanceBuffer* instanceBuffer, const glm::mat4& viewProj, JobSystem* jobSystem, FrustumCuller* culler)
+	{
+		if (hierarchyChanged)
+		{
+			instanceBuffer->resize(size());
+			if (culler)
+			{
+				culler->resize(size());
+			}
+			hierarchyChanged = false;
+		}
+		bool viewChanged = viewProj != lastViewProj;
+		lastViewProj = viewProj;
+		if (!anyDirty && !viewChanged)
+		{
+			return;
+		}
+
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			if (parents[i] != INVALID_ENTITY && dirty[parents[i]])
+			{
+				dirty[i] = 1;
+			}
+		}
+
+		// Calls body(begin, end) for every run of dirty entities, so each run is handed to the batched kernels at once
+		auto forEachDirtyRun = [this](auto&& body)
+		{
+			for (uint32_t begin = 0; begin < size();)
+			{
+				if (!dirty[begin])
+				{
+					begin++;
+					continue;
+				}
+				uint32_t end = begin + 1;
+				while (end < size() && dirty[end])
+				{
+					end++;
+				}
+				body(begin, end);
+				begin = end;
+			}
+		};
+
+		forEachDirtyRun([&](uint32_t begin, uint32_t end)
+		{
+			TransformMath::composeLocal(&positions[begin], &rotations[begin], &scales[begin], &localMatrices[begin], end - begin, jobSystem);
+		});
+
+		// Parents come before their children, so this pass has to stay in order
+		InstanceData* instances = instanceBuffer->getInstances();
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			if (dirty[i])
+			{
+				uint32_t parent = parents[i];
+				if (parent == INVALID_ENTITY)
+				{
+					worldMatrices[i] = localMatrices[i];
+				}
+				else
+				{
+					TransformMath::multiply(worldMatrices[parent], localMatrices[i], worldMatrices[i]);
+				}
+				instances[i].model = worldMatrices[i];
+				instances[i].textureIndex = textureIndices[i];
+
+				// The world matrix scales the mesh by at most the length of its longest axis
+				if (culler)
+				{
+					const glm::mat4& world = worldMatrices[i];
+					float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+					culler->setSphere(i, glm::vec3(world[3]), boundingRadii[i] * scale);
+				}
+			}
+		}
+
+		forEachDirtyRun([&](uint32_t begin, uint32_t end)
+		{
+			TransformMath::computeNormalMatrices(&worldMatrices[begin], &instances[begin].normalMatrix, end - begin, jobSystem, sizeof(InstanceData));
+			if (!viewChanged)
+			{
+				TransformMath::computeMVP(viewProj, &worldMatrices[begin], &instances[begin].mvp, end - begin, jobSystem, sizeof(InstanceData));
+				instanceBuffer->markDirty(begin, end - begin);
+			}
+		});
+		if (viewChanged && size() > 0)
+		{
+			TransformMath::computeMVP(viewProj, worldMatrices.data(), &instances[0].mvp, size(), jobSystem, sizeof(InstanceData));
+			instanceBuffer->markDirty(0, size());
+		}
+
+		std::fill(dirty.begin(), dirty.end(), 0);
+		anyDirty = false;
+	}
+
+	void Scene::sortHierarchy()
+	{
+		std::vector<uint32_t> depth(size(), INVALID_ENTITY);
+		for (uint32_t i = 0; i < size(); i++)
+		{
+			uint32_t steps = 0;
+			uint32_t node = i;
+			while (node != INVALID_ENTITY && depth[node] == INVALID_ENTITY)
+			{
+				node = parents[node];
+				steps++;
+			}
+			uint32_t known = node == INVALID_ENTITY ? 0 : depth[node] + 1;
+
+			node = i;
+			while (node != INVALID_ENTITY && depth[node] == INVALID_ENTITY)
+			{
+				depth[node] = known + --steps;
+				node = parents[node];
+			}
+		}
+
+		std::vector<uint32_t> order(size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&depth](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+		permute(order);
+	}
+
+	void Scene::permute(const std::vector<uint32_t>& order)
+	{
+		std::vector<uint32_t> oldToNew(size(), INVALID_ENTITY);
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			oldToNew[order[i]] = i;
+		}
+
+		auto gather = [&order](auto& values)
+		{
+			std::remove_reference_t<decltype(values)> sorted;
+			sorted.reserve(order.size());
+			for (uint32_t oldIndex : order)
+			{
+				sorted.push_back(values[oldIndex]);
+			}
+			values.swap(sorted);
+		};
+
+		gather(positions);
+		gather(rotations);
+		gather(scales);
+		gather(parents);
+		gather(localMatrices);
+		gather(worldMatrices);
+		gather(textureIndices);
+		gather(boundingRadii);
+		gather(indexToEntity);
+
+		for (uint32_t i = 0; i < order.size(); i++)
+		{
+			if (parents[i] != INVALID_ENTITY)
+			{
+				parents[i] = oldToNew[parents[i]];
+			}
+			entityToIndex[indexToEntity[i]] = i;
+		}
+
+		// Instance slots moved, so every surviving entity is rewritten on the next update
+		dirty.assign(order.size(), 1);
+		anyDirty = true;
+		hierarchyChanged = true;
+	}
+}
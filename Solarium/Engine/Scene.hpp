@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Culling.hpp"
+#include "InstanceBuffer.hpp"
+#include "TransformMath.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+namespace Solarium
+{
+	typedef uint32_t Entity;
+	static constexpr Entity INVALID_ENTITY = UINT32_MAX;
+	// Texture index meaning "use the material pushed with the draw"
+	static constexpr uint32_t DRAW_MATERIAL = UINT32_MAX;
+
+	class Scene
+	{
+	public:
+		Scene() = default;
+		Scene(const Scene&) = delete;
+		Scene& operator=(const Scene&) = delete;
+
+		Entity createEntity(Entity parent = INVALID_ENTITY);
+		// Destroys the entity together with all of its descendants
+		void destroyEntity(Entity entity);
+		void setParent(Entity entity, Entity parent);
+		Entity getParent(Entity entity);
+
+		void setPosition(Entity entity, glm::vec3 position);
+		void setRotation(Entity entity, glm::quat rotation);
+		void setScale(Entity entity, glm::vec3 scale);
+		void setTextureIndex(Entity entity, uint32_t textureIndex);
+		// Radius around the entity's origin that holds its mesh, before scaling
+		void setBoundingRadius(Entity entity, float radius);
+		glm::vec3 getPosition(Entity entity) { return positions[entityToIndex[entity]]; }
+		glm::quat getRotation(Entity entity) { return rotations[entityToIndex[entity]]; }
+		glm::vec3 getScale(Entity entity) { return scales[entityToIndex[entity]]; }
+		uint32_t getTextureIndex(Entity entity) { return textureIndices[entityToIndex[entity]]; }
+		const glm::mat4& getWorldMatrix(Entity entity) { return worldMatrices[entityToIndex[entity]]; }
+
+		// Slot of the entity in the dense arrays, which is also its instance index
+		uint32_t getInstanceIndex(Entity entity) { return entityToIndex[entity]; }
+		uint32_t size() { return static_cast<uint32_t>(parents.size()); }
+
+		// Recomputes the world matrices of every dirty entity and its descendants with linear
+		// passes over the dense arrays and writes the changed ones straight into the instance buffer.
+		// Local, MVP and normal matrices are computed with the batched TransformMath kernels, in parallel when a
+		// job system is given. A viewProj different from the last call recomputes the MVP of every instance.
+		// A culler is kept at one bounding sphere per instance and only the changed spheres are rewritten.
+		void updateTransforms(InstanceBuffer* instanceBuffer, const glm::mat4& viewProj, JobSystem* jobSystem = nullptr, FrustumCuller* culler = nullptr);
+
+	private:
+		void markDirty(uint32_t index);
+		void sortHierarchy();
+		void permute(const std::vector<uint32_t>& order);
+
+		// Dense arrays, ordered so that every parent comes before its children
+		std::vector<glm::vec3> positions;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<uint32_t> parents;
+		std::vector<glm::mat4> localMatrices;
+		std::vector<glm::mat4> worldMatrices;
+		std::vector<uint32_t> textureIndices;
+		std::vector<float> boundingRadii;
+		std::vector<uint8_t> dirty;
+		std::vector<Entity> indexToEntity;
+
+		std::vector<uint32_t> entityToIndex;
+		std::vector<Entity> freeEntities;
+		bool anyDirty = false;
+		bool hierarchyChanged = false;
+		glm::mat4 lastViewProj{ 0.0f };
+	};
+}
@@ -1,4 +1,5 @@
 #include "ShaderHelper.hpp"
+#include <iterator>
 
 namespace Solarium
 {
@@ -13,12 +14,113 @@ namespace Solarium
 	    return subject;
 	}
 
+	// Resolves #include "file" relative to the including shader and #include <file> relative to the working directory
+	class FileIncluder : public shaderc::CompileOptions::IncluderInterface
+	{
+	public:
+		shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+		{
+			std::filesystem::path path = type == shaderc_include_type_relative ? std::filesystem::path(requestingSource).parent_path() / requestedSource : std::filesystem::path(requestedSource);
+			IncludeData* data = new IncludeData();
+			std::ifstream in(path, std::ios::in | std::ios::binary);
+			if (in)
+			{
+				data->name = path.generic_string();
+				data->content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			}
+			else
+			{
+				// shaderc reports an empty name as a failed include, with the content as the message
+				data->content = "Cannot open include file " + path.generic_string();
+			}
+			data->result = { data->name.c_str(), data->name.size(), data->content.c_str(), data->content.size(), data };
+			return &data->result;
+		}
+
+		void ReleaseInclude(shaderc_include_result* result) override
+		{
+			delete static_cast<IncludeData*>(result->user_data);
+		}
+
+	private:
+		struct IncludeData
+		{
+			std::string name;
+			std::string content;
+			shaderc_include_result result;
+		};
+	};
+
 	ShaderHelper::ShaderHelper(const std::string& shadersPath, const PipelineConfigInfo& configInfo, vk::Device device)
 	{
 		std::vector<ShaderLocs> shaders = getShaderPaths(shadersPath);
 		compileShaders(shaders, device);
 	}
 
+	ShaderHelper::ShaderHelper(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, vk::Device device)
+	{
+		compileShaders({ ShaderLocs(vertexShaderPath, fragmentShaderPath) }, device);
+	}
+
+	ShaderHelper::ShaderHelper(const std::string& computeShaderPath, vk::Device device)
+	{
+		compileComputeShader(computeShaderPath, device);
+	}
+
+	void ShaderHelper::compileComputeShader(std::string computeShaderLoc, vk::Device device)
+	{
+		computeShaderLoc = replaceString(computeShaderLoc, "\\", "/");
+		std::string computeShader = readFile(computeShaderLoc);
+
+		shaderc::Compiler compiler;
+		shaderc::CompileOptions options;
+
+		options.SetOptimizationLevel(shaderc_optimization_level_performance);
+		options.SetIncluder(std::make_unique<FileIncluder>());
+
+		shaderc::SpvCompilationResult computeModule = compiler.CompileGlslToSpv(computeShader, shaderc_shader_kind::shaderc_glsl_compute_shader, computeShaderLoc.c_str(), options);
+		if (computeModule.GetCompilationStatus() != shaderc_compilation_status_success) {
+			throw std::runtime_error("Failed to compile " + computeShaderLoc + ": " + computeModule.GetErrorMessage());
+		}
+
+		vk::ShaderModuleCreateInfo createInfo{};
+		createInfo.codeSize = computeModule.length() * sizeof(uint32_t);
+		createInfo.pCode = computeModule.begin();
+
+		shaderModules_.push_back(ShaderModules(device.createShaderModule(createInfo), vk::ShaderStageFlagBits::eCompute, std::vector<uint32_t>(computeModule.begin(), computeModule.end())));
+		if (shaderModules_.back().module == VK_NULL_HANDLE)
+		{
+			throw std::runtime_error("Failed to create shader module.");
+		}
+	}
+
+	std::vector<std::string> ShaderHelper::findComputeShaders(const std::string& shadersPath)
+	{
+		std::vector<std::string> out;
+		for (auto& p : std::filesystem::recursive_directory_iterator(shadersPath))
+		{
+			if (p.path().extension() == ".comp")
+			{
+				out.push_back(p.path().string());
+			}
+		}
+		// Directory order is unspecified; sorting keeps the result stable between runs
+		std::sort(out.begin(), out.end());
+		return out;
+	}
+
+	std::string ShaderHelper::findComputeShader(const std::string& shadersPath, const std::string& name)
+	{
+		for (const std::string& path : findComputeShaders(shadersPath))
+		{
+			if (std::filesystem::path(path).stem() == name)
+			{
+				return path;
+			}
+		}
+		throw std::runtime_error("No compute shader " + name + " under " + shadersPath);
+	}
+
 	void ShaderHelper::compileShaders(std::vector<ShaderLocs> shaderLocs, vk::Device device)
 	{
 		std::vector<ShaderModules> shaderModules;
@@ -34,33 +136,41 @@ namespace Solarium
 			shaderc::CompileOptions options;
 	
 			options.SetOptimizationLevel(shaderc_optimization_level_performance);
+			options.SetIncluder(std::make_unique<FileIncluder>());
 	
-			shaderc::SpvCompilationResult vertexModule = compiler.CompileGlslToSpv(vertexShader, shaderc_shader_kind::shaderc_glsl_vertex_shader, shaderLoc.vertexShaderLoc.c_str());
-			shaderc::SpvCompilationResult fragmentModule = compiler.CompileGlslToSpv(fragmentShader, shaderc_shader_kind::shaderc_glsl_fragment_shader, shaderLoc.fragmentShaderLoc.c_str());
+			shaderc::SpvCompilationResult vertexModule = compiler.CompileGlslToSpv(vertexShader, shaderc_shader_kind::shaderc_glsl_vertex_shader, shaderLoc.vertexShaderLoc.c_str(), options);
+			shaderc::SpvCompilationResult fragmentModule = compiler.CompileGlslToSpv(fragmentShader, shaderc_shader_kind::shaderc_glsl_fragment_shader, shaderLoc.fragmentShaderLoc.c_str(), options);
+			// Modules of pairs compiled before this one are not handed out, so they are destroyed here
+			auto fail = [&](const std::string& shaderLoc, const shaderc::SpvCompilationResult& module)
+			{
+				for (ShaderModules& compiled : shaderModules)
+				{
+					device.destroyShaderModule(compiled.module);
+				}
+				throw std::runtime_error("Failed to compile " + shaderLoc + ": " + module.GetErrorMessage());
+			};
 			if (vertexModule.GetCompilationStatus() != shaderc_compilation_status_success) {
-  				std::cerr << vertexModule.GetErrorMessage();
-				break;
-  			}
+				fail(shaderLoc.vertexShaderLoc, vertexModule);
+			}
 			if (fragmentModule.GetCompilationStatus() != shaderc_compilation_status_success) {
-  				std::cerr << fragmentModule.GetErrorMessage();
-				break;
-  			}
+				fail(shaderLoc.fragmentShaderLoc, fragmentModule);
+			}
 			
 			vk::ShaderModuleCreateInfo createInfo{};
-			createInfo.codeSize = fragmentModule.length();
+			createInfo.codeSize = fragmentModule.length() * sizeof(uint32_t);
 			createInfo.pCode = fragmentModule.begin();
 
-			shaderModules.push_back(ShaderModules(device.createShaderModule(createInfo), vk::ShaderStageFlagBits::eFragment));
-			if (shaderModules.front().module == VK_NULL_HANDLE)
+			shaderModules.push_back(ShaderModules(device.createShaderModule(createInfo), vk::ShaderStageFlagBits::eFragment, std::vector<uint32_t>(fragmentModule.begin(), fragmentModule.end())));
+			if (shaderModules.back().module == VK_NULL_HANDLE)
 			{
 				throw std::runtime_error("Failed to create shader module.");
 			}
 
-			createInfo.codeSize = vertexModule.length();
+			createInfo.codeSize = vertexModule.length() * sizeof(uint32_t);
 			createInfo.pCode = vertexModule.begin();
 
-			shaderModules.push_back(ShaderModules(device.createShaderModule(createInfo), vk::ShaderStageFlagBits::eVertex));
-			if (shaderModules.front().module == VK_NULL_HANDLE)
+			shaderModules.push_back(ShaderModules(device.createShaderModule(createInfo), vk::ShaderStageFlagBits::eVertex, std::vector<uint32_t>(vertexModule.begin(), vertexModule.end())));
+			if (shaderModules.back().module == VK_NULL_HANDLE)
 			{
 				throw std::runtime_error("Failed to create shader module.");
 			}
@@ -68,6 +178,67 @@ namespace Solarium
 		shaderModules_ = shaderModules;
 	}
 
+	std::vector<vk::PipelineShaderStageCreateInfo> ShaderHelper::getShaderStages()
+	{
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+		shaderStages.reserve(shaderModules_.size());
+		for (auto& module : shaderModules_)
+		{
+			shaderStages.push_back({ {}, module.shaderType, module.module, "main" });
+		}
+		return shaderStages;
+	}
+
+	std::vector<vk::PipelineShaderStageCreateInfo> ShaderHelper::createShaderStages(vk::Device device)
+	{
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages;
+		shaderStages.reserve(shaderModules_.size());
+		for (auto& module : shaderModules_)
+		{
+			vk::ShaderModule shaderModule = device.createShaderModule(vk::ShaderModuleCreateInfo{ {}, module.spirv });
+			if (!shaderModule)
+			{
+				throw std::runtime_error("Failed to create shader module.");
+			}
+			shaderStages.push_back({ {}, module.shaderType, shaderModule, "main" });
+		}
+		return shaderStages;
+	}
+
+	ShaderReflection ShaderHelper::reflect()
+	{
+		ShaderReflection reflection;
+		for (auto& module : shaderModules_)
+		{
+			reflection.addStage(module.spirv, module.shaderType);
+		}
+		return reflection;
+	}
+
+	uint64_t ShaderHelper::getShaderHash()
+	{
+		// FNV-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (auto& module : shaderModules_)
+		{
+			hash = (hash ^ static_cast<uint32_t>(module.shaderType)) * 1099511628211ull;
+			for (uint32_t word : module.spirv)
+			{
+				hash = (hash ^ word) * 1099511628211ull;
+			}
+		}
+		return hash;
+	}
+
+	void ShaderHelper::destroyShaderModules(vk::Device device)
+	{
+		for (auto& module : shaderModules_)
+		{
+			device.destroyShaderModule(module.module);
+		}
+		shaderModules_.clear();
+	}
+
 	std::string ShaderHelper::readFile(const std::string& fileName)
 	{
 		std::ifstream in(fileName, std::ios::in | std::ios::binary);
@@ -1,9 +1,13 @@
+#pragma once
+
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include <memory>
 #include "Pipeline.hpp"
+#include "ShaderReflection.hpp"
 #include <vulkan/vulkan.hpp>
 #include <shaderc/shaderc.hpp>
 
@@ -13,10 +17,13 @@ namespace Solarium
 	{
 		vk::ShaderModule module;
 		vk::ShaderStageFlagBits shaderType; // 0 = vertex; 1 = fragment
-		ShaderModules(vk::ShaderModule mod, vk::ShaderStageFlagBits type)
+		// Kept for reflection
+		std::vector<uint32_t> spirv;
+		ShaderModules(vk::ShaderModule mod, vk::ShaderStageFlagBits type, std::vector<uint32_t> code)
 		{
 			this->module = mod;
 			this->shaderType = type;
+			this->spirv = std::move(code);
 		}
 	};
 
@@ -36,13 +43,31 @@ namespace Solarium
 	{
 	public:
 		ShaderHelper(const std::string& shadersPath, const PipelineConfigInfo& configInfo, vk::Device device);
+		// Compiles exactly this vertex/fragment pair instead of every pair found under a directory
+		ShaderHelper(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, vk::Device device);
+		// Compiles a single .comp shader
+		ShaderHelper(const std::string& computeShaderPath, vk::Device device);
+		// Every .comp file under shadersPath; compute shaders stand alone, so they are not paired like .vert/.frag
+		static std::vector<std::string> findComputeShaders(const std::string& shadersPath);
+		// The .comp file under shadersPath named name, wherever it sits below it; throws if there is none
+		static std::string findComputeShader(const std::string& shadersPath, const std::string& name);
 		std::vector<ShaderModules> getShaderModules() { return shaderModules_; }
+		std::vector<vk::PipelineShaderStageCreateInfo> getShaderStages();
+		// New modules from the SPIR-V kept at compile time, owned by the caller. Lets pipeline variants be
+		// created after the original modules were handed over, without compiling the GLSL again.
+		std::vector<vk::PipelineShaderStageCreateInfo> createShaderStages(vk::Device device);
+		ShaderReflection reflect();
+		// Hash of every stage's SPIR-V, stable across runs
+		uint64_t getShaderHash();
+		// Modules are no longer needed once every pipeline using them has been created
+		void destroyShaderModules(vk::Device device);
 
 	private:
 
 		std::vector<ShaderLocs> getShaderPaths(const std::string& shadersPath);
 		std::string getSiblingShaderPath(const std::filesystem::path shaderPath);
 		void compileShaders(std::vector<ShaderLocs> shaderLocs, vk::Device device);
+		void compileComputeShader(std::string computeShaderLoc, vk::Device device);
 		std::string readFile(const std::string& fileName);
 		std::vector<ShaderModules> shaderModules_;
 		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages_;
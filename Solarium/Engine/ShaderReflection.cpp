@@ -0,0 +1,159 @@
+#include "ShaderReflection.hpp"
+#include <spirv_cross/spirv_cross.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace Solarium
+{
+	namespace
+	{
+		vk::Format vertexFormat(const spirv_cross::SPIRType& type)
+		{
+			static const vk::Format floatFormats[] = { vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+			static const vk::Format intFormats[] = { vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+			static const vk::Format uintFormats[] = { vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+			switch (type.basetype)
+			{
+			case spirv_cross::SPIRType::Float:
+				return floatFormats[type.vecsize - 1];
+			case spirv_cross::SPIRType::Int:
+				return intFormats[type.vecsize - 1];
+			case spirv_cross::SPIRType::UInt:
+				return uintFormats[type.vecsize - 1];
+			default:
+				throw std::runtime_error("Unsupported vertex input type");
+			}
+		}
+	}
+
+	void ShaderReflection::addStage(const std::vector<uint32_t>& spirv, vk::ShaderStageFlagBits stage)
+	{
+		spirv_cross::Compiler compiler(spirv);
+		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+		auto addResources = [&](const spirv_cross::SmallVector<spirv_cross::Resource>& list, vk::DescriptorType descriptorType, vk::DescriptorType texelBufferType)
+		{
+			for (const spirv_cross::Resource& resource : list)
+			{
+				const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
+				uint32_t count = 1;
+				for (size_t i = 0; i < type.array.size(); i++)
+				{
+					if (!type.array_size_literal[i])
+					{
+						throw std::runtime_error("Specialization constant sized descriptor arrays are not supported: " + resource.name);
+					}
+					// Runtime arrays report a size of 0, which propagates to the whole count
+					count *= type.array[i];
+				}
+
+				bool texelBuffer = (type.basetype == spirv_cross::SPIRType::Image || type.basetype == spirv_cross::SPIRType::SampledImage) && type.image.dim == spv::DimBuffer;
+				addBinding(compiler.get_decoration(resource.id, spv::DecorationDescriptorSet), compiler.get_decoration(resource.id, spv::DecorationBinding),
+					texelBuffer ? texelBufferType : descriptorType, count, stage);
+			}
+		};
+
+		addResources(resources.uniform_buffers, vk::DescriptorType::eUniformBuffer, vk::DescriptorType::eUniformBuffer);
+		addResources(resources.storage_buffers, vk::DescriptorType::eStorageBuffer, vk::DescriptorType::eStorageBuffer);
+		addResources(resources.sampled_images, vk::DescriptorType::eCombinedImageSampler, vk::DescriptorType::eUniformTexelBuffer);
+		addResources(resources.separate_images, vk::DescriptorType::eSampledImage, vk::DescriptorType::eUniformTexelBuffer);
+		addResources(resources.separate_samplers, vk::DescriptorType::eSampler, vk::DescriptorType::eSampler);
+		addResources(resources.storage_images, vk::DescriptorType::eStorageImage, vk::DescriptorType::eStorageTexelBuffer);
+		addResources(resources.subpass_inputs, vk::DescriptorType::eInputAttachment, vk::DescriptorType::eInputAttachment);
+		addResources(resources.acceleration_structures, vk::DescriptorType::eAccelerationStructureKHR, vk::DescriptorType::eAccelerationStructureKHR);
+
+		for (const spirv_cross::Resource& resource : resources.push_constant_buffers)
+		{
+			// Only the members the stage actually reads need to be inside its range
+			for (const spirv_cross::BufferRange& range : compiler.get_active_buffer_ranges(resource.id))
+			{
+				pushConstantBegin = std::min(pushConstantBegin, static_cast<uint32_t>(range.offset));
+				pushConstantEnd = std::max(pushConstantEnd, static_cast<uint32_t>(range.offset + range.range));
+				pushConstantStages |= stage;
+			}
+		}
+
+		if (stage == vk::ShaderStageFlagBits::eCompute)
+		{
+			for (uint32_t dimension = 0; dimension < 3; dimension++)
+			{
+				localSize[dimension] = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, dimension);
+			}
+		}
+
+		if (stage == vk::ShaderStageFlagBits::eVertex)
+		{
+			for (const spirv_cross::Resource& resource : resources.stage_inputs)
+			{
+				if (compiler.has_decoration(resource.id, spv::DecorationBuiltIn))
+				{
+					continue;
+				}
+				const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
+				uint32_t location = compiler.get_decoration(resource.id, spv::DecorationLocation);
+				// A matrix input takes one location per column
+				for (uint32_t column = 0; column < type.columns; column++)
+				{
+					vertexInputs.push_back(VertexInput{ location + column, vertexFormat(type), type.vecsize * 4 });
+				}
+			}
+			std::sort(vertexInputs.begin(), vertexInputs.end(), [](const VertexInput& a, const VertexInput& b) { return a.location < b.location; });
+		}
+	}
+
+	void ShaderReflection::addBinding(uint32_t set, uint32_t binding, vk::DescriptorType type, uint32_t count, vk::ShaderStageFlagBits stage)
+	{
+		std::vector<vk::DescriptorSetLayoutBinding>& bindings = sets[set];
+		auto it = std::find_if(bindings.begin(), bindings.end(), [binding](const vk::DescriptorSetLayoutBinding& existing) { return existing.binding == binding; });
+		if (it == bindings.end())
+		{
+			bindings.push_back(vk::DescriptorSetLayoutBinding{ binding, type, count, stage });
+			std::sort(bindings.begin(), bindings.end(), [](const vk::DescriptorSetLayoutBinding& a, const vk::DescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+			return;
+		}
+		if (it->descriptorType != type || it->descriptorCount != count)
+		{
+			throw std::runtime_error("Stages disagree on set " + std::to_string(set) + " binding " + std::to_string(binding));
+		}
+		it->stageFlags |= stage;
+	}
+
+	std::vector<vk::DescriptorSetLayoutBinding> ShaderReflection::getSetBindings(uint32_t set)
+	{
+		auto it = sets.find(set);
+		return it == sets.end() ? std::vector<vk::DescriptorSetLayoutBinding>{} : it->second;
+	}
+
+	std::vector<vk::PushConstantRange> ShaderReflection::getPushConstantRanges()
+	{
+		if (!pushConstantStages)
+		{
+			return {};
+		}
+		return { vk::PushConstantRange{ pushConstantStages, pushConstantBegin, pushConstantEnd - pushConstantBegin } };
+	}
+
+	std::vector<vk::VertexInputAttributeDescription> ShaderReflection::getVertexAttributes(uint32_t binding)
+	{
+		std::vector<vk::VertexInputAttributeDescription> attributes;
+		uint32_t offset = 0;
+		for (const VertexInput& input : vertexInputs)
+		{
+			attributes.push_back(vk::VertexInputAttributeDescription{ input.location, binding, input.format, offset });
+			offset += input.size;
+		}
+		return attributes;
+	}
+
+	uint32_t ShaderReflection::getVertexStride()
+	{
+		uint32_t stride = 0;
+		for (const VertexInput& input : vertexInputs)
+		{
+			stride += input.size;
+		}
+		return stride;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+
+#include <array>
+#include <map>
+#include <vector>
+
+namespace Solarium
+{
+
+	// Interface of a set of shader stages, read from their SPIR-V: descriptor sets, push constants and vertex inputs.
+	// Stages are merged, so a binding used by several stages carries all of their stage flags.
+	class ShaderReflection
+	{
+	public:
+		ShaderReflection() = default;
+
+		void addStage(const std::vector<uint32_t>& spirv, vk::ShaderStageFlagBits stage);
+
+		// Bindings of each set used by any stage, sorted by binding number. A runtime-sized array has a descriptorCount of 0,
+		// its real size is up to whoever owns the set.
+		const std::map<uint32_t, std::vector<vk::DescriptorSetLayoutBinding>>& getSets() { return sets; }
+		std::vector<vk::DescriptorSetLayoutBinding> getSetBindings(uint32_t set);
+		uint32_t getSetCount() { return sets.empty() ? 0 : sets.rbegin()->first + 1; }
+
+		// One range covering every stage's push constant block
+		std::vector<vk::PushConstantRange> getPushConstantRanges();
+
+		// Vertex inputs packed in location order into one interleaved binding
+		std::vector<vk::VertexInputAttributeDescription> getVertexAttributes(uint32_t binding = 0);
+		uint32_t getVertexStride();
+
+		// Workgroup size declared by the compute stage with local_size_x/y/z
+		std::array<uint32_t, 3> getLocalSize() { return localSize; }
+
+	private:
+		struct VertexInput
+		{
+			uint32_t location;
+			vk::Format format;
+			uint32_t size;
+		};
+
+		void addBinding(uint32_t set, uint32_t binding, vk::DescriptorType type, uint32_t count, vk::ShaderStageFlagBits stage);
+
+		std::map<uint32_t, std::vector<vk::DescriptorSetLayoutBinding>> sets;
+		vk::ShaderStageFlags pushConstantStages;
+		uint32_t pushConstantBegin = UINT32_MAX;
+		uint32_t pushConstantEnd = 0;
+		std::vector<VertexInput> vertexInputs;
+		std::array<uint32_t, 3> localSize{ 1, 1, 1 };
+	};
+}
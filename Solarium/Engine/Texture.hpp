@@ -3,7 +3,6 @@
 #include "vulkan/vulkan.hpp"
 #include "Device.hpp"
 #include "SwapChain.hpp"
-#include "BufferHelper.hpp"
 
 
 namespace Solarium
@@ -17,13 +16,7 @@ namespace Solarium
 		Texture(const Texture&) = delete;
 		Texture& operator=(const Texture&) = delete;
 
-		void createChain();
-
-		vk::Sampler getTextureSampler() { return textureSampler; }
 		vk::DeviceMemory getIndexBufferMemory() { return indexBufferMemory; }
-		vk::ImageView getTextureImageView() { return textureImageView; };
-		vk::Image getTextureImage() { return textureImage; }
-		vk::DeviceMemory getTextureImageMemory() { return textureImageMemory; }
 		std::vector<vk::ImageView> getSwapChainImageViews() { return swapChainImageViews; }
 
 		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
@@ -33,17 +26,8 @@ namespace Solarium
 	private:
 
 		vk::ImageView createImageView(vk::Image image, vk::Format format);
-		void createImage(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& imageMemory);
-		void createTextureImage();
-		void createTextureImageView();
-		void createTextureSampler();
-		void transitionImageLayout(vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout);
 
-		vk::Sampler textureSampler;
 		vk::DeviceMemory indexBufferMemory;
-		vk::ImageView textureImageView;
-		vk::Image textureImage;
-		vk::DeviceMemory textureImageMemory;
 		std::vector<vk::ImageView> swapChainImageViews;
 		Device* device;
 		SwapChain* swapChain;
@@ -0,0 +1,588 @@
+#include "TextureStreamer.hpp"
+#include "Logger.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+
+namespace Solarium
+{
+	TextureStreamer::TextureStreamer(SwapChain* swapChain_, Device* device_, JobSystem* jobSystem_)
+	{
+		swapChain = swapChain_;
+		device = device_;
+		jobSystem = jobSystem_;
+	}
+
+	TextureStreamer::~TextureStreamer()
+	{
+		// Decode jobs still hold a pointer to the streamer
+		jobSystem->wait();
+		cleanup();
+	}
+
+	void TextureStreamer::createChain()
+	{
+		if (memoryBudget == 0)
+		{
+			vk::PhysicalDeviceMemoryProperties memProperties = device->physicalDevice().getMemoryProperties();
+			for (uint32_t i = 0; i < memProperties.memoryHeapCount; i++)
+			{
+				if (memProperties.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+				{
+					memoryBudget = std::max(memoryBudget, memProperties.memoryHeaps[i].size / 2);
+				}
+			}
+		}
+
+		createPlaceholder();
+		createSampler();
+
+		// Decoded chains survive in system memory and are uploaded again by the next processUploads
+		for (TextureHandle handle = 0; handle < textures.size(); handle++)
+		{
+			if (!textures[handle].decoded)
+			{
+				queueDecode(handle);
+			}
+		}
+	}
+
+	void TextureStreamer::cleanup()
+	{
+		retireUploads(true);
+		destroyRetiredImages(true);
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			decodedImages.clear();
+			generation++;
+		}
+
+		for (StreamedTexture& texture : textures)
+		{
+			device->device().destroyImageView(texture.imageView);
+			device->device().destroyImage(texture.image);
+			device->device().freeMemory(texture.imageMemory);
+			texture.imageView = nullptr;
+			texture.image = nullptr;
+			texture.imageMemory = nullptr;
+			texture.imageBytes = 0;
+			texture.residentLevel = UINT32_MAX;
+		}
+		residentBytes = 0;
+
+		device->device().destroySampler(sampler);
+		device->device().destroyImageView(placeholderImageView);
+		device->device().destroyImage(placeholderImage);
+		device->device().freeMemory(placeholderImageMemory);
+		sampler = nullptr;
+		placeholderImageView = nullptr;
+		placeholderImage = nullptr;
+		placeholderImageMemory = nullptr;
+	}
+
+	TextureHandle TextureStreamer::load(const std::string& path, const std::string& fallbackPath)
+	{
+		TextureHandle handle = static_cast<TextureHandle>(textures.size());
+		textures.push_back(StreamedTexture{ path, fallbackPath });
+		queueDecode(handle);
+		return handle;
+	}
+
+	void TextureStreamer::requestResolution(TextureHandle handle, float screenPixels)
+	{
+		StreamedTexture& texture = textures[handle];
+		if (texture.lastRequestFrame != frameCount || !texture.hasFeedback)
+		{
+			texture.requestedPixels = 0.0f;
+		}
+		texture.requestedPixels = std::max(texture.requestedPixels, screenPixels);
+		texture.lastRequestFrame = frameCount;
+		texture.hasFeedback = true;
+	}
+
+	void TextureStreamer::queueDecode(TextureHandle handle)
+	{
+		std::string path = textures[handle].path;
+		std::string fallbackPath = textures[handle].fallbackPath;
+		uint32_t requestGeneration;
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			requestGeneration = generation;
+		}
+		vk::PhysicalDevice physicalDevice = device->physicalDevice();
+		bool compressionSupported = device->enabledFeatures.textureCompressionBC;
+
+		jobSystem->execute([this, handle, path, fallbackPath, requestGeneration, physicalDevice, compressionSupported]()
+		{
+			// Block compressed formats need the feature and a format the device can sample
+			auto supported = [&](vk::Format format)
+			{
+				if (format == vk::Format::eR8G8B8A8Srgb)
+				{
+					return true;
+				}
+				return compressionSupported && static_cast<bool>(physicalDevice.getFormatProperties(format).optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage);
+			};
+
+			bool blitMips = supportsLinearBlit(physicalDevice, vk::Format::eR8G8B8A8Srgb);
+			DecodedImage image{ handle, requestGeneration };
+			if (!decode(path, blitMips, image) || !supported(image.format))
+			{
+				image = DecodedImage{ handle, requestGeneration };
+				if (fallbackPath.empty() || !decode(fallbackPath, blitMips, image))
+				{
+					Logger::Error("Failed to load texture %s", path.c_str());
+					return;
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			if (image.generation == generation)
+			{
+				decodedImages.push_back(std::move(image));
+			}
+		});
+	}
+
+	bool TextureStreamer::supportsLinearBlit(vk::PhysicalDevice physicalDevice, vk::Format format)
+	{
+		vk::FormatFeatureFlags required = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		return (physicalDevice.getFormatProperties(format).optimalTilingFeatures & required) == required;
+	}
+
+	bool TextureStreamer::decode(const std::string& path, bool blitMips, DecodedImage& image)
+	{
+		if (std::filesystem::path(path).extension() == ".ktx2")
+		{
+			try
+			{
+				Ktx2Image ktx = Ktx2::load(path);
+				image.format = static_cast<vk::Format>(ktx.vkFormat);
+				image.width = ktx.width;
+				image.height = ktx.height;
+				for (const Ktx2Level& level : ktx.levels)
+				{
+					image.levelOffsets.push_back(level.offset);
+					image.levelSizes.push_back(level.size);
+				}
+				image.data = std::move(ktx.data);
+				return true;
+			}
+			catch (const std::exception&)
+			{
+				return false;
+			}
+		}
+
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+		{
+			return false;
+		}
+		image.format = vk::Format::eR8G8B8A8Srgb;
+		image.width = static_cast<uint32_t>(width);
+		image.height = static_cast<uint32_t>(height);
+		uint32_t mipLevels = ImageHelper::mipLevelCount(width, height);
+		if (blitMips)
+		{
+			// Blits convert sRGB to linear before filtering, so the GPU chain is as correct as the CPU one
+			size_t offset = 0;
+			for (uint32_t level = 0; level < mipLevels; level++)
+			{
+				image.levelOffsets.push_back(offset);
+				offset += size_t(ImageHelper::mipExtent(image.width, level)) * ImageHelper::mipExtent(image.height, level) * 4;
+			}
+			image.data.resize(offset);
+			memcpy(image.data.data(), pixels, size_t(image.width) * image.height * 4);
+			image.gpuMips = true;
+		}
+		else
+		{
+			image.data = ImageHelper::generateMipChain(pixels, width, height, mipLevels, true, image.levelOffsets);
+		}
+		stbi_image_free(pixels);
+
+		for (size_t level = 0; level < image.levelOffsets.size(); level++)
+		{
+			size_t end = level + 1 < image.levelOffsets.size() ? image.levelOffsets[level + 1] : image.data.size();
+			image.levelSizes.push_back(end - image.levelOffsets[level]);
+		}
+		return true;
+	}
+
+	bool TextureStreamer::processUploads()
+	{
+		bool switched = retireUploads(false);
+		destroyRetiredImages(false);
+
+		{
+			std::lock_guard<std::mutex> lock(decodedMutex);
+			for (DecodedImage& image : decodedImages)
+			{
+				textures[image.handle].source = std::move(image);
+				textures[image.handle].decoded = true;
+			}
+			decodedImages.clear();
+		}
+
+		chooseResidentLevels();
+
+		std::vector<TextureHandle> uploads;
+		vk::DeviceSize uploadBytes = 0;
+		for (TextureHandle handle = 0; handle < textures.size(); handle++)
+		{
+			StreamedTexture& texture = textures[handle];
+			if (!texture.decoded || texture.uploading || texture.targetLevel == texture.residentLevel)
+			{
+				continue;
+			}
+			vk::DeviceSize size = tailSize(texture, texture.targetLevel);
+			if (!uploads.empty() && uploadBytes + size > MAX_UPLOAD_BYTES_PER_FRAME)
+			{
+				break;
+			}
+			uploads.push_back(handle);
+			uploadBytes += size;
+		}
+
+		if (!uploads.empty())
+		{
+			submitUploads(uploads);
+		}
+		frameCount++;
+		return switched;
+	}
+
+	void TextureStreamer::chooseResidentLevels()
+	{
+		vk::DeviceSize totalBytes = 0;
+		for (StreamedTexture& texture : textures)
+		{
+			if (!texture.decoded)
+			{
+				continue;
+			}
+
+			uint32_t coarsest = static_cast<uint32_t>(texture.source.levelSizes.size()) - 1;
+			uint32_t wanted = texture.targetLevel;
+			if (texture.source.gpuMips)
+			{
+				// The blits start from level 0, so the first upload is always the whole chain
+				wanted = 0;
+			}
+			else if (!texture.hasFeedback)
+			{
+				wanted = 0;
+			}
+			else if (texture.lastRequestFrame == frameCount)
+			{
+				// One texel per pixel: every halving of the screen size drops one level
+				float texels = static_cast<float>(std::max(texture.source.width, texture.source.height));
+				float level = texture.requestedPixels > 0.0f ? std::floor(std::log2(texels / texture.requestedPixels)) : static_cast<float>(coarsest);
+				wanted = static_cast<uint32_t>(std::clamp(level, 0.0f, static_cast<float>(coarsest)));
+
+				// Dropping detail waits for a two level difference so small camera moves do not reallocate
+				if (texture.residentLevel != UINT32_MAX && wanted == texture.residentLevel + 1)
+				{
+					wanted = texture.residentLevel;
+				}
+			}
+			else if (frameCount - texture.lastRequestFrame > FEEDBACK_TIMEOUT_FRAMES)
+			{
+				wanted = coarsest;
+			}
+
+			texture.targetLevel = std::min(wanted, coarsest);
+			totalBytes += tailSize(texture, texture.targetLevel);
+		}
+
+		// Over budget the finest level across all textures is evicted first, which always frees the most memory
+		while (totalBytes > memoryBudget)
+		{
+			StreamedTexture* largest = nullptr;
+			for (StreamedTexture& texture : textures)
+			{
+				if (texture.decoded && !texture.source.gpuMips && texture.targetLevel + 1 < texture.source.levelSizes.size() &&
+					(!largest || texture.source.levelSizes[texture.targetLevel] > largest->source.levelSizes[largest->targetLevel]))
+				{
+					largest = &texture;
+				}
+			}
+			if (!largest)
+			{
+				break;
+			}
+			totalBytes -= largest->source.levelSizes[largest->targetLevel];
+			largest->targetLevel++;
+		}
+	}
+
+	vk::DeviceSize TextureStreamer::tailSize(const StreamedTexture& texture, uint32_t firstLevel)
+	{
+		vk::DeviceSize size = 0;
+		for (size_t level = firstLevel; level < texture.source.levelSizes.size(); level++)
+		{
+			size += texture.source.levelSizes[level];
+		}
+		return size;
+	}
+
+	void TextureStreamer::submitUploads(const std::vector<TextureHandle>& handles)
+	{
+		// Every level goes into one staging buffer, aligned for the largest texel block
+		vk::DeviceSize stagingSize = 0;
+		for (TextureHandle handle : handles)
+		{
+			const StreamedTexture& texture = textures[handle];
+			for (size_t level = texture.targetLevel; level < texture.source.levelSizes.size(); level++)
+			{
+				stagingSize += (texture.source.levelSizes[level] + 15) & ~vk::DeviceSize(15);
+			}
+		}
+
+		// Blitted levels are read back into the space their upload would have used
+		PendingUpload upload;
+		BufferHelper::createBuffer(stagingSize, vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, upload.stagingBuffer, upload.stagingBufferMemory, device);
+		uint8_t* staging = static_cast<uint8_t*>(device->device().mapMemory(upload.stagingBufferMemory, 0, stagingSize));
+
+		vk::CommandBufferAllocateInfo allocInfo{ device->getCommandPool(), vk::CommandBufferLevel::ePrimary, 1 };
+		upload.commandBuffer = device->device().allocateCommandBuffers(allocInfo)[0];
+		upload.commandBuffer.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+		vk::DeviceSize stagingOffset = 0;
+		for (TextureHandle handle : handles)
+		{
+			StreamedTexture& texture = textures[handle];
+			const DecodedImage& source = texture.source;
+			uint32_t firstLevel = texture.targetLevel;
+			uint32_t mipLevels = static_cast<uint32_t>(source.levelSizes.size()) - firstLevel;
+
+			PendingImage pending{ handle, firstLevel };
+			vk::ImageUsageFlags usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+			if (source.gpuMips)
+			{
+				usage |= vk::ImageUsageFlagBits::eTransferSrc;
+			}
+			vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, source.format, vk::Extent3D{ ImageHelper::mipExtent(source.width, firstLevel), ImageHelper::mipExtent(source.height, firstLevel), 1 }, mipLevels, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usage, vk::SharingMode::eExclusive };
+			pending.image = device->device().createImage(imageInfo);
+			vk::MemoryRequirements memRequirements = device->device().getImageMemoryRequirements(pending.image);
+			pending.imageMemory = device->device().allocateMemory(vk::MemoryAllocateInfo{ memRequirements.size, BufferHelper::findMemoryType(memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal, device) });
+			pending.imageBytes = memRequirements.size;
+			device->device().bindImageMemory(pending.image, pending.imageMemory, 0);
+
+			vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 };
+			pending.imageView = device->device().createImageView(vk::ImageViewCreateInfo{ {}, pending.image, vk::ImageViewType::e2D, source.format, {}, range });
+
+			vk::ImageMemoryBarrier toTransfer{ vk::AccessFlagBits::eNoneKHR, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, pending.image, range };
+			upload.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, toTransfer);
+
+			// A gpuMips source uploads level 0 alone; the staging space of the other levels takes their read back
+			std::vector<vk::BufferImageCopy> regions;
+			for (uint32_t level = firstLevel; level < source.levelSizes.size(); level++)
+			{
+				if (level == firstLevel || !source.gpuMips)
+				{
+					memcpy(staging + stagingOffset, source.data.data() + source.levelOffsets[level], source.levelSizes[level]);
+					regions.push_back(vk::BufferImageCopy{ stagingOffset, 0, 0, vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - firstLevel, 0, 1 }, { 0, 0, 0 }, { ImageHelper::mipExtent(source.width, level), ImageHelper::mipExtent(source.height, level), 1 } });
+				}
+				else if (level == firstLevel + 1)
+				{
+					pending.readbackOffset = stagingOffset;
+				}
+				stagingOffset += (source.levelSizes[level] + 15) & ~vk::DeviceSize(15);
+			}
+			upload.commandBuffer.copyBufferToImage(upload.stagingBuffer, pending.image, vk::ImageLayout::eTransferDstOptimal, regions);
+
+			if (source.gpuMips)
+			{
+				recordMipBlits(upload.commandBuffer, pending, source, upload.stagingBuffer);
+			}
+			else
+			{
+				vk::ImageMemoryBarrier toShader{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, pending.image, range };
+				upload.commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, toShader);
+			}
+
+			texture.uploading = true;
+			upload.images.push_back(pending);
+		}
+
+		device->device().unmapMemory(upload.stagingBufferMemory);
+		upload.commandBuffer.end();
+		upload.fence = device->device().createFence(vk::FenceCreateInfo{});
+		device->graphicsQueue().submit(vk::SubmitInfo{ {}, {}, upload.commandBuffer }, upload.fence);
+		pendingUploads.push_back(upload);
+	}
+
+	void TextureStreamer::recordMipBlits(vk::CommandBuffer commandBuffer, const PendingImage& pending, const DecodedImage& source, vk::Buffer stagingBuffer)
+	{
+		uint32_t mipLevels = static_cast<uint32_t>(source.levelSizes.size());
+		vk::ImageMemoryBarrier barrier{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, pending.image, vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 } };
+
+		// Each level becomes the source of the next once it has been written, and stays a transfer source for the read back
+		for (uint32_t level = 1; level < mipLevels; level++)
+		{
+			barrier.subresourceRange.baseMipLevel = level - 1;
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+
+			vk::ImageBlit blit{ vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level - 1, 0, 1 },
+				std::array<vk::Offset3D, 2>{ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(ImageHelper::mipExtent(source.width, level - 1)), static_cast<int32_t>(ImageHelper::mipExtent(source.height, level - 1)), 1 } },
+				vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 },
+				std::array<vk::Offset3D, 2>{ vk::Offset3D{ 0, 0, 0 }, vk::Offset3D{ static_cast<int32_t>(ImageHelper::mipExtent(source.width, level)), static_cast<int32_t>(ImageHelper::mipExtent(source.height, level)), 1 } } };
+			commandBuffer.blitImage(pending.image, vk::ImageLayout::eTransferSrcOptimal, pending.image, vk::ImageLayout::eTransferDstOptimal, blit, vk::Filter::eLinear);
+		}
+		barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+
+		std::vector<vk::BufferImageCopy> regions;
+		vk::DeviceSize offset = pending.readbackOffset;
+		for (uint32_t level = 1; level < mipLevels; level++)
+		{
+			regions.push_back(vk::BufferImageCopy{ offset, 0, 0, vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, level, 0, 1 }, { 0, 0, 0 }, { ImageHelper::mipExtent(source.width, level), ImageHelper::mipExtent(source.height, level), 1 } });
+			offset += (source.levelSizes[level] + 15) & ~vk::DeviceSize(15);
+		}
+		if (!regions.empty())
+		{
+			commandBuffer.copyImageToBuffer(pending.image, vk::ImageLayout::eTransferSrcOptimal, stagingBuffer, regions);
+		}
+
+		vk::ImageMemoryBarrier toShader{ vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, pending.image, vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, 0, mipLevels, 0, 1 } };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, toShader);
+		vk::MemoryBarrier toHost{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, toHost, {}, {});
+	}
+
+	bool TextureStreamer::retireUploads(bool wait)
+	{
+		bool switched = false;
+		for (size_t i = 0; i < pendingUploads.size();)
+		{
+			PendingUpload& upload = pendingUploads[i];
+			if (wait)
+			{
+				device->device().waitForFences(upload.fence, VK_TRUE, UINT64_MAX);
+			}
+			else if (device->device().getFenceStatus(upload.fence) != vk::Result::eSuccess)
+			{
+				i++;
+				continue;
+			}
+
+			// The blitted levels become the system memory copy later tails stream from
+			const uint8_t* staging = nullptr;
+			for (const PendingImage& pending : upload.images)
+			{
+				DecodedImage& source = textures[pending.handle].source;
+				if (!source.gpuMips)
+				{
+					continue;
+				}
+				if (!staging)
+				{
+					staging = static_cast<const uint8_t*>(device->device().mapMemory(upload.stagingBufferMemory, 0, VK_WHOLE_SIZE));
+				}
+				vk::DeviceSize offset = pending.readbackOffset;
+				for (size_t level = 1; level < source.levelSizes.size(); level++)
+				{
+					memcpy(source.data.data() + source.levelOffsets[level], staging + offset, source.levelSizes[level]);
+					offset += (source.levelSizes[level] + 15) & ~vk::DeviceSize(15);
+				}
+				source.gpuMips = false;
+			}
+			if (staging)
+			{
+				device->device().unmapMemory(upload.stagingBufferMemory);
+			}
+
+			for (const PendingImage& pending : upload.images)
+			{
+				StreamedTexture& texture = textures[pending.handle];
+				if (texture.image)
+				{
+					retiredImages.push_back(RetiredImage{ texture.image, texture.imageMemory, texture.imageView, frameCount });
+					residentBytes -= texture.imageBytes;
+				}
+				texture.image = pending.image;
+				texture.imageMemory = pending.imageMemory;
+				texture.imageView = pending.imageView;
+				texture.imageBytes = pending.imageBytes;
+				texture.residentLevel = pending.firstLevel;
+				texture.uploading = false;
+				residentBytes += pending.imageBytes;
+			}
+			device->device().destroyFence(upload.fence);
+			device->device().freeCommandBuffers(device->getCommandPool(), upload.commandBuffer);
+			device->device().destroyBuffer(upload.stagingBuffer);
+			device->device().freeMemory(upload.stagingBufferMemory);
+			pendingUploads.erase(pendingUploads.begin() + i);
+			switched = true;
+		}
+		return switched;
+	}
+
+	void TextureStreamer::destroyRetiredImages(bool all)
+	{
+		// Every swapchain image has to rebind its descriptor set before the old view is unused
+		uint64_t latency = swapChain->imageCount() + SwapChain::MAX_FRAMES_IN_FLIGHT;
+		for (size_t i = 0; i < retiredImages.size();)
+		{
+			RetiredImage& retired = retiredImages[i];
+			if (!all && frameCount - retired.frame < latency)
+			{
+				i++;
+				continue;
+			}
+			device->device().destroyImageView(retired.imageView);
+			device->device().destroyImage(retired.image);
+			device->device().freeMemory(retired.imageMemory);
+			retiredImages.erase(retiredImages.begin() + i);
+		}
+	}
+
+	void TextureStreamer::createPlaceholder()
+	{
+		// A single mid grey texel keeps materials neutral until their texture arrives
+		const uint8_t texel[4] = { 128, 128, 128, 255 };
+		vk::Buffer stagingBuffer;
+		vk::DeviceMemory stagingBufferMemory;
+		BufferHelper::createBuffer(sizeof(texel), vk::BufferUsageFlagBits::eTransferSrc, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, stagingBuffer, stagingBufferMemory, device);
+		void* data = device->device().mapMemory(stagingBufferMemory, 0, sizeof(texel));
+		memcpy(data, texel, sizeof(texel));
+		device->device().unmapMemory(stagingBufferMemory);
+
+		vk::ImageCreateInfo imageInfo{ {}, vk::ImageType::e2D, vk::Format::eR8G8B8A8Unorm, vk::Extent3D{ 1, 1, 1 }, 1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled, vk::SharingMode::eExclusive };
+		placeholderImage = device->device().createImage(imageInfo);
+		vk::MemoryRequirements memRequirements = device->device().getImageMemoryRequirements(placeholderImage);
+		placeholderImageMemory = device->device().allocateMemory(vk::MemoryAllocateInfo{ memRequirements.size, BufferHelper::findMemoryType(memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal, device) });
+		device->device().bindImageMemory(placeholderImage, placeholderImageMemory, 0);
+
+		vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		vk::CommandBuffer commandBuffer = BufferHelper::beginSingleTimeCommands(device);
+		vk::ImageMemoryBarrier toTransfer{ vk::AccessFlagBits::eNoneKHR, vk::AccessFlagBits::eTransferWrite, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, placeholderImage, range };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, toTransfer);
+		commandBuffer.copyBufferToImage(stagingBuffer, placeholderImage, vk::ImageLayout::eTransferDstOptimal, vk::BufferImageCopy{ 0, 0, 0, vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 }, { 0, 0, 0 }, { 1, 1, 1 } });
+		vk::ImageMemoryBarrier toShader{ vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, placeholderImage, range };
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, toShader);
+		BufferHelper::endSingleTimeCommands(commandBuffer, device);
+
+		device->device().destroyBuffer(stagingBuffer);
+		device->device().freeMemory(stagingBufferMemory);
+
+		placeholderImageView = device->device().createImageView(vk::ImageViewCreateInfo{ {}, placeholderImage, vk::ImageViewType::e2D, vk::Format::eR8G8B8A8Unorm, {}, range });
+	}
+
+	void TextureStreamer::createSampler()
+	{
+		vk::SamplerCreateInfo samplerInfo{ {}, vk::Filter::eLinear, vk::Filter::eLinear, vk::SamplerMipmapMode::eLinear, vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, vk::SamplerAddressMode::eRepeat, 0.f, VK_TRUE, device->properties.limits.maxSamplerAnisotropy, VK_FALSE, vk::CompareOp::eAlways, 0.f, VK_LOD_CLAMP_NONE, vk::BorderColor::eIntOpaqueBlack, VK_FALSE };
+		sampler = device->device().createSampler(samplerInfo);
+		if (!sampler)
+		{
+			throw std::runtime_error("Failed to create texture sampler");
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+#include "BufferHelper.hpp"
+#include "ImageHelper.hpp"
+#include "JobSystem.hpp"
+#include "Ktx2.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Solarium
+{
+	typedef uint32_t TextureHandle;
+	static constexpr TextureHandle INVALID_TEXTURE = UINT32_MAX;
+
+	// Decodes textures on the job system and uploads them in batches without stalling the frame.
+	// Handles are valid immediately and resolve to a placeholder until their upload has completed.
+	//
+	// Decoded mip chains stay in system memory and only the mip tail the view needs is kept on the GPU.
+	// Each texture's image holds levels [residentLevel, mipLevels) and is reallocated when the tail changes,
+	// so the sampler never sees levels that are not resident.
+	//
+	// Formats the device can blit with linear filtering get their mips from a vkCmdBlitImage cascade on the
+	// first upload, which are then read back so later tails stream like any other. Other formats, and block
+	// compressed files that bring their own levels, are mipmapped on the CPU.
+	class TextureStreamer
+	{
+	public:
+		TextureStreamer(SwapChain* swapChain_, Device* device_, JobSystem* jobSystem_);
+		~TextureStreamer();
+		TextureStreamer(const TextureStreamer&) = delete;
+		TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+		// Creates the placeholder and sampler and uploads every known texture again
+		void createChain();
+		void cleanup();
+		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
+
+		// KTX2 files are uploaded as stored, anything else is decoded with stb_image and mipmapped on the worker.
+		// fallbackPath is decoded instead when path cannot be read or its format cannot be sampled on this device,
+		// which lets a block compressed texture fall back to its source image.
+		TextureHandle load(const std::string& path, const std::string& fallbackPath = "");
+
+		// Screen space feedback: the number of pixels the texture spans along its larger axis this frame.
+		// The finest level with at least that many texels is made resident. Textures that never receive
+		// feedback stay fully resident as long as the budget allows.
+		void requestResolution(TextureHandle handle, float screenPixels);
+
+		// Upper bound for the memory of all streamed images. Defaults to half of the largest device local heap.
+		void setMemoryBudget(vk::DeviceSize budget) { memoryBudget = budget; }
+		vk::DeviceSize getMemoryBudget() { return memoryBudget; }
+		vk::DeviceSize getResidentBytes() { return residentBytes; }
+
+		// Called once per frame on the render thread. Moves finished decodes into residency, picks the
+		// resident mip tail of every texture and submits the uploads that change. Returns true when any
+		// texture switched to a new image.
+		bool processUploads();
+
+		bool isResident(TextureHandle handle) { return static_cast<bool>(textures[handle].imageView); }
+		uint32_t getResidentLevel(TextureHandle handle) { return textures[handle].residentLevel; }
+		vk::ImageView getImageView(TextureHandle handle) { return handle != INVALID_TEXTURE && textures[handle].imageView ? textures[handle].imageView : placeholderImageView; }
+		vk::Sampler getSampler() { return sampler; }
+
+	private:
+		// Upper bound of staging memory handed to the GPU per frame, larger backlogs spill into later frames
+		static constexpr vk::DeviceSize MAX_UPLOAD_BYTES_PER_FRAME = 64 * 1024 * 1024;
+		// Frames without feedback after which a texture falls back to its coarsest level
+		static constexpr uint32_t FEEDBACK_TIMEOUT_FRAMES = 120;
+
+		struct DecodedImage
+		{
+			TextureHandle handle;
+			uint32_t generation;
+			vk::Format format;
+			uint32_t width;
+			uint32_t height;
+			std::vector<size_t> levelOffsets;
+			std::vector<size_t> levelSizes;
+			std::vector<uint8_t> data;
+			// Only level 0 of data is filled until the first upload has blitted and read back the others
+			bool gpuMips = false;
+		};
+
+		struct StreamedTexture
+		{
+			std::string path;
+			std::string fallbackPath;
+			// System memory copy of the whole chain, empty until the decode finished
+			DecodedImage source;
+			bool decoded = false;
+
+			vk::Image image;
+			vk::DeviceMemory imageMemory;
+			vk::ImageView imageView;
+			vk::DeviceSize imageBytes = 0;
+			uint32_t residentLevel = UINT32_MAX;
+			uint32_t targetLevel = 0;
+			bool uploading = false;
+
+			float requestedPixels = 0.0f;
+			uint64_t lastRequestFrame = 0;
+			bool hasFeedback = false;
+		};
+
+		struct PendingImage
+		{
+			TextureHandle handle;
+			uint32_t firstLevel;
+			vk::Image image;
+			vk::DeviceMemory imageMemory;
+			vk::ImageView imageView;
+			vk::DeviceSize imageBytes;
+			// Where the blitted levels past 0 land in the staging buffer, for gpuMips sources
+			vk::DeviceSize readbackOffset;
+		};
+
+		struct PendingUpload
+		{
+			vk::CommandBuffer commandBuffer;
+			vk::Fence fence;
+			vk::Buffer stagingBuffer;
+			vk::DeviceMemory stagingBufferMemory;
+			std::vector<PendingImage> images;
+		};
+
+		// Images replaced while descriptor sets of frames in flight may still reference them
+		struct RetiredImage
+		{
+			vk::Image image;
+			vk::DeviceMemory imageMemory;
+			vk::ImageView imageView;
+			uint64_t frame;
+		};
+
+		void queueDecode(TextureHandle handle);
+		static bool decode(const std::string& path, bool blitMips, DecodedImage& image);
+		static bool supportsLinearBlit(vk::PhysicalDevice physicalDevice, vk::Format format);
+		void recordMipBlits(vk::CommandBuffer commandBuffer, const PendingImage& pending, const DecodedImage& source, vk::Buffer stagingBuffer);
+		void createPlaceholder();
+		void createSampler();
+		void chooseResidentLevels();
+		vk::DeviceSize tailSize(const StreamedTexture& texture, uint32_t firstLevel);
+		void submitUploads(const std::vector<TextureHandle>& handles);
+		bool retireUploads(bool wait);
+		void destroyRetiredImages(bool all);
+
+		SwapChain* swapChain;
+		Device* device;
+		JobSystem* jobSystem;
+		std::vector<StreamedTexture> textures;
+		std::vector<PendingUpload> pendingUploads;
+		std::vector<RetiredImage> retiredImages;
+		uint64_t frameCount = 0;
+		vk::DeviceSize memoryBudget = 0;
+		vk::DeviceSize residentBytes = 0;
+
+		// Written by the decode jobs; results from a previous generation belong to a destroyed device
+		std::mutex decodedMutex;
+		std::vector<DecodedImage> decodedImages;
+		uint32_t generation = 0;
+
+		vk::Sampler sampler;
+		vk::Image placeholderImage;
+		vk::DeviceMemory placeholderImageMemory;
+		vk::ImageView placeholderImageView;
+	};
+}
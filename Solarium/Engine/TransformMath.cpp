@@ -0,0 +1,174 @@
+#include "TransformMath.hpp"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SOLARIUM_TRANSFORM_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOLARIUM_TRANSFORM_SSE
+#endif
+
+namespace Solarium
+{
+
+	template<typename Kernel>
+	void TransformMath::run(uint32_t count, JobSystem* jobSystem, Kernel kernel)
+	{
+		if (jobSystem && count > BATCH_SIZE)
+		{
+			jobSystem->parallelFor(count, BATCH_SIZE, kernel);
+		}
+		else
+		{
+			kernel(0, count);
+		}
+	}
+
+	glm::mat4 TransformMath::compose(glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+	{
+		float xx = rotation.x * rotation.x;
+		float yy = rotation.y * rotation.y;
+		float zz = rotation.z * rotation.z;
+		float xy = rotation.x * rotation.y;
+		float xz = rotation.x * rotation.z;
+		float yz = rotation.y * rotation.z;
+		float wx = rotation.w * rotation.x;
+		float wy = rotation.w * rotation.y;
+		float wz = rotation.w * rotation.z;
+
+		glm::mat4 out;
+		out[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * scale.x;
+		out[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * scale.y;
+		out[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * scale.z;
+		out[3] = glm::vec4(position, 1.0f);
+		return out;
+	}
+
+	glm::mat4 TransformMath::eulerRotation(glm::vec3 degrees)
+	{
+		glm::vec3 radians = glm::radians(degrees);
+		float sa = std::sin(radians.x), ca = std::cos(radians.x);
+		float sb = std::sin(radians.y), cb = std::cos(radians.y);
+		float sc = std::sin(radians.z), cc = std::cos(radians.z);
+
+		glm::mat4 out;
+		out[0] = glm::vec4(cb * cc, sa * sb * cc + ca * sc, sa * sc - ca * sb * cc, 0.0f);
+		out[1] = glm::vec4(-cb * sc, ca * cc - sa * sb * sc, ca * sb * sc + sa * cc, 0.0f);
+		out[2] = glm::vec4(sb, -sa * cb, ca * cb, 0.0f);
+		out[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		return out;
+	}
+
+	void TransformMath::multiply(const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& out)
+	{
+		const float* a = &lhs[0][0];
+		const float* b = &rhs[0][0];
+		float* result = &out[0][0];
+
+#if defined(SOLARIUM_TRANSFORM_AVX2)
+		// Both 128 bit lanes hold the same lhs column, so every iteration produces two result columns
+		__m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a));
+		__m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 4));
+		__m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 8));
+		__m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a + 12));
+		for (int column = 0; column < 4; column += 2)
+		{
+			__m256 bc = _mm256_loadu_ps(b + column * 4);
+			__m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm256_fmadd_ps(a1, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1)), r);
+			r = _mm256_fmadd_ps(a2, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2)), r);
+			r = _mm256_fmadd_ps(a3, _mm256_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3)), r);
+			_mm256_storeu_ps(result + column * 4, r);
+		}
+#elif defined(SOLARIUM_TRANSFORM_SSE)
+		__m128 a0 = _mm_loadu_ps(a);
+		__m128 a1 = _mm_loadu_ps(a + 4);
+		__m128 a2 = _mm_loadu_ps(a + 8);
+		__m128 a3 = _mm_loadu_ps(a + 12);
+		for (int column = 0; column < 4; column++)
+		{
+			__m128 bc = _mm_loadu_ps(b + column * 4);
+			__m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(0, 0, 0, 0)));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(1, 1, 1, 1))));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(2, 2, 2, 2))));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bc, bc, _MM_SHUFFLE(3, 3, 3, 3))));
+			_mm_storeu_ps(result + column * 4, r);
+		}
+#else
+		out = lhs * rhs;
+#endif
+	}
+
+	glm::mat4 TransformMath::normalMatrix(const glm::mat4& world)
+	{
+#if defined(SOLARIUM_TRANSFORM_AVX2) || defined(SOLARIUM_TRANSFORM_SSE)
+		// The rows of the inverse are the cross products of the columns over the determinant,
+		// so the columns of the inverse transpose are those same cross products
+		auto cross = [](__m128 a, __m128 b)
+		{
+			__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+			__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+			return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+		};
+
+		__m128 c0 = _mm_loadu_ps(&world[0][0]);
+		__m128 c1 = _mm_loadu_ps(&world[1][0]);
+		__m128 c2 = _mm_loadu_ps(&world[2][0]);
+		__m128 r0 = cross(c1, c2);
+		__m128 r1 = cross(c2, c0);
+		__m128 r2 = cross(c0, c1);
+
+		alignas(16) float products[4];
+		_mm_store_ps(products, _mm_mul_ps(c0, r0));
+		__m128 invDet = _mm_set1_ps(1.0f / (products[0] + products[1] + products[2]));
+
+		glm::mat4 out;
+		_mm_storeu_ps(&out[0][0], _mm_mul_ps(r0, invDet));
+		_mm_storeu_ps(&out[1][0], _mm_mul_ps(r1, invDet));
+		_mm_storeu_ps(&out[2][0], _mm_mul_ps(r2, invDet));
+		out[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		return out;
+#else
+		return glm::mat4(glm::transpose(glm::inverse(glm::mat3(world))));
+#endif
+	}
+
+	void TransformMath::composeLocal(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count, JobSystem* jobSystem)
+	{
+		run(count, jobSystem, [=](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				out[i] = compose(positions[i], rotations[i], scales[i]);
+			}
+		});
+	}
+
+	void TransformMath::computeMVP(const glm::mat4& viewProj, const glm::mat4* world, glm::mat4* out, uint32_t count, JobSystem* jobSystem, size_t outStride)
+	{
+		glm::mat4 sharedViewProj = viewProj;
+		char* outBytes = reinterpret_cast<char*>(out);
+		run(count, jobSystem, [=](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				multiply(sharedViewProj, world[i], *reinterpret_cast<glm::mat4*>(outBytes + i * outStride));
+			}
+		});
+	}
+
+	void TransformMath::computeNormalMatrices(const glm::mat4* world, glm::mat4* out, uint32_t count, JobSystem* jobSystem, size_t outStride)
+	{
+		char* outBytes = reinterpret_cast<char*>(out);
+		run(count, jobSystem, [=](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t i = begin; i < end; i++)
+			{
+				*reinterpret_cast<glm::mat4*>(outBytes + i * outStride) = normalMatrix(world[i]);
+			}
+		});
+	}
+}
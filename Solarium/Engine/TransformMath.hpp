@@ -0,0 +1,37 @@
+#pragma once
+
+#include "JobSystem.hpp"
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace Solarium
+{
+
+	class TransformMath
+	{
+	public:
+		static constexpr uint32_t BATCH_SIZE = 2048;
+
+		// translation * rotation * scale
+		static glm::mat4 compose(glm::vec3 position, glm::quat rotation, glm::vec3 scale);
+		// Same result as rotating around x, then y, then z by the given angles in degrees
+		static glm::mat4 eulerRotation(glm::vec3 degrees);
+		static void multiply(const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& out);
+		// Inverse transpose of the upper 3x3, padded back out to a mat4
+		static glm::mat4 normalMatrix(const glm::mat4& world);
+
+		// Batched kernels over plain arrays, split into BATCH_SIZE jobs past one batch. A null job system runs on the
+		// calling thread. outStride is the distance in bytes between results, so they can be written straight into
+		// interleaved per-instance data.
+		static void composeLocal(const glm::vec3* positions, const glm::quat* rotations, const glm::vec3* scales, glm::mat4* out, uint32_t count, JobSystem* jobSystem = nullptr);
+		// viewProj * world for every world matrix
+		static void computeMVP(const glm::mat4& viewProj, const glm::mat4* world, glm::mat4* out, uint32_t count, JobSystem* jobSystem = nullptr, size_t outStride = sizeof(glm::mat4));
+		static void computeNormalMatrices(const glm::mat4* world, glm::mat4* out, uint32_t count, JobSystem* jobSystem = nullptr, size_t outStride = sizeof(glm::mat4));
+
+	private:
+		template<typename Kernel>
+		static void run(uint32_t count, JobSystem* jobSystem, Kernel kernel);
+	};
+}
@@ -2,6 +2,8 @@
 #include "SwapChain.hpp"
 #include "BufferHelper.hpp"
 #include "Device.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "DescriptorAllocator.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,92 +14,49 @@
 
 namespace Solarium
 {
-	typedef enum class UBOType{
-		VIEWMODEL,
-		CAMERA
-	}UBOType;
-
-	struct structUBOviewmodel {
-		alignas(16) glm::mat4 model;
+	// Per-frame data in set 0, written once per frame and read by every draw
+	struct structUBOframe {
 		alignas(16) glm::mat4 view;
 		alignas(16) glm::mat4 proj;
-		alignas(16) glm::vec3 rotation;
-		alignas(16) glm::vec3 position;
-		alignas(16) glm::vec4 viewPos;
-	};
-
-	struct structUBOcamera {
-		alignas(16) glm::vec3 rotation;
-		alignas(16) glm::vec3 position;
+		alignas(16) glm::mat4 viewProj;
 		alignas(16) glm::vec4 viewPos;
 	};
 
-	struct UBOlist {
-		structUBOviewmodel viewmodel;
-		structUBOcamera camera;
-	};
-
+	// Owns the per-frame descriptor set (set 0) and its uniform buffer, one copy per swapchain image
 	class UBO
 	{
 	public:
-		UBO(SwapChain* swapChain_, Device* device_);
+		UBO(SwapChain* swapChain_, Device* device_, DescriptorLayoutCache* layoutCache_, DescriptorAllocator* descriptorAllocator_);
 		~UBO();
 		UBO(const UBO&) = delete;
 		UBO& operator=(const UBO&) = delete;
 
-		void updateUniformbuffer(uint32_t currentImage, UBOType type, UBOlist ubolist);
-		vk::DescriptorPool getDescriptorPool() { return descriptorPool; }
+		void updateUniformbuffer(uint32_t currentImage, const structUBOframe& frame);
 		std::vector<vk::DescriptorSet> getDescriptorSets() { return descriptorSets; }
-		vk::DescriptorSetLayout getDescriptorSetLayout() { return descriptorSetLayout; }
+		// The cache owns the layout, so this is valid until the cache is cleaned up
+		vk::DescriptorSetLayout getDescriptorSetLayout() { return layoutCache->createDescriptorSetLayout(descriptorSetLayoutBindings); }
 
-		std::vector<vk::Buffer> getUniformBuffers(UBOType type)
-		{
-			switch (type)
-			{
-				case(UBOType::VIEWMODEL):
-				{
-					return UBOviewmodel;
-				}
-				case(UBOType::CAMERA):
-				{
-					return UBOcamera;
-				}
-			}
-		}
+		std::vector<vk::Buffer> getUniformBuffers() { return UBOframe; }
+		std::vector<vk::DeviceMemory> getUniformBuffersMemory() { return UBOframeMemory; }
 
-		void depositDescriptorSetBinding(vk::DescriptorSetLayoutBinding binding) { descriptorSetLayoutBindings.push_back(binding); }
-		std::vector<vk::DeviceMemory> getUniformBuffersMemory(UBOType type)
-		{
-			switch (type)
-			{
-			case(UBOType::VIEWMODEL):
-			{
-				return UBOviewmodelMemory;
-			}
-			case(UBOType::CAMERA):
-			{
-				return UBOcameraMemory;
-			}
-			}
-		}
-		void createChain(vk::Sampler textureSampler, vk::ImageView textureImageView);
+		// Bindings of the per-frame set as reflected from the shaders; must be set before the layout is first used
+		void setDescriptorSetLayoutBindings(const std::vector<vk::DescriptorSetLayoutBinding>& bindings) { descriptorSetLayoutBindings = bindings; }
+		void createChain();
+		void cleanup();
 
 		void update(SwapChain* swapChain_, Device* device_) { swapChain = swapChain_; device = device_; }
 
 	private:
 		Device* device;
 		SwapChain* swapChain;
-		void createDescriptorSetLayout();
+		DescriptorLayoutCache* layoutCache;
+		DescriptorAllocator* descriptorAllocator;
 		void createUniformBuffers();
-		void createDescriptorPool();
-		void createDescriptorSets(vk::Sampler textureSampler, vk::ImageView textureImageView);
-		vk::DescriptorPool descriptorPool;
+		void createDescriptorSets();
 		std::vector<vk::DescriptorSet> descriptorSets;
 		std::vector <vk::DescriptorSetLayoutBinding> descriptorSetLayoutBindings;
-		vk::DescriptorSetLayout descriptorSetLayout;
-		std::vector<vk::Buffer> UBOviewmodel;
-		std::vector<vk::Buffer> UBOcamera;
-		std::vector<vk::DeviceMemory> UBOviewmodelMemory;
-		std::vector<vk::DeviceMemory> UBOcameraMemory;
+		std::vector<vk::Buffer> UBOframe;
+		std::vector<vk::DeviceMemory> UBOframeMemory;
+		std::vector<structUBOframe*> mappedFrames;
 	};
 }
\ No newline at end of file
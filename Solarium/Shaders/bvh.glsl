@@ -0,0 +1,166 @@
+// ##### BODIES #####
+// Spheres, boxes and triangles in the bounding volume hierarchy the Bvh class builds on the CPU, read from two
+// storage buffers at BVH_SET, BVH_BINDING and BVH_BINDING+1, which the including shader defines. The tests match
+// Bvh::intersect, which the CPU reference tracer uses.
+
+// Bvh::MAX_DEPTH, so the stack holds the far child of every node on the way down
+#define BVH_STACK_SIZE 32
+#define BVH_MISS 3.4e38
+
+#define BVH_SPHERE 0U
+#define BVH_BOX 1U
+#define BVH_TRIANGLE 2U
+
+// An interior node (count 0) has its left child right after it and its right child at first; a leaf holds count
+// primitives from first
+struct BvhNode {
+    vec3 boundsMin;
+    uint first;
+    vec3 boundsMax;
+    uint count;
+};
+
+// Sphere: centre and radius in shape[0]. Box: min and max corner in shape[0] and shape[1]. Triangle: three corners.
+struct BvhPrimitive {
+    vec4 shape[3];
+    vec3 albedo;
+    float roughness;
+    uint type;
+    uint body;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = BVH_SET, binding = BVH_BINDING) readonly buffer BvhNodes {
+    BvhNode bvhNodes[];
+};
+layout(std430, set = BVH_SET, binding = BVH_BINDING+1) readonly buffer BvhPrimitives {
+    BvhPrimitive bvhPrimitives[];
+};
+
+// Distance the ray enters the bounds at, BVH_MISS when it does so past maxdistance
+float intersectBvhBounds(vec3 boundsMin, vec3 boundsMax, vec3 rayori, vec3 invdir, float maxdistance){
+    vec3 t1 = (boundsMin-rayori)*invdir;
+    vec3 t2 = (boundsMax-rayori)*invdir;
+    vec3 tnear = min(t1, t2);
+    vec3 tfar = max(t1, t2);
+    float nearest = max(max(tnear.x, tnear.y), max(tnear.z, 0.0));
+    float farthest = min(min(tfar.x, tfar.y), min(tfar.z, maxdistance));
+    return nearest <= farthest ? nearest : BVH_MISS;
+}
+
+float intersectBvhPrimitive(BvhPrimitive primitive, vec3 rayori, vec3 raydir, vec3 invdir){
+    if(primitive.type == BVH_SPHERE){
+        vec3 oc = rayori-primitive.shape[0].xyz;
+        float b = dot(oc, raydir);
+        float h = b*b-dot(oc, oc)+primitive.shape[0].w*primitive.shape[0].w;
+        if(h < 0.0){return BVH_MISS;}
+        h = sqrt(h);
+        // The far side when the ray starts inside
+        float t = -b-h > 0.0 ? -b-h : -b+h;
+        return t > 0.0 ? t : BVH_MISS;
+    }
+    if(primitive.type == BVH_BOX){
+        vec3 t1 = (primitive.shape[0].xyz-rayori)*invdir;
+        vec3 t2 = (primitive.shape[1].xyz-rayori)*invdir;
+        vec3 tnear = min(t1, t2);
+        vec3 tfar = max(t1, t2);
+        float nearest = max(max(tnear.x, tnear.y), tnear.z);
+        float farthest = min(min(tfar.x, tfar.y), tfar.z);
+        if(farthest < max(nearest, 0.0)){return BVH_MISS;}
+        float t = nearest > 0.0 ? nearest : farthest;
+        return t > 0.0 ? t : BVH_MISS;
+    }
+    // Moller-Trumbore, from both sides
+    vec3 edge1 = primitive.shape[1].xyz-primitive.shape[0].xyz;
+    vec3 edge2 = primitive.shape[2].xyz-primitive.shape[0].xyz;
+    vec3 p = cross(raydir, edge2);
+    float determinant = dot(edge1, p);
+    if(abs(determinant) < 1e-12){return BVH_MISS;}
+    float invdeterminant = 1.0/determinant;
+    vec3 s = rayori-primitive.shape[0].xyz;
+    float u = dot(s, p)*invdeterminant;
+    vec3 q = cross(s, edge1);
+    float v = dot(raydir, q)*invdeterminant;
+    if(u < 0.0 || v < 0.0 || u+v > 1.0){return BVH_MISS;}
+    float t = dot(edge2, q)*invdeterminant;
+    return t > 0.0 ? t : BVH_MISS;
+}
+
+// Faces against the ray
+vec3 bvhPrimitiveNormal(BvhPrimitive primitive, vec3 pos, vec3 raydir){
+    vec3 norm;
+    if(primitive.type == BVH_SPHERE){
+        norm = normalize(pos-primitive.shape[0].xyz);
+    }else if(primitive.type == BVH_BOX){
+        // The face whose axis the hit lies farthest along, relative to the half extents
+        vec3 center = (primitive.shape[0].xyz+primitive.shape[1].xyz)*0.5;
+        vec3 local = (pos-center)/(primitive.shape[1].xyz-center);
+        vec3 size = abs(local);
+        int axis = size.x > size.y ? (size.x > size.z ? 0 : 2) : (size.y > size.z ? 1 : 2);
+        norm = vec3(0.0);
+        norm[axis] = local[axis] < 0.0 ? -1.0 : 1.0;
+    }else{
+        norm = normalize(cross(primitive.shape[1].xyz-primitive.shape[0].xyz, primitive.shape[2].xyz-primitive.shape[0].xyz));
+    }
+    return dot(norm, raydir) > 0.0 ? -norm : norm;
+}
+
+// Closest body nearer than maxdistance, -1.0 if there is none. nodecount is 0 while there are no bodies, and the
+// buffers may be longer than what is in use.
+float intersectBodies(in vec3 rayori, in vec3 raydir, float maxdistance, uint nodecount, out vec3 albedo, out vec3 norm, out float rough){
+    if(nodecount == 0U){return -1.0;}
+    vec3 invdir = 1.0/raydir;
+    if(intersectBvhBounds(bvhNodes[0].boundsMin, bvhNodes[0].boundsMax, rayori, invdir, maxdistance) == BVH_MISS){return -1.0;}
+
+    float closest = maxdistance;
+    int closestprimitive = -1;
+    uint stack[BVH_STACK_SIZE];
+    float stackdistance[BVH_STACK_SIZE];
+    uint stacksize = 0U;
+    uint index = 0U;
+    while(true){
+        BvhNode node = bvhNodes[index];
+        if(node.count > 0U){
+            for(uint p = node.first; p < node.first+node.count; p++){
+                float t = intersectBvhPrimitive(bvhPrimitives[p], rayori, raydir, invdir);
+                if(t < closest){
+                    closest = t;
+                    closestprimitive = int(p);
+                }
+            }
+        }else{
+            // Into the nearer child first, the farther one waits on the stack
+            uint nearchild = index+1U;
+            uint farchild = node.first;
+            float neardistance = intersectBvhBounds(bvhNodes[nearchild].boundsMin, bvhNodes[nearchild].boundsMax, rayori, invdir, closest);
+            float fardistance = intersectBvhBounds(bvhNodes[farchild].boundsMin, bvhNodes[farchild].boundsMax, rayori, invdir, closest);
+            if(fardistance < neardistance){
+                uint swapchild = nearchild; nearchild = farchild; farchild = swapchild;
+                float swapdistance = neardistance; neardistance = fardistance; fardistance = swapdistance;
+            }
+            if(neardistance != BVH_MISS){
+                if(fardistance != BVH_MISS){
+                    stack[stacksize] = farchild;
+                    stackdistance[stacksize] = fardistance;
+                    stacksize++;
+                }
+                index = nearchild;
+                continue;
+            }
+        }
+
+        // Skip what a hit found since has moved in front of
+        while(stacksize > 0U && stackdistance[stacksize-1U] >= closest){stacksize--;}
+        if(stacksize == 0U){break;}
+        stacksize--;
+        index = stack[stacksize];
+    }
+
+    if(closestprimitive < 0){return -1.0;}
+    BvhPrimitive primitive = bvhPrimitives[closestprimitive];
+    norm = bvhPrimitiveNormal(primitive, rayori+raydir*closest, raydir);
+    albedo = primitive.albedo;
+    rough = primitive.roughness;
+    return closest;
+}
@@ -0,0 +1,14 @@
+#version 460 core
+#extension GL_KHR_vulkan_glsl : enable
+#extension GL_ARB_separate_shader_objects : enable
+
+// Stand-in for main.frag while its pipeline compiles; no texture reads
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(fragColor, 1.0);
+}
\ No newline at end of file
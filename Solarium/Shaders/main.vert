@@ -2,16 +2,30 @@
 #extension GL_KHR_vulkan_glsl : enable
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(binding = 0) uniform UBOmvp {
-    mat4 model;
+// Set 0, per frame: structUBOframe in UBO.hpp
+layout(set = 0, binding = 0) uniform FrameData {
     mat4 view;
     mat4 proj;
-} ubo;
-layout(binding = 2) uniform UBOcolor{
-    vec3 rotation;
-    vec3 position;
-    vec4 viewPost;
-} ubso;
+    mat4 viewProj;
+    vec4 viewPos;
+} frame;
+
+// Set 1, per pass: InstanceData in Pipeline.hpp
+struct ObjectData {
+    mat4 model;
+    mat4 mvp;
+    mat4 normalMatrix;
+    uint textureIndex;
+};
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+};
+
+// DrawPushConstants in Pipeline.hpp; model is already folded into ObjectData.mvp
+layout(push_constant) uniform DrawConstants {
+    mat4 model;
+    uint materialIndex;
+} draw;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -19,9 +33,12 @@ layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = object.mvp * vec4(inPosition, 1.0);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+    fragTextureIndex = object.textureIndex == 0xFFFFFFFFu ? draw.materialIndex : object.textureIndex;
 }
\ No newline at end of file
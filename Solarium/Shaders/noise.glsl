@@ -0,0 +1,140 @@
+// ##### NOISE #####
+// The noise of shadders/shadders/common.glsl, plus tileable versions of it that noise_bake.comp bakes into the
+// textures of NoiseCache. A shader that defines NOISE_TEXTURES, NOISE_SET and NOISE_BINDING before including this
+// also gets the ...Baked lookups, and can then pick analytic or baked noise at each call site.
+
+#define pi 3.14159265
+#define twopi pi*2.0
+
+// Cyclic Noise (2D)
+float cyclic(vec2 coord){
+    return abs(cos(coord.x)+cos(coord.y))/2.0;
+}
+
+// Fractal Brownian Motion (FBM) Cyclic Noise (2D)
+float fbmcyclic(vec2 coord, uint octaves){
+    float value = 0.0;
+    float scale = 1.0;
+    float atten = 0.5;
+    for(uint i = 0U; i < octaves; i++){
+        value += cyclic(coord*scale)*atten;
+        scale *= 2.0;
+        atten *= 0.5;
+    }
+    return value;
+}
+
+// Cyclic Noise
+float cyclic(vec3 coord){
+    return abs(cos(coord.x)+cos(coord.y)+cos(coord.z))/3.0;
+}
+
+// Fractal Brownian Motion (FBM) Cyclic Noise
+float fbmcyclic(vec3 coord, uint octaves){
+    float value = 0.0;
+    float scale = 1.0;
+    float atten = 0.5;
+    for(uint i = 0U; i < octaves; i++){
+        value += cyclic(coord*scale)*atten;
+        scale *= 2.0;
+        atten *= 0.5;
+    }
+    return value;
+}
+
+// Dave_Hoskins Hash33: https://www.shadertoy.com/view/4djSRW
+vec3 hash(vec3 p3){
+    p3 = fract(p3*vec3(0.1031, 0.1030, 0.0973));
+    p3 += dot(p3, p3.yxz+33.33);
+    return fract((p3.xxy+p3.yxx)*p3.zyx);
+}
+
+// Worley Noise
+float worley(vec3 coord){
+    vec3 cell = floor(coord);
+    float mindist = 1000.0;
+    for(int z = -1; z < 2; z++){
+    for(int y = -1; y < 2; y++){
+    for(int x = -1; x < 2; x++){
+        vec3 ncell = cell+vec3(x, y, z);
+        vec3 point = ncell+hash(ncell);
+        mindist = min(dot(coord-point, coord-point), mindist);
+    }
+    }
+    }
+    return sqrt(mindist);
+}
+
+// Fractal Brownian Motion (FBM) Worley Noise
+float fbmworley(vec3 coord, uint octaves){
+    float value = 0.0;
+    float scale = 1.0;
+    float atten = 0.5;
+    for(uint i = 0U; i < octaves; i++){
+        value += worley(coord*scale)*atten;
+        scale *= 2.0;
+        atten *= 0.5;
+    }
+    return value;
+}
+
+// ##### TILEABLE NOISE #####
+// Cyclic noise repeats every twopi at every octave already. Worley noise repeats every worleyPeriod cells once the
+// cells are hashed modulo the period; each FBM octave doubles both the frequency and the period, so the sum
+// repeats every worleyPeriod as well.
+const float worleyPeriod = 8.0;
+
+// Worley Noise repeating every period cells
+float worley(vec3 coord, float period){
+    vec3 cell = floor(coord);
+    float mindist = 1000.0;
+    for(int z = -1; z < 2; z++){
+    for(int y = -1; y < 2; y++){
+    for(int x = -1; x < 2; x++){
+        vec3 ncell = cell+vec3(x, y, z);
+        vec3 point = ncell+hash(mod(ncell, period));
+        mindist = min(dot(coord-point, coord-point), mindist);
+    }
+    }
+    }
+    return sqrt(mindist);
+}
+
+// Fractal Brownian Motion (FBM) Worley Noise repeating every worleyPeriod
+float fbmworleytiled(vec3 coord, uint octaves){
+    float value = 0.0;
+    float scale = 1.0;
+    float atten = 0.5;
+    for(uint i = 0U; i < octaves; i++){
+        value += worley(coord*scale, worleyPeriod*scale)*atten;
+        scale *= 2.0;
+        atten *= 0.5;
+    }
+    return value;
+}
+
+// ##### BAKED NOISE #####
+// Filtered lookups into the textures of NoiseCache, sampled with repeat addressing. The octave counts of the FBM
+// textures are fixed when baking, see NoiseCache::TEXTURES, and are capped by the texture resolution.
+#ifdef NOISE_TEXTURES
+layout(set = NOISE_SET, binding = NOISE_BINDING) uniform sampler3D worleyTexture;
+layout(set = NOISE_SET, binding = NOISE_BINDING+1) uniform sampler3D fbmWorleyTexture;
+layout(set = NOISE_SET, binding = NOISE_BINDING+2) uniform sampler3D fbmCyclicTexture;
+layout(set = NOISE_SET, binding = NOISE_BINDING+3) uniform sampler2D fbmCyclic2DTexture;
+
+float worleyBaked(vec3 coord){
+    return texture(worleyTexture, coord/worleyPeriod).r;
+}
+
+float fbmworleyBaked(vec3 coord){
+    return texture(fbmWorleyTexture, coord/worleyPeriod).r;
+}
+
+float fbmcyclicBaked(vec3 coord){
+    return texture(fbmCyclicTexture, coord/(twopi)).r;
+}
+
+float fbmcyclicBaked(vec2 coord){
+    return texture(fbmCyclic2DTexture, coord/(twopi)).r;
+}
+#endif
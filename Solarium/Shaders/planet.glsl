@@ -0,0 +1,46 @@
+// ##### PLANET #####
+// Distance estimator shared by raytrace.comp and the distance field bake in sdf_bake.comp. The numbers come from
+// scene.h, which the CPU reference tracer reads as well.
+
+#include "noise.glsl"
+#include "scene.h"
+
+const vec3 planetCenter = vec3(PLANET_CENTER_X, PLANET_CENTER_Y, PLANET_CENTER_Z);
+const float planetRadius = PLANET_RADIUS;
+const float terrainHeight = TERRAIN_HEIGHT;
+
+// Everything the estimator can hit lies inside these bounds, which is also the volume the distance field covers
+const vec3 planetBoundsMin = planetCenter-vec3(planetRadius+terrainHeight+BOUNDS_MARGIN);
+const vec3 planetBoundsMax = planetCenter+vec3(planetRadius+terrainHeight+BOUNDS_MARGIN);
+
+// Planet Distance Estimator, with FBM terrain displaced along the radius.
+// Scaled down because the displacement makes the raw estimate overshoot on steep slopes.
+float planet(vec3 pos){
+    vec3 local = pos-planetCenter;
+    float terrain = terrainHeight*fbmcyclic(normalize(local)*TERRAIN_FREQUENCY, uint(TERRAIN_OCTAVES));
+    return ESTIMATOR_SCALE*(length(local)-planetRadius-terrain);
+}
+
+vec3 planetNormal(vec3 pos){
+    const vec2 offset = vec2(1e-3, 0.0);
+    return normalize(vec3(planet(pos+offset.xyy)-planet(pos-offset.xyy), planet(pos+offset.yxy)-planet(pos-offset.yxy), planet(pos+offset.yyx)-planet(pos-offset.yyx)));
+}
+
+vec3 planetAlbedo(vec3 pos){
+    vec3 local = pos-planetCenter;
+    float height = (length(local)-planetRadius)/terrainHeight;
+    // Rocky patches; only shading depends on them, so the baked noise is close enough
+#ifdef NOISE_TEXTURES
+    float rock = fbmworleyBaked(normalize(local)*ROCK_FREQUENCY);
+#else
+    float rock = fbmworleytiled(normalize(local)*ROCK_FREQUENCY, uint(ROCK_OCTAVES));
+#endif
+    vec3 land = mix(vec3(LAND_ALBEDO), vec3(ROCK_ALBEDO), smoothstep(ROCK_COVER_MIN, ROCK_COVER_MAX, rock));
+    return mix(vec3(OCEAN_ALBEDO), land, smoothstep(SHORE_HEIGHT_MIN, SHORE_HEIGHT_MAX, height));
+}
+
+vec3 skyCol(vec3 dir){
+    const vec3 sundir = normalize(vec3(SUN_DIRECTION));
+    vec3 sky = mix(vec3(SKY_HORIZON), vec3(SKY_ZENITH), clamp(dir.z*0.5+0.5, 0.0, 1.0));
+    return sky+vec3(SUN_RADIANCE)*smoothstep(SUN_EDGE_MIN, SUN_EDGE_MAX, dot(dir, sundir));
+}
@@ -0,0 +1,13 @@
+// ##### QUALITY #####
+// The quality parameters as specialization constants, so the engine can switch tiers without compiling the GLSL again.
+// Ids and defaults come from quality.h, which ShaderQuality reads as well.
+
+#include "quality.h"
+
+// Maximum Ray-Tracing Bounces
+layout(constant_id = MAX_BOUNCES_CONSTANT_ID) const uint maxbounces = DEFAULT_MAX_BOUNCES;
+
+// Ray-Marching Parameters (for Ray-Tracing Distance Estimators)
+layout(constant_id = MAX_MARCHES_CONSTANT_ID) const uint maxmarches = DEFAULT_MAX_MARCHES;
+layout(constant_id = COLLISION_DISTANCE_CONSTANT_ID) const float collisiondist = DEFAULT_COLLISION_DISTANCE;
+layout(constant_id = MAX_DISTANCE_CONSTANT_ID) const float maxdist = DEFAULT_MAX_DISTANCE;
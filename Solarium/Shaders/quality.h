@@ -0,0 +1,13 @@
+// ##### QUALITY #####
+// Ids and defaults of the quality specialization constants, shared by quality.glsl and ShaderQuality in
+// Engine/Pipeline.hpp. Only plain defines, so GLSL and C++ can both include it. The defaults are the high tier.
+
+#define MAX_BOUNCES_CONSTANT_ID 0
+#define MAX_MARCHES_CONSTANT_ID 1
+#define COLLISION_DISTANCE_CONSTANT_ID 2
+#define MAX_DISTANCE_CONSTANT_ID 3
+
+#define DEFAULT_MAX_BOUNCES 32U
+#define DEFAULT_MAX_MARCHES 128U
+#define DEFAULT_COLLISION_DISTANCE 1e-4
+#define DEFAULT_MAX_DISTANCE 32.0
@@ -0,0 +1,13 @@
+#version 460 core
+#extension GL_KHR_vulkan_glsl : enable
+
+// Shows the accumulated image written by raytrace.comp, which matches the framebuffer size pixel for pixel
+layout(set = 0, binding = 0) uniform sampler2D accumulation;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    vec3 color = texelFetch(accumulation, ivec2(gl_FragCoord.xy), 0).rgb;
+    // HDR Tonemapping; the sRGB swapchain applies the gamma curve
+    outColor = vec4(color / (color + 1.0), 1.0);
+}
@@ -0,0 +1,51 @@
+// ##### SCENE #####
+// The planet scene, shared by the GPU path (planet.glsl, raytrace.comp) and the CPU reference tracer in
+// Engine/CpuTracer.cpp. Only plain defines, so GLSL and C++ can both include it; C++ reads them as doubles.
+
+#define PLANET_CENTER_X 0.0
+#define PLANET_CENTER_Y 0.0
+#define PLANET_CENTER_Z -2.0
+#define PLANET_RADIUS 1.5
+
+// Terrain: FBM cyclic noise over the direction from the centre, displaced along the radius
+#define TERRAIN_HEIGHT 0.12
+#define TERRAIN_FREQUENCY 8.0
+#define TERRAIN_OCTAVES 7
+// The displacement makes the raw estimate overshoot on steep slopes
+#define ESTIMATOR_SCALE 0.7
+// Margin around the terrain in the bounds, which the distance field also covers
+#define BOUNDS_MARGIN 0.05
+
+// Albedo: ocean below the shore height, land above, with rocky patches from FBM Worley noise
+#define SHORE_HEIGHT_MIN 0.35
+#define SHORE_HEIGHT_MAX 0.45
+#define ROCK_FREQUENCY 4.0
+#define ROCK_OCTAVES 4
+#define ROCK_COVER_MIN 0.35
+#define ROCK_COVER_MAX 0.55
+#define OCEAN_ALBEDO 0.15, 0.3, 0.6
+#define LAND_ALBEDO 0.55, 0.5, 0.35
+#define ROCK_ALBEDO 0.4, 0.38, 0.36
+
+// Sky gradient from the horizon up, plus a sun disc
+#define SKY_HORIZON 0.9, 0.95, 1.0
+#define SKY_ZENITH 0.3, 0.5, 0.9
+#define SUN_DIRECTION 0.6, 0.3, 0.75
+#define SUN_RADIANCE 20.0, 18.0, 15.0
+#define SUN_EDGE_MIN 0.995
+#define SUN_EDGE_MAX 0.998
+
+// Bodies around the planet, traced through the Bvh rather than marched: a moon, a mirror sphere, a monolith box
+// standing on the terrain and a crystal octahedron made of triangles
+#define MOON_CENTER 0.35, -0.85, 0.3
+#define MOON_RADIUS 0.2
+#define MOON_ALBEDO 0.7, 0.7, 0.68
+#define MIRROR_CENTER -0.75, 0.25, -0.05
+#define MIRROR_RADIUS 0.3
+#define MIRROR_ALBEDO 0.9, 0.9, 0.9
+#define MONOLITH_CENTER 0.0, 0.0, -0.2
+#define MONOLITH_HALF_EXTENTS 0.08, 0.08, 0.35
+#define MONOLITH_ALBEDO 0.1, 0.1, 0.1
+#define CRYSTAL_CENTER 0.8, 0.05, -0.1
+#define CRYSTAL_SIZE 0.18
+#define CRYSTAL_ALBEDO 0.5, 0.8, 0.7
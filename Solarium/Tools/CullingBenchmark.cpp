@@ -0,0 +1,144 @@
+// CullingBenchmark.cpp : Times FrustumCuller against a plain loop over an array of spheres, on one thread and on the
+// job system. The spheres are scattered around the engine's camera, so about a third of them are visible.
+//
+// Usage: CullingBenchmark [spheres] [--threads N]
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "../Engine/Culling.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+
+static constexpr int REPEATS = 20;
+
+// Best of REPEATS runs, in milliseconds
+static double timeBest(const std::function<void()>& run)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < REPEATS; repeat++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		run();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+int main(int argc, const char** argv)
+{
+	uint32_t count = 1000000;
+	uint32_t threads = 0;
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+			else if (arg[0] != '-') count = std::stoul(arg);
+			else
+			{
+				std::cerr << "Usage: CullingBenchmark [spheres] [--threads N]" << std::endl;
+				return 1;
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		std::cerr << "Sphere and thread counts must be numbers" << std::endl;
+		return 1;
+	}
+
+	glm::vec3 eye = glm::vec3(2.0f, 2.0f, 2.0f);
+	glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 10.0f);
+	proj[1][1] *= -1;
+	Solarium::Frustum frustum = Solarium::Frustum::fromMatrix(proj * view);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-4.0f, 4.0f);
+	std::uniform_real_distribution<float> size(0.01f, 0.1f);
+	std::vector<glm::vec4> spheres(count);
+	Solarium::FrustumCuller culler;
+	culler.reserve(count);
+	for (glm::vec4& sphere : spheres)
+	{
+		sphere = glm::vec4(position(random), position(random), position(random), size(random));
+		culler.addSphere(glm::vec3(sphere), sphere.w);
+	}
+
+	// The layout FrustumCuller replaced: one sphere after another, every plane tested with scalar math
+	std::vector<uint32_t> reference;
+	double referenceTime = timeBest([&]()
+	{
+		reference.clear();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			bool inside = true;
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				inside &= glm::dot(glm::vec3(plane), glm::vec3(spheres[i])) + plane.w >= -spheres[i].w;
+			}
+			if (inside)
+			{
+				reference.push_back(i);
+			}
+		}
+	});
+
+	// The SIMD paths round differently, so only spheres touching a plane to within rounding may disagree
+	auto matches = [&](const std::vector<uint32_t>& visible)
+	{
+		std::vector<uint32_t> differing;
+		std::set_symmetric_difference(visible.begin(), visible.end(), reference.begin(), reference.end(), std::back_inserter(differing));
+		return std::all_of(differing.begin(), differing.end(), [&](uint32_t i)
+		{
+			return std::any_of(std::begin(frustum.planes), std::end(frustum.planes), [&](const glm::vec4& plane)
+			{
+				return std::abs(glm::dot(glm::vec3(plane), glm::vec3(spheres[i])) + plane.w + spheres[i].w) < 1e-5f;
+			});
+		});
+	};
+
+	std::vector<uint32_t> visible;
+	double singleTime = timeBest([&]() { culler.cullSpheres(frustum, nullptr, visible); });
+	bool singleMatches = matches(visible);
+
+	// A thread count of 1 runs on this thread alone
+	std::unique_ptr<Solarium::JobSystem> jobSystem;
+	double parallelTime = 0.0;
+	bool parallelMatches = true;
+	if (threads != 1)
+	{
+		jobSystem = std::make_unique<Solarium::JobSystem>(threads == 0 ? 0 : threads - 1);
+		parallelTime = timeBest([&]() { culler.cullSpheres(frustum, jobSystem.get(), visible); });
+		parallelMatches = matches(visible);
+	}
+
+	auto report = [&](const std::string& name, double milliseconds)
+	{
+		std::cout << name << ": " << milliseconds << " ms, " << count / milliseconds / 1e3 << " Mspheres/s, " << referenceTime / milliseconds << "x" << std::endl;
+	};
+	std::cout << count << " spheres, " << reference.size() << " visible" << std::endl;
+	report("Scalar loop over an array of spheres", referenceTime);
+	report("FrustumCuller on 1 thread", singleTime);
+	if (jobSystem)
+	{
+		report("FrustumCuller on " + std::to_string(jobSystem->getWorkerCount() + 1) + " threads", parallelTime);
+	}
+
+	if (!singleMatches || !parallelMatches)
+	{
+		std::cerr << "FrustumCuller disagrees with the scalar loop" << std::endl;
+		return 1;
+	}
+	return 0;
+}
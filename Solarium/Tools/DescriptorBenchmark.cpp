@@ -0,0 +1,127 @@
+// DescriptorBenchmark.cpp : Times writing descriptor sets through a DescriptorTemplate against building one
+// vk::WriteDescriptorSet per binding and calling updateDescriptorSets. The set has the shape of the ray tracer's
+// compute set, two uniform buffers and six storage buffers, and both paths fill their infos on every update.
+// Needs a Vulkan device, so it opens a small window like the engine does.
+//
+// Usage: DescriptorBenchmark [sets]
+
+#include "../Engine/DescriptorAllocator.hpp"
+#include "../Engine/DescriptorLayoutCache.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static constexpr int REPEATS = 20;
+static constexpr uint32_t UNIFORM_BINDINGS = 2;
+static constexpr uint32_t STORAGE_BINDINGS = 6;
+
+// Best of REPEATS runs, in milliseconds
+static double timeBest(const std::function<void()>& run)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < REPEATS; repeat++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		run();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+int main(int argc, const char** argv)
+{
+	uint32_t setCount = 10000;
+	if (argc > 1)
+	{
+		try
+		{
+			setCount = std::stoul(argv[1]);
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "Usage: DescriptorBenchmark [sets]" << std::endl;
+			return 1;
+		}
+	}
+
+	try
+	{
+		Solarium::Platform platform("DescriptorBenchmark", 64, 64);
+		Solarium::Device device{ platform };
+
+		vk::Buffer buffer;
+		vk::DeviceMemory bufferMemory;
+		device.createBuffer(256, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal, buffer, bufferMemory);
+
+		double writeTime, templateTime;
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;
+			for (uint32_t binding = 0; binding < UNIFORM_BINDINGS + STORAGE_BINDINGS; binding++)
+			{
+				vk::DescriptorType type = binding < UNIFORM_BINDINGS ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+				bindings.push_back(vk::DescriptorSetLayoutBinding{ binding, type, 1, vk::ShaderStageFlagBits::eCompute });
+			}
+
+			Solarium::DescriptorLayoutCache layoutCache(&device);
+			Solarium::DescriptorAllocator descriptorAllocator(&device);
+			vk::DescriptorSetLayout layout = layoutCache.createDescriptorSetLayout(bindings);
+			Solarium::DescriptorTemplate* updateTemplate = layoutCache.getUpdateTemplate(bindings);
+
+			std::vector<vk::DescriptorSet> sets(setCount);
+			for (vk::DescriptorSet& set : sets)
+			{
+				set = descriptorAllocator.allocate(layout);
+			}
+
+			writeTime = timeBest([&]()
+			{
+				std::vector<vk::DescriptorBufferInfo> bufferInfos(bindings.size());
+				std::vector<vk::WriteDescriptorSet> writes(bindings.size());
+				for (vk::DescriptorSet set : sets)
+				{
+					for (size_t i = 0; i < bindings.size(); i++)
+					{
+						bufferInfos[i] = vk::DescriptorBufferInfo{ buffer, 0, VK_WHOLE_SIZE };
+						writes[i] = vk::WriteDescriptorSet{ set, bindings[i].binding, 0, 1, bindings[i].descriptorType, nullptr, &bufferInfos[i] };
+					}
+					device.device().updateDescriptorSets(writes, {});
+				}
+			});
+
+			templateTime = timeBest([&]()
+			{
+				std::vector<Solarium::DescriptorInfo> data = updateTemplate->createData();
+				for (vk::DescriptorSet set : sets)
+				{
+					for (const vk::DescriptorSetLayoutBinding& binding : bindings)
+					{
+						data[updateTemplate->slot(binding.binding)].buffer = vk::DescriptorBufferInfo{ buffer, 0, VK_WHOLE_SIZE };
+					}
+					updateTemplate->update(set, data);
+				}
+			});
+		}
+
+		device.device().destroyBuffer(buffer);
+		device.device().freeMemory(bufferMemory);
+
+		auto report = [&](const std::string& name, double milliseconds)
+		{
+			std::cout << name << ": " << milliseconds << " ms, " << milliseconds * 1e6 / setCount << " ns per set, " << writeTime / milliseconds << "x" << std::endl;
+		};
+		std::cout << setCount << " sets of " << UNIFORM_BINDINGS + STORAGE_BINDINGS << " buffer descriptors" << std::endl;
+		report("vk::WriteDescriptorSet", writeTime);
+		report("DescriptorTemplate", templateTime);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,130 @@
+// MipBenchmark.cpp : Shows what the mip chains ImageHelper builds save when a texture is drawn minified. Every
+// pixel of a view that shrinks the texture by a power of two takes a bilinear 2x2 footprint, either from level 0
+// or from the level that matches the minification. The tool counts the distinct 64 byte cache lines each touches,
+// which is the memory traffic the sampler cannot avoid, and times both. It also times building the chain itself.
+//
+// Usage: MipBenchmark [size]
+
+#include "../Engine/ImageHelper.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr int REPEATS = 10;
+static constexpr size_t CACHE_LINE = 64;
+
+// Best of REPEATS runs, in milliseconds
+static double timeBest(const std::function<void()>& run)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < REPEATS; repeat++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		run();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+struct Level
+{
+	const uint8_t* texels;
+	uint32_t width;
+	uint32_t height;
+};
+
+// Walks a view of pixels x pixels that each sample level at stride texels apart, calling fetch for every texel
+// of their bilinear footprints
+template<typename Fetch>
+static void sampleView(const Level& level, uint32_t pixels, uint32_t stride, Fetch fetch)
+{
+	for (uint32_t y = 0; y < pixels; y++)
+	{
+		uint32_t y0 = std::min(y * stride, level.height - 1);
+		uint32_t y1 = std::min(y0 + 1, level.height - 1);
+		for (uint32_t x = 0; x < pixels; x++)
+		{
+			uint32_t x0 = std::min(x * stride, level.width - 1);
+			uint32_t x1 = std::min(x0 + 1, level.width - 1);
+			fetch(y0 * level.width + x0);
+			fetch(y0 * level.width + x1);
+			fetch(y1 * level.width + x0);
+			fetch(y1 * level.width + x1);
+		}
+	}
+}
+
+static size_t touchedBytes(const Level& level, uint32_t pixels, uint32_t stride)
+{
+	std::vector<uint8_t> touched((size_t(level.width) * level.height * 4 + CACHE_LINE - 1) / CACHE_LINE);
+	sampleView(level, pixels, stride, [&](size_t texel) { touched[texel * 4 / CACHE_LINE] = 1; });
+	return std::count(touched.begin(), touched.end(), 1) * CACHE_LINE;
+}
+
+static double sampleTime(const Level& level, uint32_t pixels, uint32_t stride, uint64_t& checksum)
+{
+	return timeBest([&]()
+	{
+		uint64_t sum = 0;
+		sampleView(level, pixels, stride, [&](size_t texel) { sum += level.texels[texel * 4]; });
+		checksum += sum;
+	});
+}
+
+int main(int argc, const char** argv)
+{
+	uint32_t size = 4096;
+	if (argc > 1)
+	{
+		try
+		{
+			size = std::stoul(argv[1]);
+		}
+		catch (const std::exception&)
+		{
+			std::cerr << "Usage: MipBenchmark [size]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::mt19937 random(1);
+	std::vector<uint8_t> pixels(size_t(size) * size * 4);
+	for (uint8_t& value : pixels)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	uint32_t mipLevels = Solarium::ImageHelper::mipLevelCount(size, size);
+	std::vector<size_t> levelOffsets;
+	std::vector<uint8_t> chain;
+	double chainTime = timeBest([&]() { chain = Solarium::ImageHelper::generateMipChain(pixels.data(), size, size, mipLevels, true, levelOffsets); });
+	std::cout << size << "x" << size << " sRGB mip chain: " << mipLevels << " levels in " << chainTime << " ms, "
+		<< chain.size() / 1048576.0 << " MiB against " << pixels.size() / 1048576.0 << " MiB for level 0" << std::endl;
+
+	Level base{ chain.data(), size, size };
+	uint64_t checksum = 0;
+	for (uint32_t level = 1; level < mipLevels && size >> level >= 64; level++)
+	{
+		uint32_t viewSize = size >> level;
+		Level matching{ chain.data() + levelOffsets[level], Solarium::ImageHelper::mipExtent(size, level), Solarium::ImageHelper::mipExtent(size, level) };
+
+		size_t baseBytes = touchedBytes(base, viewSize, 1u << level);
+		size_t mipBytes = touchedBytes(matching, viewSize, 1);
+		double baseTime = sampleTime(base, viewSize, 1u << level, checksum);
+		double mipTime = sampleTime(matching, viewSize, 1, checksum);
+
+		std::cout << "Minified " << (1u << level) << "x into " << viewSize << "x" << viewSize << " pixels: level 0 touches "
+			<< baseBytes / 1024 << " KiB in " << baseTime << " ms, level " << level << " touches "
+			<< mipBytes / 1024 << " KiB in " << mipTime << " ms, " << double(baseBytes) / mipBytes << "x less traffic" << std::endl;
+	}
+
+	// Keeps the sampling loops from being optimized away
+	return checksum == 0 ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+// ReferenceTracer.cpp : Renders the planet scene with the CPU path tracer, as ground truth for the GPU output and as
+// a throughput benchmark. Writes the linear radiance as a PFM image and the tonemapped image as a PPM next to it,
+// and prints rays per second. The camera is the one Engine::updateUniformBuffers sets up, and the bodies are those
+// of addSceneBodies.
+//
+// Usage: ReferenceTracer <output.pfm> [width height samples] [--threads N]
+
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "../Engine/CpuTracer.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+static const char* USAGE = "Usage: ReferenceTracer <output.pfm> [width height samples] [--threads N]";
+
+int main(int argc, const char** argv)
+{
+	// An option where the output belongs, such as --help, must not become a file name
+	if (argc < 2 || argv[1][0] == '-')
+	{
+		bool help = argc >= 2 && (std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h");
+		(help ? std::cout : std::cerr) << USAGE << std::endl;
+		return help ? 0 : 1;
+	}
+
+	Solarium::CpuTraceSettings settings;
+	uint32_t threads = 0;
+	try
+	{
+		int positional = 0;
+		for (int i = 2; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+			else if (positional == 0) settings.width = std::stoul(arg), positional++;
+			else if (positional == 1) settings.height = std::stoul(arg), positional++;
+			else if (positional == 2) settings.samplesPerPixel = std::stoul(arg), positional++;
+			else
+			{
+				std::cerr << "Unknown option " << arg << std::endl;
+				return 1;
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		std::cerr << "Width, height, samples and thread count must be numbers" << std::endl;
+		return 1;
+	}
+	if (settings.width == 0 || settings.height == 0 || settings.samplesPerPixel == 0)
+	{
+		std::cerr << "Width, height and samples must be positive" << std::endl;
+		return 1;
+	}
+
+	glm::vec3 eye = glm::vec3(2.0f, 2.0f, 2.0f);
+	glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), settings.width / (float)settings.height, 0.1f, 10.0f);
+	proj[1][1] *= -1;
+	settings.inverseViewProj = glm::inverse(proj * view);
+	settings.cameraPosition = eye;
+
+	Solarium::Bvh bodies;
+	Solarium::addSceneBodies(bodies);
+	bodies.update();
+	settings.bodies = &bodies;
+
+	// A thread count of 1 traces on this thread alone
+	std::unique_ptr<Solarium::JobSystem> jobSystem;
+	if (threads != 1)
+	{
+		jobSystem = std::make_unique<Solarium::JobSystem>(threads == 0 ? 0 : threads - 1);
+	}
+	Solarium::CpuTracer tracer(jobSystem.get());
+	std::vector<glm::vec3> radiance;
+	Solarium::CpuTraceStats stats = tracer.render(settings, radiance);
+
+	std::cout << settings.width << "x" << settings.height << " at " << settings.samplesPerPixel << " spp on " << (jobSystem ? jobSystem->getWorkerCount() + 1 : 1) << " threads: "
+		<< stats.rays << " rays in " << stats.seconds << " s, " << stats.raysPerSecond() / 1e6 << " Mrays/s" << std::endl;
+
+	// PFM stores rows from the bottom up; a negative scale means little endian
+	std::ofstream pfm(argv[1], std::ios::binary);
+	if (!pfm.is_open())
+	{
+		std::cerr << "Failed to write " << argv[1] << std::endl;
+		return 1;
+	}
+	pfm << "PF\n" << settings.width << " " << settings.height << "\n-1.0\n";
+	for (uint32_t y = settings.height; y-- > 0;)
+	{
+		pfm.write(reinterpret_cast<const char*>(&radiance[static_cast<size_t>(y) * settings.width]), settings.width * sizeof(glm::vec3));
+	}
+
+	std::filesystem::path ppmPath = std::filesystem::path(argv[1]).replace_extension(".ppm");
+	std::ofstream ppm(ppmPath, std::ios::binary);
+	if (!ppm.is_open())
+	{
+		std::cerr << "Failed to write " << ppmPath.string() << std::endl;
+		return 1;
+	}
+	std::vector<uint8_t> pixels = Solarium::CpuTracer::tonemap(radiance);
+	ppm << "P6\n" << settings.width << " " << settings.height << "\n255\n";
+	ppm.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	return 0;
+}
@@ -0,0 +1,76 @@
+// TextureConverter.cpp : Offline tool that turns source images into block compressed KTX2 textures
+// with a full mip chain, ready to be uploaded by the engine without decoding.
+//
+// Usage: TextureConverter <input image> <output.ktx2> [bc1|bc3|bc5] [--linear]
+
+#include "../Engine/BlockCompression.hpp"
+#include "../Engine/ImageHelper.hpp"
+#include "../Engine/Ktx2.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, const char** argv)
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: TextureConverter <input image> <output.ktx2> [bc1|bc3|bc5] [--linear]" << std::endl;
+		return 1;
+	}
+
+	Solarium::BlockFormat format = Solarium::BlockFormat::BC1;
+	bool srgb = true;
+	for (int i = 3; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "bc1") format = Solarium::BlockFormat::BC1;
+		else if (arg == "bc3") format = Solarium::BlockFormat::BC3;
+		else if (arg == "bc5") format = Solarium::BlockFormat::BC5;
+		else if (arg == "--linear") srgb = false;
+		else
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			return 1;
+		}
+	}
+	// Two channel data is never color
+	if (format == Solarium::BlockFormat::BC5)
+	{
+		srgb = false;
+	}
+
+	int width, height, channels;
+	stbi_uc* pixels = stbi_load(argv[1], &width, &height, &channels, STBI_rgb_alpha);
+	if (!pixels)
+	{
+		std::cerr << "Failed to load " << argv[1] << std::endl;
+		return 1;
+	}
+
+	try
+	{
+		uint32_t mipLevels = Solarium::ImageHelper::mipLevelCount(width, height);
+		std::vector<size_t> levelOffsets;
+		std::vector<uint8_t> chain = Solarium::ImageHelper::generateMipChain(pixels, width, height, mipLevels, srgb, levelOffsets);
+		stbi_image_free(pixels);
+
+		std::vector<std::vector<uint8_t>> levels;
+		for (uint32_t level = 0; level < mipLevels; level++)
+		{
+			levels.push_back(Solarium::BlockCompression::compress(chain.data() + levelOffsets[level], Solarium::ImageHelper::mipExtent(width, level), Solarium::ImageHelper::mipExtent(height, level), format));
+		}
+
+		Solarium::Ktx2::write(argv[2], Solarium::BlockCompression::vkFormat(format, srgb), width, height, levels, Solarium::BlockCompression::dataFormatDescriptor(format, srgb), Solarium::BlockCompression::blockSize(format));
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Wrote " << argv[2] << std::endl;
+	return 0;
+}
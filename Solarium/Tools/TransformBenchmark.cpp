@@ -0,0 +1,205 @@
+// TransformBenchmark.cpp : Times the transform update Scene::updateTransforms runs, with plain glm math against
+// TransformMath on one thread and on the job system: local matrices, the world pass, and the MVP and normal matrices
+// written into interleaved per-instance data. Every eighth entity is a root and the seven after it are its
+// children, so the world pass multiplies like a shallow scene hierarchy.
+//
+// Usage: TransformBenchmark [entities...] [--threads N]
+
+#include "../Engine/TransformMath.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr int REPEATS = 10;
+static constexpr uint32_t GROUP_SIZE = 8;
+
+// The matrices of InstanceData, in its order
+struct Instance
+{
+	glm::mat4 model;
+	glm::mat4 mvp;
+	glm::mat4 normalMatrix;
+};
+
+// Best of REPEATS runs, in milliseconds
+static double timeBest(const std::function<void()>& run)
+{
+	double best = 1e30;
+	for (int repeat = 0; repeat < REPEATS; repeat++)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		run();
+		auto end = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	return best;
+}
+
+// World matrices from local ones, each child after its root as sortHierarchy orders them
+template<typename Multiply>
+static void propagate(const std::vector<glm::mat4>& local, std::vector<glm::mat4>& world, Multiply multiply)
+{
+	for (uint32_t i = 0; i < local.size(); i++)
+	{
+		if (i % GROUP_SIZE == 0)
+		{
+			world[i] = local[i];
+		}
+		else
+		{
+			multiply(world[i - i % GROUP_SIZE], local[i], world[i]);
+		}
+	}
+}
+
+// Equal to within float rounding, relative to the size of each element
+static bool matches(const glm::mat4& a, const glm::mat4& b)
+{
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			if (std::abs(a[column][row] - b[column][row]) > 1e-4f * std::max(1.0f, std::abs(b[column][row])))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool matches(const std::vector<Instance>& a, const std::vector<Instance>& b)
+{
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (!matches(a[i].model, b[i].model) || !matches(a[i].mvp, b[i].mvp) || !matches(a[i].normalMatrix, b[i].normalMatrix))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, const char** argv)
+{
+	std::vector<uint32_t> counts;
+	uint32_t threads = 0;
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+			else if (arg[0] != '-') counts.push_back(std::stoul(arg));
+			else
+			{
+				std::cerr << "Usage: TransformBenchmark [entities...] [--threads N]" << std::endl;
+				return 1;
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		std::cerr << "Entity and thread counts must be numbers" << std::endl;
+		return 1;
+	}
+	if (counts.empty())
+	{
+		counts = { 10000, 100000, 1000000 };
+	}
+
+	// A thread count of 1 runs on this thread alone
+	std::unique_ptr<Solarium::JobSystem> jobSystem;
+	if (threads != 1)
+	{
+		jobSystem = std::make_unique<Solarium::JobSystem>(threads == 0 ? 0 : threads - 1);
+	}
+	glm::mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+	glm::mat4 viewProj = proj * glm::lookAt(glm::vec3(20.0f, 20.0f, 20.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	bool allMatch = true;
+
+	for (uint32_t count : counts)
+	{
+		std::mt19937 random(1);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> size(0.5f, 2.0f);
+		std::vector<glm::vec3> positions(count);
+		std::vector<glm::quat> rotations(count);
+		std::vector<glm::vec3> scales(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			positions[i] = glm::vec3(unit(random), unit(random), unit(random)) * 10.0f;
+			rotations[i] = glm::normalize(glm::quat(unit(random), unit(random), unit(random), unit(random)));
+			scales[i] = glm::vec3(size(random), size(random), size(random));
+		}
+
+		std::vector<glm::mat4> local(count);
+		std::vector<glm::mat4> world(count);
+		std::vector<Instance> reference(count);
+		std::vector<Instance> instances(count);
+
+		// What the scene computed before TransformMath: three glm matrices multiplied per entity, then one instance
+		// after another
+		double referenceTime = timeBest([&]()
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				local[i] = glm::translate(glm::mat4(1.0f), positions[i]) * glm::mat4_cast(rotations[i]) * glm::scale(glm::mat4(1.0f), scales[i]);
+			}
+			propagate(local, world, [](const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& out) { out = lhs * rhs; });
+			for (uint32_t i = 0; i < count; i++)
+			{
+				reference[i].model = world[i];
+				reference[i].mvp = viewProj * world[i];
+				reference[i].normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(world[i]))));
+			}
+		});
+
+		auto transformMath = [&](Solarium::JobSystem* js)
+		{
+			Solarium::TransformMath::composeLocal(positions.data(), rotations.data(), scales.data(), local.data(), count, js);
+			propagate(local, world, [](const glm::mat4& lhs, const glm::mat4& rhs, glm::mat4& out) { Solarium::TransformMath::multiply(lhs, rhs, out); });
+			for (uint32_t i = 0; i < count; i++)
+			{
+				instances[i].model = world[i];
+			}
+			Solarium::TransformMath::computeMVP(viewProj, world.data(), &instances[0].mvp, count, js, sizeof(Instance));
+			Solarium::TransformMath::computeNormalMatrices(world.data(), &instances[0].normalMatrix, count, js, sizeof(Instance));
+		};
+		double singleTime = timeBest([&]() { transformMath(nullptr); });
+		allMatch &= matches(instances, reference);
+		double parallelTime = 0.0;
+		if (jobSystem)
+		{
+			parallelTime = timeBest([&]() { transformMath(jobSystem.get()); });
+			allMatch &= matches(instances, reference);
+		}
+
+		auto report = [&](const std::string& name, double milliseconds)
+		{
+			std::cout << "  " << name << ": " << milliseconds << " ms, " << count / milliseconds / 1e3 << " Mentities/s, " << referenceTime / milliseconds << "x" << std::endl;
+		};
+		std::cout << count << " entities" << std::endl;
+		report("glm", referenceTime);
+		report("TransformMath on 1 thread", singleTime);
+		if (jobSystem)
+		{
+			report("TransformMath on " + std::to_string(jobSystem->getWorkerCount() + 1) + " threads", parallelTime);
+		}
+	}
+
+	if (!allMatch)
+	{
+		std::cerr << "TransformMath disagrees with glm" << std::endl;
+		return 1;
+	}
+	return 0;
+}
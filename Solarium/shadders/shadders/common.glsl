@@ -67,7 +67,8 @@ float worley(vec3 coord){
 }
 
 // Fractal Brownian Motion (FBM) Worley Noise
-float fbmcyclic(vec3 coord, uint octaves){
+// Shaders/noise.glsl has these together with tileable versions and lookups into their baked textures
+float fbmworley(vec3 coord, uint octaves){
     float value = 0.0;
     float scale = 1.0;
     float atten = 0.5;
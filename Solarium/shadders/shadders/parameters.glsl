@@ -2,10 +2,6 @@
 // Image Gamma (sRGB uses 2.2)
 #define gamma 2.2
 
-// Maximum Ray-Tracing Bounces
-#define maxbounces 32U
-
-// Ray-Marching Parameters (for Ray-Tracing Distance Estimators)
-#define maxmarches 128U
-#define collisiondist 1e-4
-#define maxdist 32.0
\ No newline at end of file
+// Quality parameters are specialization constants, so the engine can switch quality tiers
+// without recompiling. Declared once in the engine's quality.glsl, with ids and defaults from quality.h.
+#include "../../Shaders/quality.glsl"
\ No newline at end of file